@@ -0,0 +1,308 @@
+#include "armcalibration.h"
+#include <QFile>
+#include <QRegularExpression>
+#include <QTextStream>
+#include <QtConcurrent>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+// 每个并行任务处理的样本数
+const int kTaskSize = 2048;
+// 数值雅可比的差分步长
+const double kStep = 1e-7;
+// 默认固定的参数：d3（paramsToVector中d[2]的下标）
+const int kFixedByDefault = 4 + 2;
+
+inline void crossAdd(const double a[3], const double b[3], double r[3])
+{
+    r[0] += a[1] * b[2] - a[2] * b[1];
+    r[1] += a[2] * b[0] - a[0] * b[2];
+    r[2] += a[0] * b[1] - a[1] * b[0];
+}
+
+// 对称正定矩阵的Cholesky分解求解 A*x = b，A不正定时返回false
+bool choleskySolve(double A[ArmCalibration::ParameterCount][ArmCalibration::ParameterCount],
+                   const double b[ArmCalibration::ParameterCount], double x[ArmCalibration::ParameterCount])
+{
+    const int n = ArmCalibration::ParameterCount;
+    double L[ArmCalibration::ParameterCount][ArmCalibration::ParameterCount] = {};
+    for (int i = 0; i < n; ++i) {
+        for (int j = 0; j <= i; ++j) {
+            double sum = A[i][j];
+            for (int k = 0; k < j; ++k) sum -= L[i][k] * L[j][k];
+            if (i == j) {
+                if (sum <= 0) return false;
+                L[i][i] = std::sqrt(sum);
+            } else {
+                L[i][j] = sum / L[j][j];
+            }
+        }
+    }
+    double y[ArmCalibration::ParameterCount];
+    for (int i = 0; i < n; ++i) {
+        double sum = b[i];
+        for (int k = 0; k < i; ++k) sum -= L[i][k] * y[k];
+        y[i] = sum / L[i][i];
+    }
+    for (int i = n - 1; i >= 0; --i) {
+        double sum = y[i];
+        for (int k = i + 1; k < n; ++k) sum -= L[k][i] * x[k];
+        x[i] = sum / L[i][i];
+    }
+    return true;
+}
+
+} // namespace
+
+ArmCalibration::ArmCalibration()
+    : orientationWeight(0.1)
+{
+    for (int i = 0; i < ParameterCount; ++i) {
+        fixed[i] = false;
+    }
+    // d2、d3不能分别辨识，见头文件说明
+    fixed[kFixedByDefault] = true;
+}
+
+void ArmCalibration::setSamples(const QVector<Sample> &samples)
+{
+    data = samples;
+}
+
+bool ArmCalibration::loadSamples(const QString &fileName, QString *error)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        if (error) *error = QString("无法打开文件：%1").arg(fileName);
+        return false;
+    }
+
+    QVector<Sample> loaded;
+    QTextStream in(&file);
+    const QRegularExpression separator("[,\\s]+");
+    int lineNumber = 0;
+    while (!in.atEnd()) {
+        const QString line = in.readLine().trimmed();
+        ++lineNumber;
+        if (line.isEmpty() || line.startsWith('#')) {
+            continue;
+        }
+        const QStringList fields = line.split(separator, Qt::SkipEmptyParts);
+        if (fields.size() != 16) {
+            if (error) *error = QString("第%1行应有16个数，实际%2个").arg(lineNumber).arg(fields.size());
+            return false;
+        }
+        double values[16];
+        for (int i = 0; i < 16; ++i) {
+            bool ok;
+            values[i] = fields[i].toDouble(&ok);
+            if (!ok) {
+                if (error) *error = QString("第%1行第%2个数无效").arg(lineNumber).arg(i + 1);
+                return false;
+            }
+        }
+        Sample sample;
+        std::memcpy(sample.q, values, sizeof(sample.q));
+        std::memcpy(sample.T, values + 4, 12 * sizeof(double));
+        sample.T[12] = 0;
+        sample.T[13] = 0;
+        sample.T[14] = 0;
+        sample.T[15] = 1;
+        loaded.append(sample);
+    }
+
+    data = loaded;
+    return true;
+}
+
+void ArmCalibration::setOrientationWeight(double weight)
+{
+    orientationWeight = weight;
+}
+
+void ArmCalibration::setParameterFixed(int index, bool isFixed)
+{
+    if (index >= 0 && index < ParameterCount) {
+        fixed[index] = isFixed;
+    }
+}
+
+void ArmCalibration::residual(const double params[ParameterCount], const Sample &sample, double r[6]) const
+{
+    ArmKinematics::MdhParams mdh;
+    ArmKinematics::vectorToParams(params, mdh);
+    double T[16];
+    ArmKinematics::forward(mdh, sample.q, T);
+
+    const double *M = sample.T;
+    r[0] = T[3] - M[3];
+    r[1] = T[7] - M[7];
+    r[2] = T[11] - M[11];
+
+    // 姿态误差：e = 0.5 * (n_m x n_p + o_m x o_p + a_m x a_p)，小角度时等于旋转向量
+    double e[3] = {0, 0, 0};
+    for (int c = 0; c < 3; ++c) {
+        const double measured[3] = {M[c], M[4 + c], M[8 + c]};
+        const double predicted[3] = {T[c], T[4 + c], T[8 + c]};
+        crossAdd(measured, predicted, e);
+    }
+    for (int i = 0; i < 3; ++i) {
+        r[3 + i] = 0.5 * orientationWeight * e[i];
+    }
+}
+
+void ArmCalibration::accumulate(const double params[ParameterCount], int begin, int end, bool withJacobian,
+                                Accumulator &acc) const
+{
+    std::memset(&acc, 0, sizeof(acc));
+    double perturbed[ParameterCount];
+    std::memcpy(perturbed, params, sizeof(perturbed));
+
+    for (int s = begin; s < end; ++s) {
+        const Sample &sample = data[s];
+        double r[6];
+        residual(params, sample, r);
+        acc.positionSq += r[0] * r[0] + r[1] * r[1] + r[2] * r[2];
+        acc.orientationSq += r[3] * r[3] + r[4] * r[4] + r[5] * r[5];
+        if (!withJacobian) {
+            continue;
+        }
+
+        // 前向差分求该样本的6x16雅可比，随即累加到正规方程中
+        double J[6][ParameterCount];
+        for (int p = 0; p < ParameterCount; ++p) {
+            if (fixed[p]) {
+                for (int i = 0; i < 6; ++i) J[i][p] = 0;
+                continue;
+            }
+            perturbed[p] = params[p] + kStep;
+            double rh[6];
+            residual(perturbed, sample, rh);
+            perturbed[p] = params[p];
+            for (int i = 0; i < 6; ++i) J[i][p] = (rh[i] - r[i]) / kStep;
+        }
+        for (int a = 0; a < ParameterCount; ++a) {
+            for (int i = 0; i < 6; ++i) {
+                acc.Jtr[a] += J[i][a] * r[i];
+            }
+            for (int b = a; b < ParameterCount; ++b) {
+                double sum = 0;
+                for (int i = 0; i < 6; ++i) sum += J[i][a] * J[i][b];
+                acc.JtJ[a][b] += sum;
+            }
+        }
+    }
+}
+
+void ArmCalibration::evaluate(const double params[ParameterCount], bool withJacobian, Accumulator &acc) const
+{
+    struct Task
+    {
+        int begin;
+        int end;
+        Accumulator acc;
+    };
+    QVector<Task> tasks;
+    for (int s = 0; s < data.size(); s += kTaskSize) {
+        Task task;
+        task.begin = s;
+        task.end = qMin(s + kTaskSize, data.size());
+        tasks.append(task);
+    }
+    QtConcurrent::blockingMap(tasks, [&](Task &task) {
+        accumulate(params, task.begin, task.end, withJacobian, task.acc);
+    });
+
+    // 按固定顺序归约，保证结果与线程调度无关
+    std::memset(&acc, 0, sizeof(acc));
+    for (const Task &task : tasks) {
+        acc.positionSq += task.acc.positionSq;
+        acc.orientationSq += task.acc.orientationSq;
+        if (!withJacobian) continue;
+        for (int a = 0; a < ParameterCount; ++a) {
+            acc.Jtr[a] += task.acc.Jtr[a];
+            for (int b = a; b < ParameterCount; ++b) acc.JtJ[a][b] += task.acc.JtJ[a][b];
+        }
+    }
+    for (int a = 0; a < ParameterCount; ++a) {
+        for (int b = 0; b < a; ++b) acc.JtJ[a][b] = acc.JtJ[b][a];
+    }
+}
+
+ArmCalibration::Result ArmCalibration::calibrate(const ArmKinematics::MdhParams &initial, int maxIterations) const
+{
+    Result result;
+    result.params = initial;
+    if (data.isEmpty()) {
+        return result;
+    }
+    const double n = data.size();
+
+    double params[ParameterCount];
+    ArmKinematics::paramsToVector(initial, params);
+
+    Accumulator acc;
+    evaluate(params, true, acc);
+    double cost = acc.positionSq + acc.orientationSq;
+    result.initialPositionRms = std::sqrt(acc.positionSq / n);
+
+    double lambda = 1e-3;
+    for (int iter = 0; iter < maxIterations; ++iter) {
+        result.iterations = iter + 1;
+
+        // (J^T*J + lambda*diag(J^T*J)) * delta = -J^T*r，固定参数对应的行列置为单位阵
+        double A[ParameterCount][ParameterCount];
+        double g[ParameterCount];
+        for (int a = 0; a < ParameterCount; ++a) {
+            for (int b = 0; b < ParameterCount; ++b) {
+                A[a][b] = (fixed[a] || fixed[b]) ? 0.0 : acc.JtJ[a][b];
+            }
+            A[a][a] = fixed[a] ? 1.0 : acc.JtJ[a][a] + lambda * qMax(acc.JtJ[a][a], 1e-9);
+            g[a] = fixed[a] ? 0.0 : -acc.Jtr[a];
+        }
+
+        double delta[ParameterCount];
+        if (!choleskySolve(A, g, delta)) {
+            lambda *= 10;
+            continue;
+        }
+
+        double candidate[ParameterCount];
+        double stepNorm = 0;
+        for (int p = 0; p < ParameterCount; ++p) {
+            candidate[p] = params[p] + delta[p];
+            stepNorm += delta[p] * delta[p];
+        }
+
+        Accumulator trial;
+        evaluate(candidate, false, trial);
+        const double trialCost = trial.positionSq + trial.orientationSq;
+        if (trialCost < cost) {
+            const double improvement = (cost - trialCost) / qMax(cost, 1e-30);
+            std::memcpy(params, candidate, sizeof(params));
+            cost = trialCost;
+            lambda = qMax(lambda / 3, 1e-12);
+            if (improvement < 1e-10 || std::sqrt(stepNorm) < 1e-12) {
+                result.converged = true;
+                acc = trial;
+                break;
+            }
+            evaluate(params, true, acc);
+        } else {
+            lambda *= 4;
+            if (lambda > 1e10) {
+                result.stalled = true; // 已无法继续下降，但收敛判据未满足
+                break;
+            }
+        }
+    }
+
+    ArmKinematics::vectorToParams(params, result.params);
+    Accumulator finalAcc;
+    evaluate(params, false, finalAcc);
+    result.finalPositionRms = std::sqrt(finalAcc.positionSq / n);
+    result.finalOrientationRms = std::sqrt(finalAcc.orientationSq / n) / qMax(orientationWeight, 1e-12);
+    return result;
+}
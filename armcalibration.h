@@ -0,0 +1,69 @@
+#ifndef ARMCALIBRATION_H
+#define ARMCALIBRATION_H
+
+#include "armkinematics.h"
+#include <QString>
+#include <QVector>
+
+// 运动学标定：由（关节角，激光跟踪仪测得的末端位姿）样本辨识MDH参数和关节零位偏置
+// 使用Levenberg-Marquardt迭代，残差和参数雅可比按分块并行计算，
+// 每块直接累加正规方程 J^T*J 和 J^T*r，不保存完整雅可比矩阵
+// 关节2、3的轴线平行（alpha2 = 0），d2与d3沿同一方向平移，只有二者之和可辨识，J^T*J沿d2-d3方向奇异；
+// 因此默认固定d3（下标6）为初值，其偏差由d2吸收，可用setParameterFixed(6, false)取消
+class ArmCalibration
+{
+public:
+    struct Sample
+    {
+        double q[4];
+        double T[16]; // 测得的末端位姿（行优先4x4，基坐标系）
+    };
+
+    struct Result
+    {
+        ArmKinematics::MdhParams params;
+        int iterations = 0;
+        double initialPositionRms = 0;   // 米
+        double finalPositionRms = 0;     // 米
+        double finalOrientationRms = 0;  // 弧度
+        bool converged = false;
+        bool stalled = false;            // 阻尼增大到上限仍无法下降，结果未收敛
+    };
+
+    enum { ParameterCount = 16 };
+
+    ArmCalibration();
+
+    void setSamples(const QVector<Sample> &samples);
+    const QVector<Sample> &samples() const { return data; }
+
+    // 读取测量文件：每行16个数，关节角q1..q4，随后为位姿矩阵前三行（r11 r12 r13 px r21 ... pz）
+    // 分隔符可为逗号或空白，'#'开头的行为注释
+    bool loadSamples(const QString &fileName, QString *error = nullptr);
+
+    // 姿态误差折算为长度的权重（米/弧度）
+    void setOrientationWeight(double weight);
+    // 固定不参与辨识的参数（下标顺序同ArmKinematics::paramsToVector），默认只固定d3
+    void setParameterFixed(int index, bool fixed);
+
+    Result calibrate(const ArmKinematics::MdhParams &initial, int maxIterations = 50) const;
+
+private:
+    struct Accumulator
+    {
+        double JtJ[ParameterCount][ParameterCount];
+        double Jtr[ParameterCount];
+        double positionSq;
+        double orientationSq;
+    };
+
+    void accumulate(const double params[ParameterCount], int begin, int end, bool withJacobian, Accumulator &acc) const;
+    void evaluate(const double params[ParameterCount], bool withJacobian, Accumulator &acc) const;
+    void residual(const double params[ParameterCount], const Sample &sample, double r[6]) const;
+
+    QVector<Sample> data;
+    double orientationWeight;
+    bool fixed[ParameterCount];
+};
+
+#endif // ARMCALIBRATION_H
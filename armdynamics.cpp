@@ -0,0 +1,204 @@
+#include "armdynamics.h"
+#include <QtConcurrent>
+#include <cmath>
+
+namespace {
+
+// 每个并行任务处理的采样点数
+const int kTaskSize = 4096;
+
+inline void cross(const double a[3], const double b[3], double r[3])
+{
+    r[0] = a[1] * b[2] - a[2] * b[1];
+    r[1] = a[2] * b[0] - a[0] * b[2];
+    r[2] = a[0] * b[1] - a[1] * b[0];
+}
+
+// r = R * v（子坐标系到父坐标系）
+inline void rotate(const double R[9], const double v[3], double r[3])
+{
+    r[0] = R[0] * v[0] + R[1] * v[1] + R[2] * v[2];
+    r[1] = R[3] * v[0] + R[4] * v[1] + R[5] * v[2];
+    r[2] = R[6] * v[0] + R[7] * v[1] + R[8] * v[2];
+}
+
+// r = R^T * v（父坐标系到子坐标系）
+inline void rotateInverse(const double R[9], const double v[3], double r[3])
+{
+    r[0] = R[0] * v[0] + R[3] * v[1] + R[6] * v[2];
+    r[1] = R[1] * v[0] + R[4] * v[1] + R[7] * v[2];
+    r[2] = R[2] * v[0] + R[5] * v[1] + R[8] * v[2];
+}
+
+// 对称惯性张量乘向量
+inline void inertiaTimes(const double I[6], const double v[3], double r[3])
+{
+    r[0] = I[0] * v[0] + I[3] * v[1] + I[4] * v[2];
+    r[1] = I[3] * v[0] + I[1] * v[1] + I[5] * v[2];
+    r[2] = I[4] * v[0] + I[5] * v[1] + I[2] * v[2];
+}
+
+} // namespace
+
+ArmDynamics::ArmDynamics()
+{
+    setKinematics(ArmKinematics::activeParams());
+
+    const double gravity[3] = {0, 0, -9.81};
+    setGravity(gravity);
+
+    // 默认惯性参数为按连杆尺寸估算的值，电机选型前应替换为CAD或辨识结果
+    links[0] = {20.0, {0.0, 0.0, 0.0}, {0.30, 0.30, 0.20, 0, 0, 0}};       // 底座转台
+    links[1] = {15.0, {0.575, 0.0, 0.0}, {0.05, 1.70, 1.70, 0, 0, 0}};     // 大臂，a2 = 1.150
+    links[2] = {10.0, {0.15, 0.6125, 0.0}, {1.30, 0.10, 1.30, 0, 0, 0}};   // 小臂，a3 = 0.300，d4 = 1.225
+    links[3] = {3.0, {0.0, 0.0, 0.05}, {0.01, 0.01, 0.005, 0, 0, 0}};      // 末端磨抛工具
+}
+
+void ArmDynamics::setKinematics(const ArmKinematics::MdhParams &params)
+{
+    for (int i = 0; i < 4; ++i) {
+        cosAlpha[i] = std::cos(params.alpha[i]);
+        sinAlpha[i] = std::sin(params.alpha[i]);
+        offset[i] = params.offset[i];
+        // 与MDH变换矩阵的平移列一致：(a, -d*sin(alpha), d*cos(alpha))
+        origin[i][0] = params.a[i];
+        origin[i][1] = -params.d[i] * sinAlpha[i];
+        origin[i][2] = params.d[i] * cosAlpha[i];
+    }
+}
+
+void ArmDynamics::setLinkInertia(int link, const LinkInertia &inertia)
+{
+    if (link >= 0 && link < 4) {
+        links[link] = inertia;
+    }
+}
+
+void ArmDynamics::setGravity(const double gravity[3])
+{
+    for (int i = 0; i < 3; ++i) {
+        baseAcceleration[i] = -gravity[i];
+    }
+}
+
+void ArmDynamics::inverseDynamics(const double q[4], const double qd[4], const double qdd[4], double tau[4]) const
+{
+    computeBlock(q, qd, qdd, 1, tau);
+}
+
+void ArmDynamics::computeBlock(const double *q, const double *qd, const double *qdd, int count, double *tau) const
+{
+    for (int s = 0; s < count; ++s) {
+        const double *qs = q + 4 * s;
+        const double *qds = qd + 4 * s;
+        const double *qdds = qdd + 4 * s;
+
+        double R[4][9];   // 第i个关节坐标系相对前一坐标系的旋转
+        double F[4][3];   // 连杆惯性力
+        double N[4][3];   // 连杆惯性力矩
+        double w[3] = {0, 0, 0};
+        double wd[3] = {0, 0, 0};
+        double vd[3] = {baseAcceleration[0], baseAcceleration[1], baseAcceleration[2]};
+
+        // 外推：由基座向末端计算各连杆的角速度、角加速度和线加速度
+        for (int i = 0; i < 4; ++i) {
+            const double theta = qs[i] + offset[i];
+            const double ct = std::cos(theta), st = std::sin(theta);
+            const double ca = cosAlpha[i], sa = sinAlpha[i];
+            double *Ri = R[i];
+            Ri[0] = ct;      Ri[1] = -st;     Ri[2] = 0;
+            Ri[3] = ca * st; Ri[4] = ca * ct; Ri[5] = -sa;
+            Ri[6] = sa * st; Ri[7] = sa * ct; Ri[8] = ca;
+
+            const double *P = origin[i];
+            double t1[3], t2[3], tmp[3];
+            cross(wd, P, t1);
+            cross(w, P, t2);
+            cross(w, t2, tmp);
+            for (int k = 0; k < 3; ++k) tmp[k] += t1[k] + vd[k];
+            double vdi[3];
+            rotateInverse(Ri, tmp, vdi);
+
+            double wr[3], wdr[3];
+            rotateInverse(Ri, w, wr);
+            rotateInverse(Ri, wd, wdr);
+            const double wi[3] = {wr[0], wr[1], wr[2] + qds[i]};
+            // wd_i = R^T*wd + (R^T*w) x (qd*z) + qdd*z
+            const double wdi[3] = {wdr[0] + wr[1] * qds[i], wdr[1] - wr[0] * qds[i], wdr[2] + qdds[i]};
+
+            const LinkInertia &link = links[i];
+            double vc[3];
+            cross(wdi, link.com, t1);
+            cross(wi, link.com, t2);
+            cross(wi, t2, vc);
+            for (int k = 0; k < 3; ++k) {
+                vc[k] += t1[k] + vdi[k];
+                F[i][k] = link.mass * vc[k];
+            }
+            double Iw[3], Iwd[3], gyro[3];
+            inertiaTimes(link.inertia, wi, Iw);
+            inertiaTimes(link.inertia, wdi, Iwd);
+            cross(wi, Iw, gyro);
+            for (int k = 0; k < 3; ++k) {
+                N[i][k] = Iwd[k] + gyro[k];
+            }
+
+            for (int k = 0; k < 3; ++k) {
+                w[k] = wi[k];
+                wd[k] = wdi[k];
+                vd[k] = vdi[k];
+            }
+        }
+
+        // 内推：由末端向基座累加力和力矩，取z分量得到关节力矩
+        double f[3] = {0, 0, 0};
+        double n[3] = {0, 0, 0};
+        for (int i = 3; i >= 0; --i) {
+            double fr[3] = {0, 0, 0};
+            double nr[3] = {0, 0, 0};
+            double pf[3] = {0, 0, 0};
+            if (i < 3) {
+                rotate(R[i + 1], f, fr);
+                rotate(R[i + 1], n, nr);
+                cross(origin[i + 1], fr, pf);
+            }
+            double cf[3];
+            cross(links[i].com, F[i], cf);
+            for (int k = 0; k < 3; ++k) {
+                f[k] = fr[k] + F[i][k];
+                n[k] = N[i][k] + nr[k] + cf[k] + pf[k];
+            }
+            tau[4 * s + i] = n[2];
+        }
+    }
+}
+
+void ArmDynamics::inverseDynamicsBatch(const double *q, const double *qd, const double *qdd, int count, double *tau) const
+{
+    if (count <= kTaskSize) {
+        computeBlock(q, qd, qdd, count, tau);
+        return;
+    }
+    QVector<int> starts;
+    for (int s = 0; s < count; s += kTaskSize) {
+        starts.append(s);
+    }
+    QtConcurrent::blockingMap(starts, [=](int start) {
+        const int offset4 = 4 * start;
+        computeBlock(q + offset4, qd + offset4, qdd + offset4, qMin(kTaskSize, count - start), tau + offset4);
+    });
+}
+
+QVector<int> ArmDynamics::findOverloads(const double *tau, int count, const double limit[4])
+{
+    QVector<int> samples;
+    for (int s = 0; s < count; ++s) {
+        for (int i = 0; i < 4; ++i) {
+            if (std::fabs(tau[4 * s + i]) > limit[i]) {
+                samples.append(s);
+                break;
+            }
+        }
+    }
+    return samples;
+}
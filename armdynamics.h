@@ -0,0 +1,49 @@
+#ifndef ARMDYNAMICS_H
+#define ARMDYNAMICS_H
+
+#include "armkinematics.h"
+#include <QVector>
+
+// 逆动力学：基于与ArmKinematics::jointFrames相同的MDH链（参数见setKinematics，默认为activeParams），用递推牛顿-欧拉法(RNEA)计算关节力矩
+// 单点计算无堆分配，轨迹批量计算按分块并行
+class ArmDynamics
+{
+public:
+    // 连杆惯性参数，均在该连杆的MDH坐标系下表示
+    struct LinkInertia
+    {
+        double mass;        // kg
+        double com[3];      // 质心位置（米）
+        double inertia[6];  // 关于质心的惯性张量 Ixx, Iyy, Izz, Ixy, Ixz, Iyz（kg*m^2）
+    };
+
+    ArmDynamics();
+
+    void setKinematics(const ArmKinematics::MdhParams &params);
+    void setLinkInertia(int link, const LinkInertia &inertia);
+    const LinkInertia &linkInertia(int link) const { return links[link]; }
+    // 重力加速度向量（基坐标系），默认(0, 0, -9.81)
+    void setGravity(const double gravity[3]);
+
+    // 单点逆动力学：tau = M(q)*qdd + C(q,qd)*qd + G(q)
+    void inverseDynamics(const double q[4], const double qd[4], const double qdd[4], double tau[4]) const;
+
+    // 批量逆动力学，各数组按每4个关节连续存储，count为采样点数，多线程分块计算
+    void inverseDynamicsBatch(const double *q, const double *qd, const double *qdd, int count, double *tau) const;
+
+    // 找出力矩超过limit的采样点序号
+    static QVector<int> findOverloads(const double *tau, int count, const double limit[4]);
+
+private:
+    void computeBlock(const double *q, const double *qd, const double *qdd, int count, double *tau) const;
+
+    // 各关节与θ无关的常量：cos(alpha)、sin(alpha)、相对前一坐标系的平移
+    double cosAlpha[4];
+    double sinAlpha[4];
+    double offset[4];
+    double origin[4][3];
+    LinkInertia links[4];
+    double baseAcceleration[3]; // 用 -g 作为基座加速度来计入重力
+};
+
+#endif // ARMDYNAMICS_H
@@ -0,0 +1,415 @@
+#include "armkinematics.h"
+#include "metrics.h"
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QtGlobal>
+#include <algorithm>
+#include <cmath>
+
+namespace ArmKinematics {
+
+const double jointMin[4] = {-180 * M_PI / 180, -60 * M_PI / 180, -147 * M_PI / 180, -210 * M_PI / 180};
+const double jointMax[4] = { 180 * M_PI / 180,  76 * M_PI / 180,   90 * M_PI / 180,  210 * M_PI / 180};
+
+const MdhParams &nominalParams()
+{
+    static const MdhParams params = {
+        {0, 0, 0, 0},                 // theta偏置
+        {0, 0, 0, 1.225},             // d_i
+        {0, 0.325, 1.150, 0.300},     // a_i
+        {0, -M_PI/2, 0, -M_PI/2}      // alpha_i
+    };
+    return params;
+}
+
+static MdhParams &activeStorage()
+{
+    static MdhParams params = nominalParams();
+    return params;
+}
+
+const MdhParams &activeParams()
+{
+    return activeStorage();
+}
+
+void setActiveParams(const MdhParams &params)
+{
+    activeStorage() = params;
+}
+
+void paramsToVector(const MdhParams &params, double v[16])
+{
+    for (int i = 0; i < 4; ++i) {
+        v[i] = params.offset[i];
+        v[4 + i] = params.d[i];
+        v[8 + i] = params.a[i];
+        v[12 + i] = params.alpha[i];
+    }
+}
+
+void vectorToParams(const double v[16], MdhParams &params)
+{
+    for (int i = 0; i < 4; ++i) {
+        params.offset[i] = v[i];
+        params.d[i] = v[4 + i];
+        params.a[i] = v[8 + i];
+        params.alpha[i] = v[12 + i];
+    }
+}
+
+static QJsonArray toJsonArray(const double values[4])
+{
+    QJsonArray array;
+    for (int i = 0; i < 4; ++i) {
+        array.append(values[i]);
+    }
+    return array;
+}
+
+static bool fromJsonArray(const QJsonValue &value, double out[4])
+{
+    const QJsonArray array = value.toArray();
+    if (array.size() != 4) {
+        return false;
+    }
+    for (int i = 0; i < 4; ++i) {
+        out[i] = array.at(i).toDouble();
+    }
+    return true;
+}
+
+bool loadParams(const QString &fileName, MdhParams &params)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    const QJsonObject root = QJsonDocument::fromJson(file.readAll()).object();
+    MdhParams loaded;
+    if (!fromJsonArray(root.value("offset"), loaded.offset) || !fromJsonArray(root.value("d"), loaded.d)
+        || !fromJsonArray(root.value("a"), loaded.a) || !fromJsonArray(root.value("alpha"), loaded.alpha)) {
+        return false;
+    }
+    params = loaded;
+    return true;
+}
+
+bool saveParams(const QString &fileName, const MdhParams &params)
+{
+    QJsonObject root;
+    root.insert("offset", toJsonArray(params.offset));
+    root.insert("d", toJsonArray(params.d));
+    root.insert("a", toJsonArray(params.a));
+    root.insert("alpha", toJsonArray(params.alpha));
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    return file.write(QJsonDocument(root).toJson()) > 0;
+}
+
+// 单个MDH变换矩阵（行优先），公式与myfkine中T01..T34一致
+static inline void mdhTransform(double theta, double d, double a, double alpha, double T[16])
+{
+    const double ct = std::cos(theta), st = std::sin(theta);
+    const double ca = std::cos(alpha), sa = std::sin(alpha);
+    T[0] = ct;      T[1] = -st;     T[2] = 0;    T[3] = a;
+    T[4] = ca * st; T[5] = ca * ct; T[6] = -sa;  T[7] = -d * sa;
+    T[8] = sa * st; T[9] = sa * ct; T[10] = ca;  T[11] = d * ca;
+    T[12] = 0;      T[13] = 0;      T[14] = 0;   T[15] = 1;
+}
+
+// 齐次矩阵相乘（最后一行恒为0 0 0 1，省略其计算）
+static inline void multiplyRigid(const double A[16], const double B[16], double C[16])
+{
+    for (int i = 0; i < 3; ++i) {
+        const double a0 = A[i * 4], a1 = A[i * 4 + 1], a2 = A[i * 4 + 2], a3 = A[i * 4 + 3];
+        C[i * 4 + 0] = a0 * B[0] + a1 * B[4] + a2 * B[8];
+        C[i * 4 + 1] = a0 * B[1] + a1 * B[5] + a2 * B[9];
+        C[i * 4 + 2] = a0 * B[2] + a1 * B[6] + a2 * B[10];
+        C[i * 4 + 3] = a0 * B[3] + a1 * B[7] + a2 * B[11] + a3;
+    }
+    C[12] = 0; C[13] = 0; C[14] = 0; C[15] = 1;
+}
+
+void jointFrames(const MdhParams &params, const double q[4], double frames[4][16])
+{
+    mdhTransform(q[0] + params.offset[0], params.d[0], params.a[0], params.alpha[0], frames[0]);
+    for (int i = 1; i < 4; ++i) {
+        double Ti[16];
+        mdhTransform(q[i] + params.offset[i], params.d[i], params.a[i], params.alpha[i], Ti);
+        multiplyRigid(frames[i - 1], Ti, frames[i]);
+    }
+}
+
+void jointFrames(const double q[4], double frames[4][16])
+{
+    jointFrames(activeParams(), q, frames);
+}
+
+void forward(const MdhParams &params, const double q[4], double T[16])
+{
+    double frames[4][16];
+    jointFrames(params, q, frames);
+    for (int i = 0; i < 16; ++i) {
+        T[i] = frames[3][i];
+    }
+}
+
+void forward(const double q[4], double T[16])
+{
+    forward(activeParams(), q, T);
+}
+
+// 按[lo, hi]截断，被截断时置位
+static inline double clampJoint(double value, double lo, double hi, bool &clamped)
+{
+    const double bounded = qBound(lo, value, hi);
+    if (bounded != value) {
+        clamped = true;
+    }
+    return bounded;
+}
+
+// 解析公式假定的结构：d2 = d3 = 0，alpha1..alpha3与名义值相同；其余参数（偏置、基座alpha0/a0/d0、各杆长）可直接代入公式
+static bool matchesClosedForm(const MdhParams &p)
+{
+    const MdhParams &n = nominalParams();
+    const double eps = 1e-12;
+    return std::fabs(p.d[1]) < eps && std::fabs(p.d[2]) < eps && std::fabs(p.alpha[1] - n.alpha[1]) < eps
+           && std::fabs(p.alpha[2] - n.alpha[2]) < eps && std::fabs(p.alpha[3] - n.alpha[3]) < eps;
+}
+
+static bool solve3(double A[3][3], const double b[3], double x[3])
+{
+    const double det = A[0][0] * (A[1][1] * A[2][2] - A[1][2] * A[2][1]) - A[0][1] * (A[1][0] * A[2][2] - A[1][2] * A[2][0])
+                       + A[0][2] * (A[1][0] * A[2][1] - A[1][1] * A[2][0]);
+    if (std::fabs(det) < 1e-30) {
+        return false;
+    }
+    for (int i = 0; i < 3; ++i) {
+        double M[3][3];
+        for (int r = 0; r < 3; ++r) {
+            for (int c = 0; c < 3; ++c) {
+                M[r][c] = c == i ? b[r] : A[r][c];
+            }
+        }
+        x[i] = (M[0][0] * (M[1][1] * M[2][2] - M[1][2] * M[2][1]) - M[0][1] * (M[1][0] * M[2][2] - M[1][2] * M[2][0])
+                + M[0][2] * (M[1][0] * M[2][1] - M[1][1] * M[2][0])) / det;
+    }
+    return true;
+}
+
+// 末端位置相对目标的残差
+static double positionResidual(const MdhParams &params, const double q[4], const double T[16], double frames[4][16], double r[3])
+{
+    jointFrames(params, q, frames);
+    const double *F = frames[3];
+    r[0] = F[3] - T[3];
+    r[1] = F[7] - T[7];
+    r[2] = F[11] - T[11];
+    return std::sqrt(r[0] * r[0] + r[1] * r[1] + r[2] * r[2]);
+}
+
+// 参数不满足解析公式的结构时（如标定后的alpha、d），以公式的解为初值，按参数的正解对关节1..3做阻尼牛顿迭代
+// 只修正末端位置：接近方向由关节1..3唯一确定，标定后的参数一般无法同时精确满足，方向误差留给调用方按各自的容差判断
+// 返回是否收敛；不收敛时q为迭代中误差最小的值
+static bool refineSolution(const MdhParams &params, const double T[16], double q[4])
+{
+    double frames[4][16], r[3];
+    double err = positionResidual(params, q, T, frames, r);
+    double lambda = 1e-9;
+    for (int iter = 0; iter < 30 && err > 1e-12; ++iter) {
+        // 标定偏差只有毫米级，好的初值几步内二次收敛；几步后误差仍大的是不可达分支，不再浪费迭代
+        if (iter == 10 && err > 1e-2) {
+            break;
+        }
+        const double *E = frames[3];
+        const double pe[3] = {E[3], E[7], E[11]};
+        double J[3][3];
+        for (int j = 0; j < 3; ++j) {
+            const double *F = frames[j];
+            const double z[3] = {F[2], F[6], F[10]};
+            const double d[3] = {pe[0] - F[3], pe[1] - F[7], pe[2] - F[11]};
+            J[0][j] = z[1] * d[2] - z[2] * d[1];
+            J[1][j] = z[2] * d[0] - z[0] * d[2];
+            J[2][j] = z[0] * d[1] - z[1] * d[0];
+        }
+        // (JᵀJ + λI)δ = -Jᵀr，λ只在奇异位形附近起作用
+        double A[3][3], g[3], delta[3];
+        for (int a = 0; a < 3; ++a) {
+            g[a] = -(J[0][a] * r[0] + J[1][a] * r[1] + J[2][a] * r[2]);
+            for (int b = 0; b < 3; ++b) {
+                A[a][b] = J[0][a] * J[0][b] + J[1][a] * J[1][b] + J[2][a] * J[2][b];
+            }
+            A[a][a] += lambda;
+        }
+        if (!solve3(A, g, delta)) {
+            break;
+        }
+        double qNew[4] = {q[0], q[1], q[2], q[3]};
+        // 关节1的限位是整圈，越过±180°时折回而不是截断
+        qNew[0] = std::remainder(q[0] + delta[0], 2 * M_PI);
+        for (int j = 1; j < 3; ++j) {
+            qNew[j] = qBound(jointMin[j], q[j] + delta[j], jointMax[j]);
+        }
+        double framesNew[4][16], rNew[3];
+        const double errNew = positionResidual(params, qNew, T, framesNew, rNew);
+        if (errNew < err) {
+            std::copy(qNew, qNew + 4, q);
+            std::copy(rNew, rNew + 3, r);
+            std::copy(&framesNew[0][0], &framesNew[0][0] + 4 * 16, &frames[0][0]);
+            err = errNew;
+            lambda = qMax(lambda * 0.1, 1e-12);
+        } else {
+            lambda *= 10;
+            if (lambda > 1e6) break;
+        }
+    }
+
+    return err < 1e-9;
+}
+
+// 关节4绕自身z轴转动，不影响末端位置和接近方向：关节1..3确定后，取目标x轴在关节4为0时的末端坐标系中绕z轴的转角
+static double wristAngle(const MdhParams &params, const double T[16], const double q[4])
+{
+    const double q0[4] = {q[0], q[1], q[2], 0.0};
+    double frames[4][16];
+    jointFrames(params, q0, frames);
+    const double *F = frames[3];
+    const double c = F[0] * T[0] + F[4] * T[4] + F[8] * T[8];
+    const double s = F[1] * T[0] + F[5] * T[4] + F[9] * T[8];
+    return std::atan2(s, c);
+}
+
+void inverse(const MdhParams &params, const double T[16], double solutions[8][4], unsigned *clampedMask)
+{
+    // 公式按T01 = RotZ(theta1)推导，而MDH下T01 = RotX(alpha0)*TransX(a0)*TransZ(d0)*RotZ(theta1)：
+    // 先把目标位姿变换到去掉基座部分后的坐标系中
+    double base[16], baseInv[16], local[16];
+    mdhTransform(0, params.d[0], params.a[0], params.alpha[0], base);
+    for (int i = 0; i < 3; ++i) {
+        for (int j = 0; j < 3; ++j) {
+            baseInv[i * 4 + j] = base[j * 4 + i];
+        }
+        baseInv[i * 4 + 3] = -(base[i] * base[3] + base[4 + i] * base[7] + base[8 + i] * base[11]);
+    }
+    baseInv[12] = 0; baseInv[13] = 0; baseInv[14] = 0; baseInv[15] = 1;
+    multiplyRigid(baseInv, T, local);
+
+    const double px = local[3], py = local[7], pz = local[11];
+
+    const double d4 = params.d[3], d2 = 0, d3 = 0;
+    const double a1 = params.a[1], a2 = params.a[2], a3 = params.a[3];
+    const double f1 = -M_PI / 2, f3 = -M_PI / 2;
+    const double sf1 = std::sin(f1), sf3 = std::sin(f3);
+    const double *offset = params.offset;
+    const bool exact = matchesClosedForm(params);
+
+    unsigned mask = 0;
+    // 解的下标 = t1分支*4 + t3分支*2 + 关节4分支，正号分支在前
+    // 公式中的t_i为MDH转角，关节角 = t_i - offset_i，限位按关节角判断
+    for (int b1 = 0; b1 < 2; ++b1) {
+        bool clamped1 = false;
+        const double r1 = std::sqrt(std::pow(px * sf1, 2) + std::pow(py * sf1, 2) - std::pow(d2 - d3, 2));
+        // 两个atan2之和可能超出±180°，关节1的限位正好一周，先折回到限位内再截断
+        const double q1 = clampJoint(std::remainder(-std::atan2(-py, px) + std::atan2((d2 - d3) / sf1, b1 == 0 ? r1 : -r1)
+                                                        - offset[0],
+                                                    2 * M_PI),
+                                     jointMin[0], jointMax[0], clamped1);
+        const double t1 = q1 + offset[0];
+        const double c1 = std::cos(t1), s1 = std::sin(t1);
+        const double m3 = pz * sf1;
+        const double n3 = a1 - px * c1 - py * s1;
+        const double k3 = std::pow(m3, 2) + std::pow(n3, 2) - a2 * a2 - a3 * a3 - d4 * d4;
+        const double r3 = std::sqrt(std::pow(2 * a2 * d4 * sf3, 2) + std::pow(2 * a2 * a3, 2) - std::pow(k3, 2));
+
+        for (int b3 = 0; b3 < 2; ++b3) {
+            bool clamped3 = clamped1;
+            const double q3 = clampJoint(-std::atan2(a2 * a3 / sf3, a2 * d4) + std::atan2(k3 / sf3, b3 == 0 ? r3 : -r3) - offset[2],
+                                         jointMin[2], jointMax[2], clamped3);
+            const double t3 = q3 + offset[2];
+            const double c3 = std::cos(t3), s3 = std::sin(t3);
+            const double m2 = a2 + a3 * c3 + d4 * sf3 * s3;
+            const double n2 = a3 * s3 - d4 * sf3 * c3;
+            const double q2 = clampJoint(std::atan2(m3 * m2 + n2 * n3, m3 * n2 - m2 * n3) - offset[1],
+                                         jointMin[1], jointMax[1], clamped3);
+
+            // 迭代修正时公式的解只是初值，是否截断以迭代能否在限位内收敛为准
+            double q[4] = {q1, q2, q3, 0.0};
+            bool invalid = clamped3;
+            if (!exact) {
+                invalid = !(std::isfinite(q1) && std::isfinite(q2) && std::isfinite(q3) && refineSolution(params, T, q));
+            }
+            q[3] = wristAngle(params, T, q);
+            // 关节4的第二个分支与第一个相差180°：末端位置和接近方向相同，x轴反向
+            for (int b4 = 0; b4 < 2; ++b4) {
+                const int k = b1 * 4 + b3 * 2 + b4;
+                solutions[k][0] = q[0];
+                solutions[k][1] = q[1];
+                solutions[k][2] = q[2];
+                solutions[k][3] = b4 == 0 ? q[3] : std::remainder(q[3] + M_PI, 2 * M_PI);
+                if (invalid) {
+                    mask |= 1u << k;
+                }
+            }
+        }
+    }
+    if (clampedMask) {
+        *clampedMask = mask;
+    }
+
+    // 截断率 = 被截断的解 / (8 * 调用次数)
+    static Metrics::Counter *calls = Metrics::counter("arm_ik_inverse_total", "解析逆解调用次数");
+    static Metrics::Counter *clamped = Metrics::counter("arm_ik_solutions_clamped_total",
+                                                       "解析逆解中关节角被限位截断的解的个数（每次调用8组解）");
+    calls->add();
+    if (mask) {
+        clamped->add(qPopulationCount(mask));
+    }
+}
+
+void inverse(const double T[16], double solutions[8][4], unsigned *clampedMask)
+{
+    inverse(activeParams(), T, solutions, clampedMask);
+}
+
+void jacobian(const MdhParams &params, const double q[4], double J[6][4])
+{
+    double frames[4][16];
+    jointFrames(params, q, frames);
+    const double pe[3] = {frames[3][3], frames[3][7], frames[3][11]};
+    for (int i = 0; i < 4; ++i) {
+        // MDH下关节i绕第i个坐标系的z轴转动
+        const double *F = frames[i];
+        const double z[3] = {F[2], F[6], F[10]};
+        const double r[3] = {pe[0] - F[3], pe[1] - F[7], pe[2] - F[11]};
+        J[0][i] = z[1] * r[2] - z[2] * r[1];
+        J[1][i] = z[2] * r[0] - z[0] * r[2];
+        J[2][i] = z[0] * r[1] - z[1] * r[0];
+        J[3][i] = z[0];
+        J[4][i] = z[1];
+        J[5][i] = z[2];
+    }
+}
+
+void jacobian(const double q[4], double J[6][4])
+{
+    jacobian(activeParams(), q, J);
+}
+
+bool withinLimits(const double q[4])
+{
+    for (int i = 0; i < 4; ++i) {
+        if (q[i] < jointMin[i] || q[i] > jointMax[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace ArmKinematics
@@ -0,0 +1,69 @@
+#ifndef ARMKINEMATICS_H
+#define ARMKINEMATICS_H
+
+#include <QString>
+
+// 4自由度机械臂运动学的无堆分配实现
+// MDH参数和解析逆解取自原MATLAB代码（myfkine/mymodikine），
+// 供碰撞检测、路径规划等需要高频调用正解的模块使用
+namespace ArmKinematics {
+
+// MDH参数：第i个关节的 theta偏置、d_i、a_i、alpha_i
+struct MdhParams
+{
+    double offset[4];
+    double d[4];
+    double a[4];
+    double alpha[4];
+};
+
+// 关节限位（弧度），与mymodikine中的限位表一致
+extern const double jointMin[4];
+extern const double jointMax[4];
+
+// 名义MDH参数（myfkine中硬编码的数值）
+const MdhParams &nominalParams();
+
+// 当前使用的MDH参数，默认为名义值，可替换为标定结果
+// 只应在启动时设置，运行中各线程只读
+const MdhParams &activeParams();
+void setActiveParams(const MdhParams &params);
+
+// 模型文件（JSON）读写，格式见ArmCalibration
+bool loadParams(const QString &fileName, MdhParams &params);
+bool saveParams(const QString &fileName, const MdhParams &params);
+
+// 参数与长度为16的向量互相转换，顺序为 offset[4], d[4], a[4], alpha[4]
+void paramsToVector(const MdhParams &params, double v[16]);
+void vectorToParams(const double v[16], MdhParams &params);
+
+// 计算T01..T04，frames[i]为行优先存储的4x4矩阵（不带参数的重载使用activeParams）
+void jointFrames(const MdhParams &params, const double q[4], double frames[4][16]);
+void jointFrames(const double q[4], double frames[4][16]);
+
+// 计算末端位姿T04（行优先4x4）
+void forward(const MdhParams &params, const double q[4], double T[16]);
+void forward(const double q[4], double T[16]);
+
+// 解析逆解：关节1..3沿用mymodikine的公式和解的排列顺序，关节1先折回±180°内再判断限位；
+// 关节4由目标x轴确定，下标为奇数的解关节4再转180°（末端位置和接近方向相同，x轴反向，见flippedWristMask）
+// 偏置、基座和杆长直接代入公式；d2、d3或alpha1..alpha3偏离名义结构时（如标定结果），
+// 以公式的解为初值按params的正解迭代修正末端位置。4自由度的臂不能任意指定接近方向，
+// 目标不是由forward得到时接近方向和x轴一般都有偏差，由调用方按各自的容差判断
+// solutions[k]为第k组解；clampedMask（可为空）的第k位表示该组解有关节角被限位截断（位置迭代不收敛的解同样置位）
+void inverse(const MdhParams &params, const double T[16], double solutions[8][4], unsigned *clampedMask = nullptr);
+void inverse(const double T[16], double solutions[8][4], unsigned *clampedMask = nullptr);
+
+// 逆解中x轴与目标相反的解（下标为奇数）的掩码，只对接近方向对称的工具（如抛光头）可直接使用
+const unsigned flippedWristMask = 0xAAu;
+
+// 末端（T04原点）的几何雅可比，基坐标系下，J[0..2]为线速度行，J[3..5]为角速度行
+void jacobian(const MdhParams &params, const double q[4], double J[6][4]);
+void jacobian(const double q[4], double J[6][4]);
+
+// 判断关节角是否在限位内
+bool withinLimits(const double q[4]);
+
+} // namespace ArmKinematics
+
+#endif // ARMKINEMATICS_H
@@ -0,0 +1,274 @@
+#include "armscene.h"
+#include "armkinematics.h"
+#include <QPointLight>
+#include <QtMath>
+#include <Qt3DExtras/QCylinderMesh>
+#include <Qt3DExtras/QPhongMaterial>
+#include <Qt3DExtras/QSphereMesh>
+#include <Qt3DRender/QCamera>
+
+ArmScene::ArmScene(Qt3DCore::QEntity *root, bool withEnvironment)
+    : rootEntity(root)
+    , eeTransform(nullptr)
+{
+    if (withEnvironment) {
+        createLight();
+        createCoordinateAxes();
+    }
+    createArm();
+}
+
+void ArmScene::setupCamera(Qt3DRender::QCamera *camera)
+{
+    // 调整视点位置，使相机远离机械臂，扩大展示范围
+    camera->setPosition(QVector3D(5, 5, 5));
+    camera->setViewCenter(QVector3D(0, 0, 0));
+    camera->setUpVector(QVector3D(0, 1, 0));
+    camera->setProjectionType(Qt3DRender::QCameraLens::PerspectiveProjection);
+    // 增大视场角，从45.0f调整为60.0f
+    camera->setFieldOfView(60.0f);
+    // 调整近裁剪面，适当缩小，从0.1f调整为0.01f
+    camera->setNearPlane(0.01f);
+    // 调整远裁剪面，适当增大，从1000.0f调整为2000.0f
+    camera->setFarPlane(2000.0f);
+}
+
+void ArmScene::createLight()
+{
+    Qt3DCore::QEntity *lightEntity = new Qt3DCore::QEntity(rootEntity);
+    Qt3DRender::QPointLight *light = new Qt3DRender::QPointLight(lightEntity);
+    light->setColor(Qt::white);
+    light->setIntensity(1.0f);
+    lightEntity->addComponent(light);
+
+    // 设置光源位置
+    Qt3DCore::QTransform *lightTransform = new Qt3DCore::QTransform(lightEntity);
+    lightTransform->setTranslation(QVector3D(5, 5, 5)); // 调整光源位置
+    lightEntity->addComponent(lightTransform);
+}
+
+void ArmScene::createCoordinateAxes()
+{
+    // X轴（红色圆柱体）
+    Qt3DCore::QEntity *xAxis = new Qt3DCore::QEntity(rootEntity);
+    Qt3DExtras::QCylinderMesh *xMesh = new Qt3DExtras::QCylinderMesh(xAxis);
+    xMesh->setRadius(0.02f);
+    xMesh->setLength(2.0f); // 长度为2米
+    xMesh->setRings(2);     // 简化网格
+
+    Qt3DExtras::QPhongMaterial *xMat = new Qt3DExtras::QPhongMaterial(xAxis);
+    xMat->setDiffuse(Qt::red);
+
+    Qt3DCore::QTransform *xTransform = new Qt3DCore::QTransform(xAxis);
+    xTransform->setRotationZ(90.0f); // 绕Z轴旋转90度，使圆柱体指向X轴
+
+    xAxis->addComponent(xMesh);
+    xAxis->addComponent(xMat);
+    xAxis->addComponent(xTransform);
+
+    // Y轴（绿色圆柱体）
+    Qt3DCore::QEntity *yAxis = new Qt3DCore::QEntity(rootEntity);
+    Qt3DExtras::QCylinderMesh *yMesh = new Qt3DExtras::QCylinderMesh(yAxis);
+    yMesh->setRadius(0.02f);
+    yMesh->setLength(2.0f);
+    yMesh->setRings(2);
+
+    Qt3DExtras::QPhongMaterial *yMat = new Qt3DExtras::QPhongMaterial(yAxis);
+    yMat->setDiffuse(Qt::green);
+
+    yAxis->addComponent(yMesh);
+    yAxis->addComponent(yMat);
+    yAxis->addComponent(new Qt3DCore::QTransform());
+
+    // Z轴（蓝色圆柱体）
+    Qt3DCore::QEntity *zAxis = new Qt3DCore::QEntity(rootEntity);
+    Qt3DExtras::QCylinderMesh *zMesh = new Qt3DExtras::QCylinderMesh(zAxis);
+    zMesh->setRadius(0.02f);
+    zMesh->setLength(2.0f);
+    zMesh->setRings(2);
+
+    Qt3DExtras::QPhongMaterial *zMat = new Qt3DExtras::QPhongMaterial(zAxis);
+    zMat->setDiffuse(Qt::blue);
+
+    Qt3DCore::QTransform *zTransform = new Qt3DCore::QTransform(zAxis);
+    zTransform->setRotationX(90.0f); // 绕X轴旋转90度，使圆柱体指向Z轴
+
+    zAxis->addComponent(zMesh);
+    zAxis->addComponent(zMat);
+    zAxis->addComponent(zTransform);
+}
+
+void ArmScene::createArm()
+{
+    // 创建末端执行器（红色球体）
+    Qt3DCore::QEntity *endEffector = new Qt3DCore::QEntity(rootEntity);
+    Qt3DExtras::QSphereMesh *eeMesh = new Qt3DExtras::QSphereMesh();
+    eeMesh->setRadius(0.08f); // 半径8厘米
+    Qt3DExtras::QPhongMaterial *eeMaterial = new Qt3DExtras::QPhongMaterial();
+    eeMaterial->setDiffuse(Qt::red); // 红色材质
+    eeTransform = new Qt3DCore::QTransform();
+    endEffector->addComponent(eeMesh);
+    endEffector->addComponent(eeMaterial);
+    endEffector->addComponent(eeTransform);
+    armEntities.append(endEffector);
+
+    // 关节初始位置（单位：米）
+    const QVector<QVector3D> jointPositions = {
+        QVector3D(0.0, 0.0, 0.0),     // 关节1位置
+        QVector3D(0.0, 0.2, 0.0),     // 关节2位置
+        QVector3D(0.0, 0.4, 0.0),     // 关节3位置
+        QVector3D(0.0, 0.6, 0.0),     // 关节4位置
+    };
+
+    for (int i = 0; i < 4; i++) {
+        Qt3DCore::QEntity *joint = new Qt3DCore::QEntity(rootEntity);
+        // 修改为球体网格
+        Qt3DExtras::QSphereMesh *mesh = new Qt3DExtras::QSphereMesh();
+        mesh->setRadius(0.05); // 设置球体半径
+
+        Qt3DExtras::QPhongMaterial *material = new Qt3DExtras::QPhongMaterial();
+        material->setDiffuse(QColor(255, 255, 0)); // 黄色
+
+        // 变换组件（设置位置和初始旋转轴）
+        Qt3DCore::QTransform *transform = new Qt3DCore::QTransform(joint);
+        transform->setTranslation(jointPositions[i]); // 设置位置
+        transform->setRotationX(0); // 初始无旋转
+
+        joint->addComponent(mesh);
+        joint->addComponent(material);
+        joint->addComponent(transform);
+        jointTransforms.append(transform);
+        armEntities.append(joint);
+
+        // 创建连杆
+        if (i > 0) {
+            Qt3DCore::QEntity *link = new Qt3DCore::QEntity(rootEntity);
+            Qt3DExtras::QCylinderMesh *linkMesh = new Qt3DExtras::QCylinderMesh();
+            linkMesh->setRadius(0.03);
+
+            // 计算连杆的长度和方向
+            QVector3D start = jointPositions[i - 1];
+            QVector3D end = jointPositions[i];
+            QVector3D direction = end - start;
+            float length = direction.length();
+            linkMesh->setLength(length);
+
+            // 计算连杆的旋转
+            QVector3D up = QVector3D(0, 1, 0);
+            QVector3D axis = QVector3D::crossProduct(up, direction.normalized());
+            float angle = qRadiansToDegrees(qAcos(QVector3D::dotProduct(up, direction.normalized())));
+
+            Qt3DCore::QTransform *linkTransform = new Qt3DCore::QTransform();
+            linkTransform->setTranslation(start + direction / 2);
+            linkTransform->setRotation(QQuaternion::fromAxisAndAngle(axis, angle));
+
+            Qt3DExtras::QPhongMaterial *linkMaterial = new Qt3DExtras::QPhongMaterial();
+            linkMaterial->setDiffuse(QColor(128, 128, 128)); // 灰色
+            link->addComponent(linkMesh);
+            link->addComponent(linkMaterial);
+            link->addComponent(linkTransform);
+
+            linkEntities.append(link);
+            linkTransforms.append(linkTransform);
+            armEntities.append(link);
+        }
+    }
+
+    // 记录关节和连杆的初始变换
+    for (int i = 0; i < jointTransforms.size(); ++i) {
+        jointInitialTransforms.append(jointTransforms[i]->matrix());
+    }
+    for (int i = 0; i < linkTransforms.size(); ++i) {
+        linkInitialTransforms.append(linkTransforms[i]->matrix());
+    }
+}
+
+void ArmScene::setJointAngles(const double q[4])
+{
+    double frames[4][16];
+    ArmKinematics::jointFrames(q, frames);
+    setJointFrames(frames);
+}
+
+void ArmScene::setJointFrames(const double frames[4][16])
+{
+    for (int i = 0; i < 4; ++i) {
+        const double *T0i = frames[i];
+        jointTransforms[i]->setTranslation(QVector3D(T0i[3], T0i[7], T0i[11]));
+
+        // 计算旋转矩阵到四元数的转换
+        QMatrix3x3 rotationMatrix;
+        for (int row = 0; row < 3; ++row) {
+            for (int col = 0; col < 3; ++col) {
+                rotationMatrix(row, col) = T0i[row * 4 + col]; // 逐元素赋值
+            }
+        }
+        jointTransforms[i]->setRotation(QQuaternion::fromRotationMatrix(rotationMatrix));
+    }
+
+    // 更新连杆变换
+    for (int i = 0; i < linkTransforms.size(); ++i) {
+        QVector3D start = jointTransforms[i]->translation();
+        QVector3D end = jointTransforms[i + 1]->translation();
+        QVector3D direction = end - start;
+        float length = direction.length();
+
+        // 更新连杆长度
+        Qt3DExtras::QCylinderMesh *linkMesh = qobject_cast<Qt3DExtras::QCylinderMesh*>(linkEntities[i]->components().first());
+        if (linkMesh) {
+            linkMesh->setLength(length);
+        }
+
+        // 计算旋转并更新连杆变换
+        QVector3D up = QVector3D(0, 1, 0);
+        QVector3D axis = QVector3D::crossProduct(up, direction.normalized());
+        float angle = qRadiansToDegrees(qAcos(QVector3D::dotProduct(up, direction.normalized())));
+        linkTransforms[i]->setTranslation(start + direction / 2);
+        linkTransforms[i]->setRotation(QQuaternion::fromAxisAndAngle(axis, angle));
+    }
+}
+
+void ArmScene::setEndEffectorPose(const double T[16])
+{
+    QMatrix4x4 T04_matrix(
+        T[0], T[1], T[2], T[3],
+        T[4], T[5], T[6], T[7],
+        T[8], T[9], T[10], T[11],
+        T[12], T[13], T[14], T[15]
+        );
+    eeTransform->setMatrix(T04_matrix);
+}
+
+void ArmScene::reset()
+{
+    // 恢复关节和连杆的初始变换
+    for (int i = 0; i < jointTransforms.size(); ++i) {
+        jointTransforms[i]->setMatrix(jointInitialTransforms[i]);
+    }
+    for (int i = 0; i < linkTransforms.size(); ++i) {
+        linkTransforms[i]->setMatrix(linkInitialTransforms[i]);
+
+        // 恢复连杆的初始长度
+        Qt3DExtras::QCylinderMesh *linkMesh = qobject_cast<Qt3DExtras::QCylinderMesh*>(linkEntities[i]->components().first());
+        if (linkMesh) {
+            // 从QMatrix4x4中提取初始平移信息
+            QVector3D start(jointInitialTransforms[i].column(3).x(), jointInitialTransforms[i].column(3).y(), jointInitialTransforms[i].column(3).z());
+            QVector3D end(jointInitialTransforms[i + 1].column(3).x(), jointInitialTransforms[i + 1].column(3).y(), jointInitialTransforms[i + 1].column(3).z());
+            QVector3D direction = end - start;
+            float length = direction.length();
+            linkMesh->setLength(length);
+        }
+    }
+
+    // 重置末端执行器位置
+    QMatrix4x4 initialMatrix; // 初始化为单位矩阵
+    initialMatrix.setToIdentity();
+    eeTransform->setMatrix(initialMatrix);
+}
+
+void ArmScene::setArmVisible(bool visible)
+{
+    for (Qt3DCore::QEntity *entity : armEntities) {
+        entity->setEnabled(visible);
+    }
+}
@@ -0,0 +1,51 @@
+#ifndef ARMSCENE_H
+#define ARMSCENE_H
+
+#include <QMatrix4x4>
+#include <QVector>
+#include <Qt3DCore/QEntity>
+#include <Qt3DCore/QTransform>
+
+namespace Qt3DRender { class QCamera; }
+
+// 机械臂三维场景：光源、坐标系辅助线、关节（黄色球体）、连杆（灰色圆柱体）和末端执行器（红色球体）
+// 所有实体挂在传入的根实体下，由Qt3D的父子关系管理生命周期；
+// 界面窗口和离线渲染共用同一套场景构建代码
+class ArmScene
+{
+public:
+    // withEnvironment为false时只创建机械臂，不创建光源和坐标系（同一场景中放置多台机械臂时使用）
+    explicit ArmScene(Qt3DCore::QEntity *root, bool withEnvironment = true);
+
+    Qt3DCore::QEntity *root() const { return rootEntity; }
+
+    // 按关节角更新关节和连杆（不改变末端执行器）
+    void setJointAngles(const double q[4]);
+    // 按已算好的T01..T04（行优先，可含基座变换）更新关节和连杆
+    void setJointFrames(const double frames[4][16]);
+    // 末端执行器位姿（行优先4x4）
+    void setEndEffectorPose(const double T[16]);
+    // 恢复构建时的初始姿态
+    void reset();
+    // 显示或隐藏机械臂（光源和坐标系不受影响）
+    void setArmVisible(bool visible);
+
+    // 默认相机视角
+    static void setupCamera(Qt3DRender::QCamera *camera);
+
+private:
+    void createLight();
+    void createCoordinateAxes();
+    void createArm();
+
+    Qt3DCore::QEntity *rootEntity;
+    QVector<Qt3DCore::QEntity*> armEntities;        // 关节、连杆和末端执行器实体
+    QVector<Qt3DCore::QTransform*> jointTransforms; // 每个关节的变换组件
+    QVector<Qt3DCore::QEntity*> linkEntities;       // 每个连杆的实体
+    QVector<Qt3DCore::QTransform*> linkTransforms;  // 每个连杆的变换组件
+    Qt3DCore::QTransform *eeTransform;              // 末端执行器的变换组件
+    QVector<QMatrix4x4> jointInitialTransforms;
+    QVector<QMatrix4x4> linkInitialTransforms;
+};
+
+#endif // ARMSCENE_H
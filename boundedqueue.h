@@ -0,0 +1,95 @@
+#ifndef BOUNDEDQUEUE_H
+#define BOUNDEDQUEUE_H
+
+#include "metrics.h"
+
+#include <QMutex>
+#include <QMutexLocker>
+#include <QQueue>
+#include <QWaitCondition>
+#include <utility>
+
+// 有界阻塞队列：用于流水线各级之间传递批数据，
+// 队列满时生产者阻塞，使内存占用与输入规模无关
+template <typename T>
+class BoundedQueue
+{
+public:
+    explicit BoundedQueue(int capacity)
+        : cap(capacity > 0 ? capacity : 1)
+    {
+    }
+
+    // 队列深度写入指标（可为空），每次入队、出队时更新
+    void setDepthGauge(Metrics::Gauge *gauge) { depthGauge = gauge; }
+
+    // 队列满时阻塞；队列已关闭时丢弃元素并返回false
+    bool push(T item)
+    {
+        QMutexLocker locker(&mutex);
+        while (items.size() >= cap && !closed) {
+            notFull.wait(&mutex);
+        }
+        if (closed) {
+            return false;
+        }
+        items.enqueue(std::move(item));
+        updateDepth();
+        notEmpty.wakeOne();
+        return true;
+    }
+
+    // 队列空时阻塞；队列已关闭且元素取完后返回false
+    bool pop(T &item)
+    {
+        QMutexLocker locker(&mutex);
+        while (items.isEmpty() && !closed) {
+            notEmpty.wait(&mutex);
+        }
+        if (items.isEmpty()) {
+            return false;
+        }
+        item = items.dequeue();
+        updateDepth();
+        notFull.wakeOne();
+        return true;
+    }
+
+    // 生产者全部结束：不再接受写入，已入队的元素仍可取出
+    void close()
+    {
+        QMutexLocker locker(&mutex);
+        closed = true;
+        notEmpty.wakeAll();
+        notFull.wakeAll();
+    }
+
+    // 取消：丢弃队列中的元素并唤醒所有等待者
+    void abort()
+    {
+        QMutexLocker locker(&mutex);
+        closed = true;
+        items.clear();
+        updateDepth();
+        notEmpty.wakeAll();
+        notFull.wakeAll();
+    }
+
+private:
+    void updateDepth()
+    {
+        if (depthGauge) {
+            depthGauge->set(items.size());
+        }
+    }
+
+    QMutex mutex;
+    QWaitCondition notEmpty;
+    QWaitCondition notFull;
+    QQueue<T> items;
+    const int cap;
+    bool closed = false;
+    Metrics::Gauge *depthGauge = nullptr;
+};
+
+#endif // BOUNDEDQUEUE_H
@@ -0,0 +1,463 @@
+#include "cellsimulation.h"
+#include "trajectorytiming.h"
+#include <QElapsedTimer>
+#include <QMutexLocker>
+#include <QThread>
+#include <QThreadPool>
+#include <QtConcurrent>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+const double kInfinity = std::numeric_limits<double>::infinity();
+// 每个时间窗口的最大步数；窗口内保存 步数*机器人数 个StepState
+const int kWindowSteps = 1024;
+// 每个并行任务处理的连续步数
+const int kStepBlock = 64;
+const int kMaxRobots = 64;
+// 包围盒相距小于该值的机器人对才精确计算距离，更远的clearance记为无穷大
+const double kClearanceRange = 0.5;
+
+void setIdentity(double T[16])
+{
+    for (int i = 0; i < 16; ++i) {
+        T[i] = (i % 5 == 0) ? 1.0 : 0.0;
+    }
+}
+
+// 行优先4x4刚体变换相乘 r = a*b（最后一行固定为0 0 0 1）
+void multiplyRigid(const double a[16], const double b[16], double r[16])
+{
+    for (int i = 0; i < 3; ++i) {
+        for (int j = 0; j < 4; ++j) {
+            r[i * 4 + j] = a[i * 4] * b[j] + a[i * 4 + 1] * b[4 + j] + a[i * 4 + 2] * b[8 + j]
+                           + (j == 3 ? a[i * 4 + 3] : 0.0);
+        }
+    }
+    r[12] = r[13] = r[14] = 0;
+    r[15] = 1;
+}
+
+} // namespace
+
+CellSimulation::RobotConfig::RobotConfig()
+    : params(ArmKinematics::activeParams())
+    , endEffectorRadius(0.08)
+{
+    setIdentity(base);
+    for (int i = 0; i < 3; ++i) {
+        linkRadius[i] = 0.05;
+    }
+}
+
+CellSimulation::CellSimulation()
+    : dt(0.001)
+    , safetyMargin(0.01)
+    , stopOnCollision(true)
+    , threadPool(nullptr)
+    , stepCounter(0)
+{
+    reset();
+}
+
+int CellSimulation::addRobot(const RobotConfig &config)
+{
+    if (robots.size() >= kMaxRobots) {
+        return -1;
+    }
+    Robot robot;
+    robot.config = config;
+    robots.append(robot);
+    reset();
+    return robots.size() - 1;
+}
+
+void CellSimulation::clear()
+{
+    robots.clear();
+    window.clear();
+    reset();
+}
+
+void CellSimulation::setTrajectory(int robot, const QVector<double> &positions, double rate, bool loop)
+{
+    if (robot < 0 || robot >= robots.size()) {
+        return;
+    }
+    robots[robot].trajectory = positions;
+    robots[robot].rate = rate > 0 ? rate : 1000.0;
+    robots[robot].loop = loop;
+    reset();
+}
+
+void CellSimulation::setTimeStep(double seconds)
+{
+    if (seconds > 0) {
+        dt = seconds;
+    }
+}
+
+void CellSimulation::setupDemoCell(int robotCount, double rate)
+{
+    clear();
+    robotCount = qBound(1, robotCount, kMaxRobots);
+
+    // 往复轨迹：A -> B -> A，两端速度为零，可以无缝循环
+    const double a[4] = {-0.5, 0.2, -0.6, 0.0};
+    const double b[4] = {0.5, 0.6, -0.2, 1.0};
+    const int segmentSamples = 50;
+    QVector<double> path;
+    for (int k = 0; k <= 2 * segmentSamples; ++k) {
+        const double s = k <= segmentSamples ? double(k) / segmentSamples : double(2 * segmentSamples - k) / segmentSamples;
+        for (int j = 0; j < 4; ++j) {
+            path.append(a[j] + s * (b[j] - a[j]));
+        }
+    }
+    TrajectoryTiming::Profile profile;
+    QVector<double> positions, velocities;
+    TrajectoryTiming::computeProfile(path.constData(), path.size() / 4, TrajectoryTiming::defaultLimits(), profile);
+    TrajectoryTiming::resample(path.constData(), path.size() / 4, profile, rate, positions, velocities);
+    const int sampleCount = positions.size() / 4;
+
+    // 基座沿圆周均布，x轴指向圆心；机械臂伸展约2 m，圆周半径至少2.4 m、
+    // 相邻基座至少相距3.4 m，使相邻机器人的工作空间有重叠但不会一开始就相撞
+    const double radius = robotCount > 1 ? std::max(2.4, 1.7 / std::sin(M_PI / robotCount)) : 2.4;
+    for (int i = 0; i < robotCount; ++i) {
+        const double angle = 2 * M_PI * i / robotCount;
+        const double heading = angle + M_PI;
+        RobotConfig config;
+        config.name = QString("机器人%1").arg(i + 1);
+        config.base[0] = std::cos(heading);
+        config.base[1] = -std::sin(heading);
+        config.base[4] = std::sin(heading);
+        config.base[5] = std::cos(heading);
+        config.base[3] = radius * std::cos(angle);
+        config.base[7] = radius * std::sin(angle);
+        const int robot = addRobot(config);
+
+        // 各机器人的轨迹相位错开
+        const int shift = sampleCount * i / robotCount;
+        QVector<double> shifted;
+        shifted.reserve(positions.size());
+        shifted += positions.mid(4 * shift);
+        shifted += positions.mid(0, 4 * shift);
+        setTrajectory(robot, shifted, rate, true);
+    }
+}
+
+void CellSimulation::reset()
+{
+    stepCounter = 0;
+    for (Robot &robot : robots) {
+        robot.time = 0;
+        robot.halted = false;
+        bool finished = false;
+        sampleTrajectory(robot, 0, robot.q, finished);
+    }
+    {
+        QMutexLocker locker(&publishMutex);
+        totals = Stats();
+    }
+    publish(nullptr);
+}
+
+void CellSimulation::sampleTrajectory(const Robot &robot, double time, double q[4], bool &finished) const
+{
+    const int count = robot.trajectory.size() / 4;
+    if (count == 0) {
+        // 没有轨迹的机器人保持当前关节角
+        std::copy(robot.q, robot.q + 4, q);
+        finished = true;
+        return;
+    }
+    const double duration = (count - 1) / robot.rate;
+    double t;
+    if (robot.loop && duration > 0) {
+        t = std::fmod(time, duration);
+        finished = false;
+    } else {
+        t = std::min(time, duration);
+        finished = time >= duration;
+    }
+    const double x = t * robot.rate;
+    const int i0 = std::min(int(x), count - 1);
+    const int i1 = std::min(i0 + 1, count - 1);
+    const double frac = x - i0;
+    const double *q0 = robot.trajectory.constData() + 4 * i0;
+    const double *q1 = robot.trajectory.constData() + 4 * i1;
+    for (int j = 0; j < 4; ++j) {
+        q[j] = q0[j] + frac * (q1[j] - q0[j]);
+    }
+}
+
+void CellSimulation::worldFrames(const Robot &robot, const double q[4], double frames[4][16]) const
+{
+    double local[4][16];
+    ArmKinematics::jointFrames(robot.config.params, q, local);
+    for (int i = 0; i < 4; ++i) {
+        multiplyRigid(robot.config.base, local[i], frames[i]);
+    }
+}
+
+void CellSimulation::computeStep(int robotIndex, double time, StepState &state) const
+{
+    const Robot &robot = robots[robotIndex];
+    state.time = time;
+    if (robot.halted) {
+        std::copy(robot.q, robot.q + 4, state.q);
+        state.finished = false;
+    } else {
+        sampleTrajectory(robot, time, state.q, state.finished);
+    }
+
+    // 胶囊体与CollisionChecker::armCapsules一致：连杆连接相邻关节原点，末端执行器为T04原点处的球
+    double frames[4][16];
+    worldFrames(robot, state.q, frames);
+    for (int i = 0; i < 3; ++i) {
+        for (int k = 0; k < 3; ++k) {
+            state.capsules[i].p0[k] = frames[i][k * 4 + 3];
+            state.capsules[i].p1[k] = frames[i + 1][k * 4 + 3];
+        }
+        state.capsules[i].radius = robot.config.linkRadius[i];
+    }
+    for (int k = 0; k < 3; ++k) {
+        state.capsules[3].p0[k] = state.capsules[3].p1[k] = frames[3][k * 4 + 3];
+    }
+    state.capsules[3].radius = robot.config.endEffectorRadius;
+
+    // 包围盒各向外扩半个检测范围，两个包围盒相交即相距小于检测范围
+    const double pad = 0.5 * std::max(kClearanceRange, safetyMargin);
+    for (int k = 0; k < 3; ++k) {
+        state.boundsMin[k] = kInfinity;
+        state.boundsMax[k] = -kInfinity;
+    }
+    for (const CollisionChecker::Capsule &capsule : state.capsules) {
+        for (int k = 0; k < 3; ++k) {
+            state.boundsMin[k] = std::min(state.boundsMin[k], std::min(capsule.p0[k], capsule.p1[k]) - capsule.radius - pad);
+            state.boundsMax[k] = std::max(state.boundsMax[k], std::max(capsule.p0[k], capsule.p1[k]) + capsule.radius + pad);
+        }
+    }
+    state.clearance = kInfinity;
+    state.nearestRobot = -1;
+}
+
+void CellSimulation::checkStep(StepState *states, StepResult &result) const
+{
+    const int count = robots.size();
+    result = StepResult();
+    for (int i = 0; i < count; ++i) {
+        for (int j = i + 1; j < count; ++j) {
+            const StepState &a = states[i];
+            const StepState &b = states[j];
+            bool overlap = true;
+            for (int k = 0; k < 3 && overlap; ++k) {
+                overlap = a.boundsMin[k] <= b.boundsMax[k] && b.boundsMin[k] <= a.boundsMax[k];
+            }
+            if (!overlap) {
+                continue;
+            }
+
+            ++result.pairChecks;
+            double distance = kInfinity;
+            for (const CollisionChecker::Capsule &ca : a.capsules) {
+                for (const CollisionChecker::Capsule &cb : b.capsules) {
+                    distance = std::min(distance, CollisionChecker::capsuleDistance(ca, cb));
+                }
+            }
+            if (distance < states[i].clearance) {
+                states[i].clearance = distance;
+                states[i].nearestRobot = j;
+            }
+            if (distance < states[j].clearance) {
+                states[j].clearance = distance;
+                states[j].nearestRobot = i;
+            }
+            if (distance < safetyMargin) {
+                ++result.collisions;
+                // 两台都已停止的机器人不再触发停止，否则窗口永远无法前进
+                if (!robots[i].halted) {
+                    result.stopMask |= quint64(1) << i;
+                }
+                if (!robots[j].halted) {
+                    result.stopMask |= quint64(1) << j;
+                }
+            }
+        }
+    }
+}
+
+int CellSimulation::runWindow(int steps)
+{
+    const int count = robots.size();
+    const int blocks = (steps + kStepBlock - 1) / kStepBlock;
+    window.resize(steps * count);
+    stepResults.resize(steps);
+    QThreadPool *pool = threadPool ? threadPool : QThreadPool::globalInstance();
+
+    // 1. 各机器人的轨迹采样和正解互不依赖，按（机器人, 步块）并行
+    QVector<int> tasks(count * blocks);
+    for (int i = 0; i < tasks.size(); ++i) {
+        tasks[i] = i;
+    }
+    QtConcurrent::blockingMap(pool, tasks, [this, count, blocks, steps](int task) {
+        const int robot = task / blocks;
+        const int first = (task % blocks) * kStepBlock;
+        const int last = std::min(steps, first + kStepBlock);
+        const Robot &r = robots[robot];
+        for (int s = first; s < last; ++s) {
+            const double time = r.halted ? r.time : r.time + (s + 1) * dt;
+            computeStep(robot, time, window[s * count + robot]);
+        }
+    });
+
+    // 2. 机器人之间的碰撞检测，按步块并行，每个任务只写自己步块内的结果
+    tasks.resize(blocks);
+    QtConcurrent::blockingMap(pool, tasks, [this, count, steps](int block) {
+        const int first = block * kStepBlock;
+        const int last = std::min(steps, first + kStepBlock);
+        for (int s = first; s < last; ++s) {
+            checkStep(window.data() + s * count, stepResults[s]);
+        }
+    });
+
+    // 3. 串行提交到第一个需要停止机器人的步之前；
+    // 停止的那一步不提交，下一个窗口停止相应机器人后重新计算，统计也只计入已提交的步
+    int commit = steps;
+    quint64 stopMask = 0;
+    Stats delta;
+    for (int s = 0; s < steps; ++s) {
+        const StepResult &result = stepResults[s];
+        if (stopOnCollision && result.stopMask) {
+            commit = s;
+            stopMask = result.stopMask;
+            break;
+        }
+        delta.pairChecks += result.pairChecks;
+        delta.collisions += result.collisions;
+    }
+    delta.steps = commit;
+
+    if (commit > 0) {
+        const StepState *last = window.constData() + (commit - 1) * count;
+        for (int i = 0; i < count; ++i) {
+            if (!robots[i].halted) {
+                robots[i].time = last[i].time;
+                std::copy(last[i].q, last[i].q + 4, robots[i].q);
+            }
+        }
+    }
+    for (int i = 0; i < count; ++i) {
+        if (stopMask & (quint64(1) << i)) {
+            robots[i].halted = true;
+        }
+    }
+    stepCounter += commit;
+
+    {
+        QMutexLocker locker(&publishMutex);
+        totals.steps += delta.steps;
+        totals.pairChecks += delta.pairChecks;
+        totals.collisions += delta.collisions;
+    }
+    publish(commit > 0 && !stopMask ? window.constData() + (commit - 1) * count : nullptr);
+    return commit;
+}
+
+void CellSimulation::advance(int steps)
+{
+    if (robots.isEmpty() || steps <= 0) {
+        return;
+    }
+    QElapsedTimer timer;
+    timer.start();
+    // 每次发生新的碰撞停止时窗口可能提交0步，但每次至少多停止一台机器人，循环必然结束
+    int remaining = steps;
+    while (remaining > 0) {
+        remaining -= runWindow(std::min(remaining, kWindowSteps));
+    }
+    QMutexLocker locker(&publishMutex);
+    totals.busySeconds += timer.nsecsElapsed() / 1e9;
+}
+
+void CellSimulation::runRealTime(const std::function<bool()> &cancelled, double speed, double frameSeconds)
+{
+    speed = speed > 0 ? speed : 1.0;
+    const qint64 frameNanoseconds = qMax<qint64>(1000000, qint64(frameSeconds * 1e9));
+    // 一帧最多推进的步数：正常情况下每帧的步数远小于此，落后更多时不再追赶，避免界面看到的状态越来越滞后
+    const int maxSteps = std::max(kWindowSteps, int(2 * frameNanoseconds / 1e9 * speed / dt));
+    QElapsedTimer clock;
+    clock.start();
+    qint64 nextFrame = 0;
+    double simulated = 0;
+    while (!cancelled()) {
+        const qint64 now = clock.nsecsElapsed();
+        if (now < nextFrame) {
+            QThread::usleep(quint64((nextFrame - now) / 1000));
+            continue;
+        }
+        nextFrame += frameNanoseconds;
+        if (nextFrame <= now) {
+            nextFrame = now + frameNanoseconds;
+        }
+
+        const double target = now / 1e9 * speed;
+        const int due = int((target - simulated) / dt);
+        if (due <= 0) {
+            continue;
+        }
+        const int steps = std::min(due, maxSteps);
+        advance(steps);
+        simulated += steps * dt;
+        if (due > maxSteps) {
+            simulated = target;
+        }
+    }
+}
+
+void CellSimulation::publish(const StepState *last)
+{
+    const int count = robots.size();
+    QVector<StepState> current;
+    if (!last) {
+        // 提交了0步或刚复位：按机器人当前状态重新计算一次
+        current.resize(count);
+        for (int i = 0; i < count; ++i) {
+            computeStep(i, robots[i].time, current[i]);
+        }
+        StepResult result;
+        checkStep(current.data(), result);
+        last = current.constData();
+    }
+
+    Snapshot snapshot;
+    snapshot.step = stepCounter;
+    snapshot.time = stepCounter * dt;
+    snapshot.robots.resize(count);
+    for (int i = 0; i < count; ++i) {
+        RobotState &state = snapshot.robots[i];
+        std::copy(robots[i].q, robots[i].q + 4, state.q);
+        worldFrames(robots[i], state.q, state.frames);
+        state.trajectoryTime = robots[i].time;
+        state.finished = last[i].finished;
+        state.halted = robots[i].halted;
+        state.nearestRobot = last[i].nearestRobot;
+        state.clearance = last[i].clearance;
+    }
+
+    QMutexLocker locker(&publishMutex);
+    published = snapshot;
+}
+
+CellSimulation::Snapshot CellSimulation::snapshot() const
+{
+    QMutexLocker locker(&publishMutex);
+    return published;
+}
+
+CellSimulation::Stats CellSimulation::stats() const
+{
+    QMutexLocker locker(&publishMutex);
+    return totals;
+}
@@ -0,0 +1,150 @@
+#ifndef CELLSIMULATION_H
+#define CELLSIMULATION_H
+
+#include "armkinematics.h"
+#include "collisionchecker.h"
+#include <QMutex>
+#include <QString>
+#include <QVector>
+#include <functional>
+
+class QThreadPool;
+
+// 多机器人工作单元仿真：N台机械臂（最多64台）各有基座变换和运动学模型，
+// 按固定时间步长推进轨迹执行、正解和机器人之间的碰撞检测。
+// 轨迹为开环执行，各机器人在时间上互不依赖，因此每次推进一个时间窗口（若干步）：
+//   1. 按（机器人, 步块）并行计算关节角和单元坐标系下的胶囊体
+//   2. 按步块并行检查所有机器人对的胶囊体距离
+//   3. 串行提交：启用碰撞停止时，碰撞的机器人停在碰撞前一步，窗口内之后的步丢弃后重算
+// 界面只通过snapshot()读取最近提交的状态，不参与推进
+class CellSimulation
+{
+public:
+    struct RobotConfig
+    {
+        RobotConfig(); // 单位基座、当前MDH参数、与CollisionChecker相同的默认半径
+
+        QString name;
+        double base[16];                 // 基座在单元坐标系中的位姿（行优先4x4）
+        ArmKinematics::MdhParams params; // 运动学模型
+        double linkRadius[3];
+        double endEffectorRadius;
+    };
+
+    struct RobotState
+    {
+        double q[4];
+        double frames[4][16];  // 单元坐标系下的T01..T04
+        double trajectoryTime; // 轨迹上的执行时刻（秒）
+        bool finished;         // 非循环轨迹已执行到终点
+        bool halted;           // 因碰撞停止
+        int nearestRobot;      // 距离最近的其他机器人，-1表示没有
+        double clearance;      // 与其他机器人的最小表面距离（米），无穷大表示大于0.5 m
+    };
+
+    struct Snapshot
+    {
+        quint64 step = 0;
+        double time = 0;
+        QVector<RobotState> robots;
+    };
+
+    struct Stats
+    {
+        quint64 steps = 0;
+        quint64 pairChecks = 0;  // 通过包围盒粗筛、计算了胶囊体距离的（步, 机器人对）数
+        quint64 collisions = 0;  // 距离小于安全距离的（步, 机器人对）数
+        double busySeconds = 0;  // advance()累计耗时
+    };
+
+    CellSimulation();
+
+    // 以下配置函数不能与advance()同时调用
+    int addRobot(const RobotConfig &config);
+    void clear();
+    int robotCount() const { return robots.size(); }
+    const RobotConfig &robotConfig(int robot) const { return robots[robot].config; }
+
+    // positions按每4个关节角连续存储，以rate（Hz）等间隔采样，如TrajectoryTiming::resample的输出
+    void setTrajectory(int robot, const QVector<double> &positions, double rate, bool loop);
+
+    void setTimeStep(double seconds);
+    double timeStep() const { return dt; }
+    void setSafetyMargin(double margin) { safetyMargin = margin; }
+    void setStopOnCollision(bool stop) { stopOnCollision = stop; }
+    // 为空时使用全局线程池
+    void setThreadPool(QThreadPool *pool) { threadPool = pool; }
+
+    // 演示单元：robotCount台机械臂沿圆周均布、面向圆心，各自循环执行一段往复轨迹
+    void setupDemoCell(int robotCount, double rate = 1000.0);
+
+    // 所有机器人回到轨迹起点，清除碰撞停止状态和统计
+    void reset();
+    // 推进steps个时间步，阻塞到完成（内部并行）
+    void advance(int steps);
+    // 按实时的speed倍持续推进，直到cancelled返回true；每frameSeconds（如界面的刷新周期）醒来一次，
+    // 一次推进这段时间对应的全部步数，其间休眠；算力不足时跳过落后的时间
+    void runRealTime(const std::function<bool()> &cancelled, double speed = 1.0, double frameSeconds = 1.0 / 30);
+
+    // 线程安全，可在推进过程中从其他线程调用
+    Snapshot snapshot() const;
+    Stats stats() const;
+
+private:
+    struct Robot
+    {
+        RobotConfig config;
+        QVector<double> trajectory;
+        double rate = 1000.0;
+        bool loop = false;
+        double time = 0;
+        bool halted = false;
+        double q[4] = {0, 0, 0, 0};
+    };
+
+    // 一个时间步中一台机器人的状态和胶囊体
+    struct StepState
+    {
+        double q[4];
+        double time;
+        bool finished;
+        CollisionChecker::Capsule capsules[CollisionChecker::ArmCapsuleCount];
+        double boundsMin[3];
+        double boundsMax[3];
+        double clearance;
+        int nearestRobot;
+    };
+
+    // 一个时间步的碰撞检测结果
+    struct StepResult
+    {
+        quint64 pairChecks = 0;
+        quint64 collisions = 0;
+        quint64 stopMask = 0; // 第i位：机器人i在该步发生碰撞且尚未停止
+    };
+
+    void sampleTrajectory(const Robot &robot, double time, double q[4], bool &finished) const;
+    void worldFrames(const Robot &robot, const double q[4], double frames[4][16]) const;
+    void computeStep(int robot, double time, StepState &state) const;
+    // states为同一步所有机器人的状态，写入各自的clearance和nearestRobot
+    void checkStep(StepState *states, StepResult &result) const;
+    // 推进至多steps步，返回实际提交的步数
+    int runWindow(int steps);
+    // last为最近提交的一步中各机器人的状态，为空时按当前状态重新计算
+    void publish(const StepState *last);
+
+    QVector<Robot> robots;
+    QVector<StepState> window; // window[step * robotCount + robot]
+    QVector<StepResult> stepResults;
+    double dt;
+    double safetyMargin;
+    bool stopOnCollision;
+    QThreadPool *threadPool;
+    quint64 stepCounter;
+
+    mutable QMutex publishMutex;
+    Snapshot published;
+    Stats totals;
+};
+
+#endif // CELLSIMULATION_H
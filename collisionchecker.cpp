@@ -0,0 +1,788 @@
+#include "collisionchecker.h"
+#include "armkinematics.h"
+#include "meshstreamreader.h"
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QtConcurrent>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+const double kInfinity = std::numeric_limits<double>::infinity();
+const double kEpsilon = 1e-12;
+
+// 从JSON数组读取固定个数的数值，数组不存在时保留out中的默认值
+bool readJsonNumbers(const QJsonObject &object, const char *key, double *out, int size)
+{
+    const QJsonValue value = object.value(key);
+    if (value.isUndefined()) {
+        return true;
+    }
+    const QJsonArray array = value.toArray();
+    if (array.size() != size) {
+        return false;
+    }
+    for (int i = 0; i < size; ++i) {
+        out[i] = array.at(i).toDouble();
+    }
+    return true;
+}
+
+// 需要检查自碰撞的胶囊体对（相邻连杆共用关节，不检查）
+const int kSelfPairs[3][2] = {{0, 2}, {0, 3}, {1, 3}};
+
+// 每个批处理块的构型数量，块内按SoA存储，同一对胶囊体的距离在一个循环里连续计算
+const int kBatchBlock = 64;
+// 每个并行任务处理的构型数量
+const int kTaskSize = 1024;
+
+inline double dot3(const double a[3], const double b[3])
+{
+    return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+
+inline void sub3(const double a[3], const double b[3], double r[3])
+{
+    r[0] = a[0] - b[0];
+    r[1] = a[1] - b[1];
+    r[2] = a[2] - b[2];
+}
+
+inline void cross3(const double a[3], const double b[3], double r[3])
+{
+    r[0] = a[1] * b[2] - a[2] * b[1];
+    r[1] = a[2] * b[0] - a[0] * b[2];
+    r[2] = a[0] * b[1] - a[1] * b[0];
+}
+
+inline double clamp01(double x)
+{
+    return std::min(std::max(x, 0.0), 1.0);
+}
+
+// 两条线段最近距离的平方（Ericson算法，参数钳位用min/max代替分支）
+inline double segmentSegmentDistSq(double p1x, double p1y, double p1z, double q1x, double q1y, double q1z,
+                                   double p2x, double p2y, double p2z, double q2x, double q2y, double q2z)
+{
+    const double d1x = q1x - p1x, d1y = q1y - p1y, d1z = q1z - p1z;
+    const double d2x = q2x - p2x, d2y = q2y - p2y, d2z = q2z - p2z;
+    const double rx = p1x - p2x, ry = p1y - p2y, rz = p1z - p2z;
+    const double a = d1x * d1x + d1y * d1y + d1z * d1z;
+    const double e = d2x * d2x + d2y * d2y + d2z * d2z;
+    const double f = d2x * rx + d2y * ry + d2z * rz;
+    const double c = d1x * rx + d1y * ry + d1z * rz;
+    const double b = d1x * d2x + d1y * d2y + d1z * d2z;
+    const double denom = a * e - b * b;
+
+    const double s0 = denom > kEpsilon ? clamp01((b * f - c * e) / denom) : 0.0;
+    const double t = clamp01((b * s0 + f) / std::max(e, kEpsilon));
+    const double s = clamp01((b * t - c) / std::max(a, kEpsilon));
+
+    const double dx = rx + d1x * s - d2x * t;
+    const double dy = ry + d1y * s - d2y * t;
+    const double dz = rz + d1z * s - d2z * t;
+    return dx * dx + dy * dy + dz * dz;
+}
+
+inline double segmentSegmentDistSq(const double p1[3], const double q1[3], const double p2[3], const double q2[3])
+{
+    return segmentSegmentDistSq(p1[0], p1[1], p1[2], q1[0], q1[1], q1[2],
+                                p2[0], p2[1], p2[2], q2[0], q2[1], q2[2]);
+}
+
+// 点到三角形最近点（Ericson《Real-Time Collision Detection》5.1.5）
+void closestPointOnTriangle(const double p[3], const double a[3], const double b[3], const double c[3], double out[3])
+{
+    double ab[3], ac[3], ap[3];
+    sub3(b, a, ab);
+    sub3(c, a, ac);
+    sub3(p, a, ap);
+    const double d1 = dot3(ab, ap), d2 = dot3(ac, ap);
+    if (d1 <= 0 && d2 <= 0) {
+        std::copy(a, a + 3, out);
+        return;
+    }
+
+    double bp[3];
+    sub3(p, b, bp);
+    const double d3 = dot3(ab, bp), d4 = dot3(ac, bp);
+    if (d3 >= 0 && d4 <= d3) {
+        std::copy(b, b + 3, out);
+        return;
+    }
+
+    const double vc = d1 * d4 - d3 * d2;
+    if (vc <= 0 && d1 >= 0 && d3 <= 0) {
+        const double v = d1 / (d1 - d3);
+        for (int i = 0; i < 3; ++i) out[i] = a[i] + v * ab[i];
+        return;
+    }
+
+    double cp[3];
+    sub3(p, c, cp);
+    const double d5 = dot3(ab, cp), d6 = dot3(ac, cp);
+    if (d6 >= 0 && d5 <= d6) {
+        std::copy(c, c + 3, out);
+        return;
+    }
+
+    const double vb = d5 * d2 - d1 * d6;
+    if (vb <= 0 && d2 >= 0 && d6 <= 0) {
+        const double w = d2 / (d2 - d6);
+        for (int i = 0; i < 3; ++i) out[i] = a[i] + w * ac[i];
+        return;
+    }
+
+    const double va = d3 * d6 - d5 * d4;
+    if (va <= 0 && (d4 - d3) >= 0 && (d5 - d6) >= 0) {
+        const double w = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+        for (int i = 0; i < 3; ++i) out[i] = b[i] + w * (c[i] - b[i]);
+        return;
+    }
+
+    const double denom = 1.0 / (va + vb + vc);
+    const double v = vb * denom, w = vc * denom;
+    for (int i = 0; i < 3; ++i) out[i] = a[i] + ab[i] * v + ac[i] * w;
+}
+
+// 线段与三角形是否相交（Moller-Trumbore）
+bool segmentIntersectsTriangle(const double p0[3], const double p1[3], const double a[3], const double b[3], const double c[3])
+{
+    double dir[3], e1[3], e2[3], h[3];
+    sub3(p1, p0, dir);
+    sub3(b, a, e1);
+    sub3(c, a, e2);
+    cross3(dir, e2, h);
+    const double det = dot3(e1, h);
+    if (std::fabs(det) < kEpsilon) {
+        return false;
+    }
+    const double inv = 1.0 / det;
+    double s[3], qv[3];
+    sub3(p0, a, s);
+    const double u = inv * dot3(s, h);
+    if (u < 0 || u > 1) return false;
+    cross3(s, e1, qv);
+    const double v = inv * dot3(dir, qv);
+    if (v < 0 || u + v > 1) return false;
+    const double t = inv * dot3(e2, qv);
+    return t >= 0 && t <= 1;
+}
+
+double segmentTriangleDistance(const double p0[3], const double p1[3], const double a[3], const double b[3], const double c[3])
+{
+    if (segmentIntersectsTriangle(p0, p1, a, b, c)) {
+        return 0;
+    }
+    // 不相交时，最近点对必然出现在线段端点或三角形边上
+    double best = kInfinity;
+    double cp[3], diff[3];
+    closestPointOnTriangle(p0, a, b, c, cp);
+    sub3(p0, cp, diff);
+    best = std::min(best, dot3(diff, diff));
+    closestPointOnTriangle(p1, a, b, c, cp);
+    sub3(p1, cp, diff);
+    best = std::min(best, dot3(diff, diff));
+    best = std::min(best, segmentSegmentDistSq(p0, p1, a, b));
+    best = std::min(best, segmentSegmentDistSq(p0, p1, b, c));
+    best = std::min(best, segmentSegmentDistSq(p0, p1, c, a));
+    return std::sqrt(best);
+}
+
+// 点到轴对齐盒（以原点为中心）的距离平方
+double pointBoxDistSq(const double p[3], const double h[3])
+{
+    double sum = 0;
+    for (int i = 0; i < 3; ++i) {
+        const double d = std::fabs(p[i]) - h[i];
+        if (d > 0) sum += d * d;
+    }
+    return sum;
+}
+
+// 线段与轴对齐盒（以原点为中心）是否相交（slab法）
+bool segmentIntersectsBox(const double p0[3], const double p1[3], const double h[3])
+{
+    double tmin = 0, tmax = 1;
+    for (int i = 0; i < 3; ++i) {
+        const double d = p1[i] - p0[i];
+        if (std::fabs(d) < kEpsilon) {
+            if (p0[i] < -h[i] || p0[i] > h[i]) return false;
+        } else {
+            double t1 = (-h[i] - p0[i]) / d;
+            double t2 = (h[i] - p0[i]) / d;
+            if (t1 > t2) std::swap(t1, t2);
+            tmin = std::max(tmin, t1);
+            tmax = std::min(tmax, t2);
+            if (tmin > tmax) return false;
+        }
+    }
+    return true;
+}
+
+// 线段到盒体的距离（盒体局部坐标系）：不相交时，最近点对出现在线段端点或盒体的12条棱上
+double segmentBoxDistance(const double p0[3], const double p1[3], const double h[3])
+{
+    if (segmentIntersectsBox(p0, p1, h)) {
+        return 0;
+    }
+    double best = std::min(pointBoxDistSq(p0, h), pointBoxDistSq(p1, h));
+    for (int axis = 0; axis < 3; ++axis) {
+        const int u = (axis + 1) % 3, v = (axis + 2) % 3;
+        for (int k = 0; k < 4; ++k) {
+            double ea[3], eb[3];
+            ea[axis] = -h[axis];
+            eb[axis] = h[axis];
+            ea[u] = eb[u] = (k & 1) ? h[u] : -h[u];
+            ea[v] = eb[v] = (k & 2) ? h[v] : -h[v];
+            best = std::min(best, segmentSegmentDistSq(p0, p1, ea, eb));
+        }
+    }
+    return std::sqrt(best);
+}
+
+// 两个AABB之间的距离（下界）
+double boundsDistance(const double aMin[3], const double aMax[3], const double bMin[3], const double bMax[3])
+{
+    double sum = 0;
+    for (int i = 0; i < 3; ++i) {
+        const double d = std::max(aMin[i] - bMax[i], bMin[i] - aMax[i]);
+        if (d > 0) sum += d * d;
+    }
+    return std::sqrt(sum);
+}
+
+} // namespace
+
+CollisionChecker::CollisionChecker()
+    : endEffectorRadius(0.08)
+    , safetyMargin(0.01)
+{
+    // 连杆半径取关节球体半径，保证胶囊体包住3D模型中的关节和连杆
+    for (int i = 0; i < 3; ++i) {
+        linkRadius[i] = 0.05;
+    }
+}
+
+void CollisionChecker::addBox(const double center[3], const double halfExtents[3], const double *rotation)
+{
+    Box box;
+    static const double identity[9] = {1, 0, 0, 0, 1, 0, 0, 0, 1};
+    const double *R = rotation ? rotation : identity;
+    std::copy(center, center + 3, box.center);
+    std::copy(halfExtents, halfExtents + 3, box.halfExtents);
+    std::copy(R, R + 9, box.rotation);
+
+    Primitive prim;
+    prim.type = 0;
+    prim.index = boxes.size();
+    for (int i = 0; i < 3; ++i) {
+        // 旋转后盒体在世界坐标轴上的投影半长
+        const double extent = std::fabs(R[i * 3]) * halfExtents[0]
+                              + std::fabs(R[i * 3 + 1]) * halfExtents[1]
+                              + std::fabs(R[i * 3 + 2]) * halfExtents[2];
+        prim.boundsMin[i] = center[i] - extent;
+        prim.boundsMax[i] = center[i] + extent;
+    }
+    boxes.append(box);
+    primitives.append(prim);
+}
+
+void CollisionChecker::addMesh(const QVector<double> &vertices, const QVector<int> &indices)
+{
+    const int vertexCount = vertices.size() / 3;
+    for (int t = 0; t + 2 < indices.size(); t += 3) {
+        Triangle tri;
+        bool valid = true;
+        for (int k = 0; k < 3; ++k) {
+            const int idx = indices[t + k];
+            if (idx < 0 || idx >= vertexCount) {
+                valid = false;
+                break;
+            }
+            for (int i = 0; i < 3; ++i) {
+                tri.v[k][i] = vertices[idx * 3 + i];
+            }
+        }
+        if (!valid) {
+            continue;
+        }
+
+        Primitive prim;
+        prim.type = 1;
+        prim.index = triangles.size();
+        for (int i = 0; i < 3; ++i) {
+            prim.boundsMin[i] = std::min({tri.v[0][i], tri.v[1][i], tri.v[2][i]});
+            prim.boundsMax[i] = std::max({tri.v[0][i], tri.v[1][i], tri.v[2][i]});
+        }
+        triangles.append(tri);
+        primitives.append(prim);
+    }
+}
+
+void CollisionChecker::clearEnvironment()
+{
+    boxes.clear();
+    triangles.clear();
+    primitives.clear();
+    nodes.clear();
+}
+
+bool CollisionChecker::loadEnvironment(const QString &fileName, bool *defaults)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        error = QString("无法打开工作单元文件%1：%2").arg(fileName, file.errorString());
+        return false;
+    }
+    QJsonParseError parseError;
+    const QJsonDocument document = QJsonDocument::fromJson(file.readAll(), &parseError);
+    if (!document.isObject()) {
+        error = QString("工作单元文件%1格式错误：%2").arg(fileName, parseError.errorString());
+        return false;
+    }
+    const QJsonObject root = document.object();
+    if (defaults) {
+        *defaults = root.value("defaults").toBool(true);
+    }
+
+    static const double identity[9] = {1, 0, 0, 0, 1, 0, 0, 0, 1};
+    const QJsonArray boxArray = root.value("boxes").toArray();
+    for (int b = 0; b < boxArray.size(); ++b) {
+        const QJsonObject box = boxArray.at(b).toObject();
+        double center[3] = {0, 0, 0}, halfExtents[3] = {0, 0, 0}, rotation[9];
+        std::copy(identity, identity + 9, rotation);
+        if (!box.contains("center") || !box.contains("halfExtents") || !readJsonNumbers(box, "center", center, 3)
+            || !readJsonNumbers(box, "halfExtents", halfExtents, 3) || !readJsonNumbers(box, "rotation", rotation, 9)) {
+            error = QString("工作单元文件%1：第%2个包围盒的center、halfExtents或rotation无效").arg(fileName).arg(b + 1);
+            return false;
+        }
+        addBox(center, halfExtents, rotation);
+    }
+
+    const QDir baseDir = QFileInfo(fileName).absoluteDir();
+    const QJsonArray meshArray = root.value("meshes").toArray();
+    for (int m = 0; m < meshArray.size(); ++m) {
+        const QJsonObject mesh = meshArray.at(m).toObject();
+        double rotation[9], translation[3] = {0, 0, 0};
+        std::copy(identity, identity + 9, rotation);
+        const double scale = mesh.value("scale").toDouble(1.0);
+        if (!readJsonNumbers(mesh, "rotation", rotation, 9) || !readJsonNumbers(mesh, "translation", translation, 3)) {
+            error = QString("工作单元文件%1：第%2个网格的rotation或translation无效").arg(fileName).arg(m + 1);
+            return false;
+        }
+
+        const QString meshFile = baseDir.absoluteFilePath(mesh.value("file").toString());
+        MeshStreamReader reader;
+        if (!reader.open(meshFile)) {
+            error = reader.errorString();
+            return false;
+        }
+        // 每个三角形独立存3个顶点，夹具网格一般只有几千到几万个三角形
+        QVector<double> vertices;
+        QVector<int> indices;
+        float buffer[256 * 9];
+        int count;
+        while ((count = reader.read(buffer, 256)) > 0) {
+            for (int v = 0; v < count * 3; ++v) {
+                const float *p = buffer + v * 3;
+                for (int i = 0; i < 3; ++i) {
+                    vertices.append(scale * (rotation[i * 3] * p[0] + rotation[i * 3 + 1] * p[1] + rotation[i * 3 + 2] * p[2])
+                                    + translation[i]);
+                }
+                indices.append(indices.size());
+            }
+        }
+        if (!reader.errorString().isEmpty()) {
+            error = reader.errorString();
+            return false;
+        }
+        addMesh(vertices, indices);
+    }
+    return true;
+}
+
+bool CollisionChecker::setupDefaultEnvironment()
+{
+    clearEnvironment();
+    error.clear();
+
+    bool ok = true;
+    bool defaults = true;
+    const QString cellFile = QCoreApplication::applicationDirPath() + "/cell.json";
+    if (QFile::exists(cellFile)) {
+        ok = loadEnvironment(cellFile, &defaults);
+        if (!ok) {
+            // 不使用只加载了一部分的夹具
+            clearEnvironment();
+            defaults = true;
+        }
+    }
+
+    if (defaults) {
+        // 地面：机械臂基座安装高度按1.5米估计（关节1原点在z=0），现场布置不同时在cell.json中关闭默认项并自行描述
+        const double floorCenter[3] = {0.0, 0.0, -1.6};
+        const double floorHalfExtents[3] = {5.0, 5.0, 0.1};
+        addBox(floorCenter, floorHalfExtents);
+        // 底座立柱：从地面到关节1下方，顶面比连杆1的胶囊体（半径0.05）再低0.05，任何构型下连杆1都不与其接触，
+        // 大臂、小臂向下穿过立柱的构型则被判为碰撞
+        const double pedestalCenter[3] = {0.0, 0.0, -0.8};
+        const double pedestalHalfExtents[3] = {0.15, 0.15, 0.7};
+        addBox(pedestalCenter, pedestalHalfExtents);
+    }
+    build();
+    return ok;
+}
+
+void CollisionChecker::build()
+{
+    nodes.clear();
+    if (primitives.isEmpty()) {
+        return;
+    }
+    nodes.reserve(2 * primitives.size());
+    nodes.append(Node());
+    buildNode(0, 0, primitives.size());
+}
+
+void CollisionChecker::buildNode(int nodeIndex, int begin, int end)
+{
+    Node node;
+    double centroidMin[3], centroidMax[3];
+    for (int i = 0; i < 3; ++i) {
+        node.boundsMin[i] = centroidMin[i] = kInfinity;
+        node.boundsMax[i] = centroidMax[i] = -kInfinity;
+    }
+    for (int p = begin; p < end; ++p) {
+        const Primitive &prim = primitives[p];
+        for (int i = 0; i < 3; ++i) {
+            const double c = 0.5 * (prim.boundsMin[i] + prim.boundsMax[i]);
+            node.boundsMin[i] = std::min(node.boundsMin[i], prim.boundsMin[i]);
+            node.boundsMax[i] = std::max(node.boundsMax[i], prim.boundsMax[i]);
+            centroidMin[i] = std::min(centroidMin[i], c);
+            centroidMax[i] = std::max(centroidMax[i], c);
+        }
+    }
+
+    // 叶节点最多存放4个图元
+    if (end - begin <= 4) {
+        node.first = begin;
+        node.count = end - begin;
+        nodes[nodeIndex] = node;
+        return;
+    }
+
+    // 沿质心分布最长的轴按中位数划分
+    int axis = 0;
+    for (int i = 1; i < 3; ++i) {
+        if (centroidMax[i] - centroidMin[i] > centroidMax[axis] - centroidMin[axis]) {
+            axis = i;
+        }
+    }
+    const int mid = (begin + end) / 2;
+    std::nth_element(primitives.begin() + begin, primitives.begin() + mid, primitives.begin() + end,
+                     [axis](const Primitive &a, const Primitive &b) {
+                         return a.boundsMin[axis] + a.boundsMax[axis] < b.boundsMin[axis] + b.boundsMax[axis];
+                     });
+
+    const int left = nodes.size();
+    nodes.append(Node());
+    nodes.append(Node());
+    node.first = left;
+    node.count = 0;
+    nodes[nodeIndex] = node;
+    buildNode(left, begin, mid);
+    buildNode(left + 1, mid, end);
+}
+
+void CollisionChecker::setLinkRadius(int link, double radius)
+{
+    if (link >= 0 && link < 3) {
+        linkRadius[link] = radius;
+    }
+}
+
+void CollisionChecker::setEndEffectorRadius(double radius)
+{
+    endEffectorRadius = radius;
+}
+
+void CollisionChecker::setSafetyMargin(double margin)
+{
+    safetyMargin = margin;
+}
+
+void CollisionChecker::armCapsules(const double q[4], Capsule capsules[ArmCapsuleCount]) const
+{
+    double frames[4][16];
+    ArmKinematics::jointFrames(q, frames);
+
+    // 与3D模型一致：连杆连接相邻关节原点，末端执行器位于T04原点
+    for (int i = 0; i < 3; ++i) {
+        for (int k = 0; k < 3; ++k) {
+            capsules[i].p0[k] = frames[i][k * 4 + 3];
+            capsules[i].p1[k] = frames[i + 1][k * 4 + 3];
+        }
+        capsules[i].radius = linkRadius[i];
+    }
+    for (int k = 0; k < 3; ++k) {
+        capsules[3].p0[k] = capsules[3].p1[k] = frames[3][k * 4 + 3];
+    }
+    capsules[3].radius = endEffectorRadius;
+}
+
+double CollisionChecker::primitiveDistance(const Primitive &prim, const double p0[3], const double p1[3]) const
+{
+    if (prim.type == 1) {
+        const Triangle &tri = triangles[prim.index];
+        return segmentTriangleDistance(p0, p1, tri.v[0], tri.v[1], tri.v[2]);
+    }
+
+    // 将线段变换到盒体局部坐标系：local = R^T * (p - c)
+    const Box &box = boxes[prim.index];
+    double l0[3], l1[3];
+    for (int i = 0; i < 3; ++i) {
+        l0[i] = l1[i] = 0;
+        for (int k = 0; k < 3; ++k) {
+            l0[i] += box.rotation[k * 3 + i] * (p0[k] - box.center[k]);
+            l1[i] += box.rotation[k * 3 + i] * (p1[k] - box.center[k]);
+        }
+    }
+    return segmentBoxDistance(l0, l1, box.halfExtents);
+}
+
+double CollisionChecker::environmentDistance(const Capsule &capsule, double ignoreAbove, double stopBelow) const
+{
+    if (nodes.isEmpty()) {
+        return ignoreAbove;
+    }
+
+    double segMin[3], segMax[3];
+    for (int i = 0; i < 3; ++i) {
+        segMin[i] = std::min(capsule.p0[i], capsule.p1[i]);
+        segMax[i] = std::max(capsule.p0[i], capsule.p1[i]);
+    }
+
+    double best = ignoreAbove;
+    int stack[64];
+    int top = 0;
+    stack[top++] = 0;
+    while (top > 0) {
+        const Node &node = nodes[stack[--top]];
+        if (boundsDistance(segMin, segMax, node.boundsMin, node.boundsMax) - capsule.radius >= best) {
+            continue;
+        }
+
+        if (node.count > 0) {
+            for (int p = node.first; p < node.first + node.count; ++p) {
+                const Primitive &prim = primitives[p];
+                if (boundsDistance(segMin, segMax, prim.boundsMin, prim.boundsMax) - capsule.radius >= best) {
+                    continue;
+                }
+                const double d = primitiveDistance(prim, capsule.p0, capsule.p1) - capsule.radius;
+                if (d < best) {
+                    best = d;
+                    if (best < stopBelow) {
+                        return best;
+                    }
+                }
+            }
+            continue;
+        }
+
+        // 先访问较近的子节点，使剪枝更早生效
+        const Node &left = nodes[node.first];
+        const Node &right = nodes[node.first + 1];
+        const double dl = boundsDistance(segMin, segMax, left.boundsMin, left.boundsMax);
+        const double dr = boundsDistance(segMin, segMax, right.boundsMin, right.boundsMax);
+        if (dl <= dr) {
+            stack[top++] = node.first + 1;
+            stack[top++] = node.first;
+        } else {
+            stack[top++] = node.first;
+            stack[top++] = node.first + 1;
+        }
+    }
+    return best;
+}
+
+double CollisionChecker::selfDistance(const Capsule capsules[ArmCapsuleCount]) const
+{
+    double best = kInfinity;
+    for (const auto &pair : kSelfPairs) {
+        const Capsule &a = capsules[pair[0]];
+        const Capsule &b = capsules[pair[1]];
+        const double d = std::sqrt(segmentSegmentDistSq(a.p0, a.p1, b.p0, b.p1)) - a.radius - b.radius;
+        best = std::min(best, d);
+    }
+    return best;
+}
+
+double CollisionChecker::capsuleDistance(const Capsule &a, const Capsule &b)
+{
+    return std::sqrt(segmentSegmentDistSq(a.p0, a.p1, b.p0, b.p1)) - a.radius - b.radius;
+}
+
+bool CollisionChecker::isFree(const double q[4]) const
+{
+    Capsule capsules[ArmCapsuleCount];
+    armCapsules(q, capsules);
+    if (selfDistance(capsules) < safetyMargin) {
+        return false;
+    }
+    for (const Capsule &capsule : capsules) {
+        if (environmentDistance(capsule, safetyMargin, safetyMargin) < safetyMargin) {
+            return false;
+        }
+    }
+    return true;
+}
+
+double CollisionChecker::minDistance(const double q[4]) const
+{
+    Capsule capsules[ArmCapsuleCount];
+    armCapsules(q, capsules);
+    double best = selfDistance(capsules);
+    for (const Capsule &capsule : capsules) {
+        best = std::min(best, environmentDistance(capsule, best, -kInfinity));
+    }
+    return best;
+}
+
+double CollisionChecker::environmentMinDistance(const double q[4]) const
+{
+    Capsule capsules[ArmCapsuleCount];
+    armCapsules(q, capsules);
+    double best = kInfinity;
+    for (const Capsule &capsule : capsules) {
+        best = std::min(best, environmentDistance(capsule, best, -kInfinity));
+    }
+    return best;
+}
+
+void CollisionChecker::runBatch(const double *q, int count, bool *freeResult, double *distanceResult) const
+{
+    // SoA布局：pos[capsule][端点*3+分量][构型]
+    double pos[ArmCapsuleCount][6][kBatchBlock];
+    double radius[ArmCapsuleCount];
+    double selfDist[kBatchBlock];
+
+    for (int base = 0; base < count; base += kBatchBlock) {
+        const int n = std::min(kBatchBlock, count - base);
+
+        for (int k = 0; k < n; ++k) {
+            Capsule capsules[ArmCapsuleCount];
+            armCapsules(q + 4 * (base + k), capsules);
+            for (int c = 0; c < ArmCapsuleCount; ++c) {
+                for (int i = 0; i < 3; ++i) {
+                    pos[c][i][k] = capsules[c].p0[i];
+                    pos[c][3 + i][k] = capsules[c].p1[i];
+                }
+                radius[c] = capsules[c].radius;
+            }
+        }
+
+        // 自碰撞：对块内所有构型做同一对胶囊体的距离计算，数据连续访问
+        // 注：std::sqrt在默认的-fmath-errno下要设置errno，平行判断也是分支，GCC即使加-fno-math-errno也不会自动向量化这个循环
+        for (int k = 0; k < n; ++k) {
+            selfDist[k] = kInfinity;
+        }
+        for (const auto &pair : kSelfPairs) {
+            const double (*a)[kBatchBlock] = pos[pair[0]];
+            const double (*b)[kBatchBlock] = pos[pair[1]];
+            const double radiusSum = radius[pair[0]] + radius[pair[1]];
+            for (int k = 0; k < n; ++k) {
+                const double d = std::sqrt(segmentSegmentDistSq(a[0][k], a[1][k], a[2][k], a[3][k], a[4][k], a[5][k],
+                                                                b[0][k], b[1][k], b[2][k], b[3][k], b[4][k], b[5][k]))
+                                 - radiusSum;
+                selfDist[k] = std::min(selfDist[k], d);
+            }
+        }
+
+        // 环境碰撞：逐构型遍历BVH，自碰撞已判定的构型直接跳过
+        for (int k = 0; k < n; ++k) {
+            Capsule capsule;
+            if (freeResult) {
+                bool free = selfDist[k] >= safetyMargin;
+                for (int c = 0; free && c < ArmCapsuleCount; ++c) {
+                    for (int i = 0; i < 3; ++i) {
+                        capsule.p0[i] = pos[c][i][k];
+                        capsule.p1[i] = pos[c][3 + i][k];
+                    }
+                    capsule.radius = radius[c];
+                    free = environmentDistance(capsule, safetyMargin, safetyMargin) >= safetyMargin;
+                }
+                freeResult[base + k] = free;
+            }
+            if (distanceResult) {
+                double best = selfDist[k];
+                for (int c = 0; c < ArmCapsuleCount; ++c) {
+                    for (int i = 0; i < 3; ++i) {
+                        capsule.p0[i] = pos[c][i][k];
+                        capsule.p1[i] = pos[c][3 + i][k];
+                    }
+                    capsule.radius = radius[c];
+                    best = std::min(best, environmentDistance(capsule, best, -kInfinity));
+                }
+                distanceResult[base + k] = best;
+            }
+        }
+    }
+}
+
+void CollisionChecker::isFreeBatch(const double *q, int count, bool *result) const
+{
+    if (count <= kTaskSize) {
+        runBatch(q, count, result, nullptr);
+        return;
+    }
+    QVector<int> starts;
+    for (int s = 0; s < count; s += kTaskSize) {
+        starts.append(s);
+    }
+    QtConcurrent::blockingMap(starts, [=](int start) {
+        runBatch(q + 4 * start, std::min(kTaskSize, count - start), result + start, nullptr);
+    });
+}
+
+void CollisionChecker::minDistanceBatch(const double *q, int count, double *result) const
+{
+    if (count <= kTaskSize) {
+        runBatch(q, count, nullptr, result);
+        return;
+    }
+    QVector<int> starts;
+    for (int s = 0; s < count; s += kTaskSize) {
+        starts.append(s);
+    }
+    QtConcurrent::blockingMap(starts, [=](int start) {
+        runBatch(q + 4 * start, std::min(kTaskSize, count - start), nullptr, result + start);
+    });
+}
+
+bool CollisionChecker::isMotionFree(const double qa[4], const double qb[4], double step) const
+{
+    double maxDelta = 0;
+    for (int i = 0; i < 4; ++i) {
+        maxDelta = std::max(maxDelta, std::fabs(qb[i] - qa[i]));
+    }
+    const int steps = std::max(1, int(std::ceil(maxDelta / std::max(step, 1e-6))));
+    for (int s = 0; s <= steps; ++s) {
+        const double t = double(s) / steps;
+        double q[4];
+        for (int i = 0; i < 4; ++i) {
+            q[i] = qa[i] + t * (qb[i] - qa[i]);
+        }
+        if (!isFree(q)) {
+            return false;
+        }
+    }
+    return true;
+}
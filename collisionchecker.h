@@ -0,0 +1,120 @@
+#ifndef COLLISIONCHECKER_H
+#define COLLISIONCHECKER_H
+
+#include <QString>
+#include <QVector>
+
+// 碰撞检测：机械臂连杆用胶囊体表示，工作单元（夹具、地面等）用
+// 有向包围盒和三角网格表示，并组织成静态BVH（包围体层次树）
+class CollisionChecker
+{
+public:
+    // 胶囊体：线段p0-p1加半径
+    struct Capsule
+    {
+        double p0[3];
+        double p1[3];
+        double radius;
+    };
+
+    // 机械臂胶囊体：3个连杆 + 末端执行器（退化为球体）
+    enum { ArmCapsuleCount = 4 };
+
+    CollisionChecker();
+
+    // 添加有向包围盒，rotation为行优先3x3旋转矩阵（局部到世界），为空表示不旋转
+    void addBox(const double center[3], const double halfExtents[3], const double *rotation = nullptr);
+    // 添加三角网格，vertices按xyz连续存储，indices每3个为一个三角形
+    void addMesh(const QVector<double> &vertices, const QVector<int> &indices);
+    void clearEnvironment();
+    // 添加完环境后调用，构建BVH
+    void build();
+    // 从工作单元描述文件（JSON）添加包围盒和网格，不清空已有环境，也不构建BVH
+    // 格式：{"boxes": [{"center": [x,y,z], "halfExtents": [x,y,z], "rotation": [行优先9个数，可省略]}],
+    //        "meshes": [{"file": "夹具.stl", "scale": 1, "rotation": [...], "translation": [x,y,z]}],
+    //        "defaults": true}
+    // 网格文件按MeshStreamReader读取，相对路径相对于描述文件所在目录；scale、rotation、translation可省略，
+    // 顶点先缩放、再旋转、再平移到基坐标系（米）；defaults（可为空）返回文件中的defaults项，
+    // 为false时setupDefaultEnvironment不添加地面和底座
+    bool loadEnvironment(const QString &fileName, bool *defaults = nullptr);
+    // 默认工作单元（界面和命令行工具共用）：清空环境，添加地面和关节1下方的底座，
+    // 程序目录下存在cell.json（与arm_model.json同目录）时再加入其中的夹具，最后构建BVH
+    // 描述文件读取失败时仍构建地面和底座并返回false，原因见errorString
+    bool setupDefaultEnvironment();
+    QString errorString() const { return error; }
+
+    // 胶囊体半径（单位：米），默认与3D模型中关节球和末端球的尺寸一致
+    void setLinkRadius(int link, double radius);
+    void setEndEffectorRadius(double radius);
+    // 安全距离：距离小于该值也视为碰撞
+    void setSafetyMargin(double margin);
+
+    // 计算给定关节角下机械臂的胶囊体
+    void armCapsules(const double q[4], Capsule capsules[ArmCapsuleCount]) const;
+    // 两个胶囊体的表面距离，小于等于0表示已穿透（多机器人之间的检测使用）
+    static double capsuleDistance(const Capsule &a, const Capsule &b);
+
+    // 单个构型是否无碰撞（自碰撞 + 环境碰撞）
+    bool isFree(const double q[4]) const;
+    // 最小表面距离（自碰撞对和环境取最小），小于等于0表示已穿透
+    double minDistance(const double q[4]) const;
+    // 只计算与环境的最小表面距离（不含自碰撞）
+    double environmentMinDistance(const double q[4]) const;
+
+    // 批量查询，q按每4个关节角连续存储，多线程执行
+    void isFreeBatch(const double *q, int count, bool *result) const;
+    void minDistanceBatch(const double *q, int count, double *result) const;
+
+    // 路径校验：按关节空间最大步长step插值检查qa到qb的直线运动
+    bool isMotionFree(const double qa[4], const double qb[4], double step = 0.02) const;
+
+private:
+    struct Box
+    {
+        double center[3];
+        double halfExtents[3];
+        double rotation[9];
+    };
+
+    struct Triangle
+    {
+        double v[3][3];
+    };
+
+    // 图元：type为0表示包围盒，1表示三角形
+    struct Primitive
+    {
+        int type;
+        int index;
+        double boundsMin[3];
+        double boundsMax[3];
+    };
+
+    // BVH节点：count>0为叶节点，图元范围[first, first+count)；否则first为左子节点，first+1为右子节点
+    struct Node
+    {
+        double boundsMin[3];
+        double boundsMax[3];
+        int first;
+        int count;
+    };
+
+    void buildNode(int nodeIndex, int begin, int end);
+    double primitiveDistance(const Primitive &prim, const double p0[3], const double p1[3]) const;
+    // 胶囊体到环境的表面距离：只关心小于ignoreAbove的图元，一旦小于stopBelow立即返回
+    double environmentDistance(const Capsule &capsule, double ignoreAbove, double stopBelow) const;
+    double selfDistance(const Capsule capsules[ArmCapsuleCount]) const;
+    void runBatch(const double *q, int count, bool *freeResult, double *distanceResult) const;
+
+    QVector<Box> boxes;
+    QVector<Triangle> triangles;
+    QVector<Primitive> primitives;
+    QVector<Node> nodes;
+    QString error;
+
+    double linkRadius[3];
+    double endEffectorRadius;
+    double safetyMargin;
+};
+
+#endif // COLLISIONCHECKER_H
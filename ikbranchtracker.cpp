@@ -0,0 +1,142 @@
+#include "ikbranchtracker.h"
+#include "armkinematics.h"
+#include "metrics.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+// 在限位内取与reference最接近的等价角（关节1为±180°、关节4为±210°，等价角可能有两个）
+double nearestEquivalent(double angle, double reference, double lo, double hi)
+{
+    double best = angle;
+    for (const double wrap : {-2 * M_PI, 2 * M_PI}) {
+        const double alt = angle + wrap;
+        if (alt >= lo && alt <= hi && std::fabs(alt - reference) < std::fabs(best - reference)) {
+            best = alt;
+        }
+    }
+    return best;
+}
+
+} // namespace
+
+IkBranchTracker::IkBranchTracker()
+    : previousBranch(-1)
+    , havePrevious(false)
+{
+    std::fill(previousQ, previousQ + 4, 0.0);
+}
+
+void IkBranchTracker::reset()
+{
+    stat = Stats();
+    previousBranch = -1;
+    havePrevious = false;
+    std::fill(previousQ, previousQ + 4, 0.0);
+}
+
+void IkBranchTracker::reset(const double q[4])
+{
+    reset();
+    std::copy(q, q + 4, previousQ);
+    havePrevious = true;
+}
+
+bool IkBranchTracker::solve(const double T[16], const double *reference, Result &result) const
+{
+    double solutions[8][4];
+    unsigned clampedMask = 0;
+    ArmKinematics::inverse(T, solutions, &clampedMask);
+
+    const ArmKinematics::MdhParams &params = ArmKinematics::activeParams();
+    const double zt[3] = {T[2], T[6], T[10]};
+
+    double bestScore = std::numeric_limits<double>::max();
+    result.branch = -1;
+    // 下标最低位的两组解只是关节4相差180°（x轴反向），只需检查偶数下标
+    for (int k = 0; k < 8; k += 2) {
+        if (clampedMask & (1u << k)) {
+            continue;
+        }
+        double q[4] = {solutions[k][0], solutions[k][1], solutions[k][2], solutions[k][3]};
+        if (!std::isfinite(q[0]) || !std::isfinite(q[1]) || !std::isfinite(q[2]) || !std::isfinite(q[3])) {
+            continue;
+        }
+
+        double frames[4][16];
+        ArmKinematics::jointFrames(params, q, frames);
+        const double *F = frames[3];
+        const double dx = F[3] - T[3], dy = F[7] - T[7], dz = F[11] - T[11];
+        const double positionError = std::sqrt(dx * dx + dy * dy + dz * dz);
+        const double cosApproach = F[2] * zt[0] + F[6] * zt[1] + F[10] * zt[2];
+        const double orientationError = std::acos(qBound(-1.0, cosApproach, 1.0));
+        if (!(positionError <= opts.positionTolerance) || !(orientationError <= opts.orientationTolerance)) {
+            continue;
+        }
+
+        double score = 0;
+        double maxStep = 0;
+        if (reference) {
+            for (int j = 0; j < 4; ++j) {
+                q[j] = nearestEquivalent(q[j], reference[j], ArmKinematics::jointMin[j], ArmKinematics::jointMax[j]);
+                const double step = std::fabs(q[j] - reference[j]);
+                score += opts.weights[j] * step * step;
+                maxStep = std::max(maxStep, step);
+            }
+        } else {
+            double margin = M_PI;
+            for (int j = 0; j < 4; ++j) {
+                margin = std::min(margin, std::min(q[j] - ArmKinematics::jointMin[j], ArmKinematics::jointMax[j] - q[j]));
+            }
+            score = -margin;
+        }
+        if (!ArmKinematics::withinLimits(q) || score >= bestScore) {
+            continue;
+        }
+
+        bestScore = score;
+        std::copy(q, q + 4, result.q);
+        result.branch = k;
+        result.distance = reference ? std::sqrt(score) : 0.0;
+        result.maxJointStep = maxStep;
+        result.positionError = positionError;
+        result.orientationError = orientationError;
+    }
+    return result.branch >= 0;
+}
+
+bool IkBranchTracker::track(const double T[16], Result &result)
+{
+    static Metrics::Counter *samples = Metrics::counter("arm_ik_track_total", "逆解分支跟踪的采样点数");
+    static Metrics::Counter *failures = Metrics::counter("arm_ik_track_failures_total", "逆解分支跟踪中没有有效解的采样点数");
+    static Metrics::Counter *switches = Metrics::counter("arm_ik_track_branch_switches_total", "逆解分支跟踪中的分支切换次数");
+    static Metrics::Counter *jumps = Metrics::counter("arm_ik_track_discontinuities_total", "逆解分支跟踪中关节角不连续的次数");
+    samples->add();
+    ++stat.samples;
+    if (!solve(T, havePrevious ? previousQ : nullptr, result)) {
+        failures->add();
+        ++stat.failures;
+        result.branchSwitched = false;
+        result.discontinuous = false;
+        return false;
+    }
+
+    result.branchSwitched = previousBranch >= 0 && result.branch != previousBranch;
+    result.discontinuous = havePrevious && result.maxJointStep > opts.jumpThreshold;
+    if (result.branchSwitched) {
+        switches->add();
+        ++stat.branchSwitches;
+    }
+    if (result.discontinuous) {
+        jumps->add();
+        ++stat.discontinuities;
+    }
+    stat.maxJointStep = std::max(stat.maxJointStep, result.maxJointStep);
+
+    std::copy(result.q, result.q + 4, previousQ);
+    previousBranch = result.branch;
+    havePrevious = true;
+    return true;
+}
@@ -0,0 +1,70 @@
+#ifndef IKBRANCHTRACKER_H
+#define IKBRANCHTRACKER_H
+
+#include <QtGlobal>
+
+// 逆解分支跟踪：对连续到来的目标位姿，在解析逆解中选取与上一构型最接近的有效解，
+// 用于设定值流等需要逐点自动选解的场合（界面上的逆解表格仍由用户选择）。
+// 有效解：关节1-3未被限位截断，且正解与目标的位置误差、接近方向误差都在容差内。
+// 解析逆解中关节4相差180°的两组解x轴相反，只有一组与目标一致，因此只有4个不同的分支。
+// 全部计算在栈上完成，不分配内存，每个采样点耗时为微秒级
+class IkBranchTracker
+{
+public:
+    struct Options
+    {
+        double weights[4] = {1.0, 1.0, 1.0, 0.5}; // 关节距离权重（腕部转动的代价较小）
+        double positionTolerance = 1e-3;          // 正解位置误差上限（米）
+        double orientationTolerance = 1e-2;       // 正解接近方向误差上限（弧度）
+        double jumpThreshold = 0.1;               // 相邻两点任一关节变化超过该值（弧度）记为不连续
+    };
+
+    struct Result
+    {
+        double q[4];
+        int branch = -1;            // t1分支*4 + t3分支*2，与ArmKinematics::inverse的解序号对应，-1表示无有效解
+        bool branchSwitched = false;
+        bool discontinuous = false;
+        double distance = 0;        // 与上一构型的加权距离
+        double maxJointStep = 0;    // 与上一构型相比变化最大的关节的变化量（弧度）
+        double positionError = 0;   // 米
+        double orientationError = 0; // 接近方向夹角（弧度）
+    };
+
+    struct Stats
+    {
+        quint64 samples = 0;
+        quint64 failures = 0;        // 没有有效解的采样点
+        quint64 branchSwitches = 0;
+        quint64 discontinuities = 0;
+        double maxJointStep = 0;
+    };
+
+    IkBranchTracker();
+
+    void setOptions(const Options &options) { opts = options; }
+    const Options &options() const { return opts; }
+
+    // 清空上一构型和统计；没有上一构型时第一点取距限位最远的有效解
+    void reset();
+    // 以q为上一构型开始新的跟踪
+    void reset(const double q[4]);
+
+    // 返回false表示没有有效解，此时上一构型保持不变
+    bool track(const double T[16], Result &result);
+    // 无状态选解：reference为空时取距限位最远的有效解
+    bool solve(const double T[16], const double *reference, Result &result) const;
+
+    bool hasPrevious() const { return havePrevious; }
+    const double *previous() const { return previousQ; }
+    const Stats &stats() const { return stat; }
+
+private:
+    Options opts;
+    Stats stat;
+    double previousQ[4];
+    int previousBranch;
+    bool havePrevious;
+};
+
+#endif // IKBRANCHTRACKER_H
@@ -0,0 +1,409 @@
+#include "ikseeddatabase.h"
+#include "metrics.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+const char kMagic[8] = {'I', 'K', 'S', 'E', 'E', 'D', 'D', 'B'};
+const quint32 kVersion = 2; // 2：增加modelHash
+const int kMaxNeighbors = 16;
+
+struct FileHeader
+{
+    char magic[8];
+    quint32 version;
+    quint32 entrySize;
+    quint32 count;
+    quint32 resolution;
+    quint64 modelHash;
+};
+
+const int kKeySize = IkSeedDatabase::KeySize;
+
+double keyDistance(const double a[kKeySize], const float b[kKeySize])
+{
+    double sum = 0;
+    for (int i = 0; i < kKeySize; ++i) {
+        const double d = a[i] - b[i];
+        sum += d * d;
+    }
+    return sum;
+}
+
+// 4x4线性方程组求解（列主元高斯消元）
+bool solve4(double A[4][4], double b[4], double x[4])
+{
+    for (int col = 0; col < 4; ++col) {
+        int pivot = col;
+        for (int row = col + 1; row < 4; ++row) {
+            if (std::fabs(A[row][col]) > std::fabs(A[pivot][col])) pivot = row;
+        }
+        if (std::fabs(A[pivot][col]) < 1e-15) return false;
+        if (pivot != col) {
+            for (int k = 0; k < 4; ++k) std::swap(A[col][k], A[pivot][k]);
+            std::swap(b[col], b[pivot]);
+        }
+        for (int row = col + 1; row < 4; ++row) {
+            const double f = A[row][col] / A[col][col];
+            for (int k = col; k < 4; ++k) A[row][k] -= f * A[col][k];
+            b[row] -= f * b[col];
+        }
+    }
+    for (int row = 3; row >= 0; --row) {
+        double sum = b[row];
+        for (int k = row + 1; k < 4; ++k) sum -= A[row][k] * x[k];
+        x[row] = sum / A[row][row];
+    }
+    return true;
+}
+
+void residualAt(const double target[kKeySize], const double q[4], double r[kKeySize])
+{
+    double T[16], key[kKeySize];
+    ArmKinematics::forward(q, T);
+    IkSeedDatabase::poseKey(T, key);
+    for (int i = 0; i < kKeySize; ++i) {
+        r[i] = key[i] - target[i];
+    }
+}
+
+double residualNorm(const double r[kKeySize])
+{
+    double sum = 0;
+    for (int i = 0; i < kKeySize; ++i) sum += r[i] * r[i];
+    return std::sqrt(sum);
+}
+
+} // namespace
+
+const double IkSeedDatabase::orientationWeight = 0.5;
+
+IkSeedDatabase::IkSeedDatabase()
+    : entries(nullptr)
+    , count(0)
+    , resolution(0)
+    , model(0)
+{
+}
+
+IkSeedDatabase::~IkSeedDatabase()
+{
+    clear();
+}
+
+void IkSeedDatabase::clear()
+{
+    if (mappedFile.isOpen()) {
+        mappedFile.close(); // 关闭时自动解除映射
+    }
+    ownedEntries.clear();
+    entries = nullptr;
+    count = 0;
+    resolution = 0;
+    model = 0;
+}
+
+void IkSeedDatabase::poseKey(const double T[16], double key[KeySize])
+{
+    key[0] = T[3];
+    key[1] = T[7];
+    key[2] = T[11];
+    // 关节4绕末端z轴转动，只用接近方向无法区分，因此同时记录x轴方向
+    key[3] = orientationWeight * T[2];
+    key[4] = orientationWeight * T[6];
+    key[5] = orientationWeight * T[10];
+    key[6] = orientationWeight * T[0];
+    key[7] = orientationWeight * T[4];
+    key[8] = orientationWeight * T[8];
+}
+
+quint64 IkSeedDatabase::modelHash(const ArmKinematics::MdhParams &params)
+{
+    double v[16];
+    ArmKinematics::paramsToVector(params, v);
+    const unsigned char *bytes = reinterpret_cast<const unsigned char *>(v);
+    quint64 hash = 14695981039346656037ull;
+    for (size_t i = 0; i < sizeof(v); ++i) {
+        hash = (hash ^ bytes[i]) * 1099511628211ull;
+    }
+    return hash;
+}
+
+void IkSeedDatabase::build(int res)
+{
+    clear();
+    res = qBound(2, res, int(MaxResolution));
+    const int total = res * res * res * res;
+    ownedEntries.resize(total);
+
+    int n = 0;
+    double q[4], T[16], key[KeySize];
+    for (int i0 = 0; i0 < res; ++i0) {
+        for (int i1 = 0; i1 < res; ++i1) {
+            for (int i2 = 0; i2 < res; ++i2) {
+                for (int i3 = 0; i3 < res; ++i3) {
+                    const int idx[4] = {i0, i1, i2, i3};
+                    for (int j = 0; j < 4; ++j) {
+                        q[j] = ArmKinematics::jointMin[j]
+                               + (ArmKinematics::jointMax[j] - ArmKinematics::jointMin[j]) * idx[j] / (res - 1);
+                    }
+                    ArmKinematics::forward(q, T);
+                    poseKey(T, key);
+                    Entry &e = ownedEntries[n++];
+                    for (int k = 0; k < KeySize; ++k) e.key[k] = float(key[k]);
+                    for (int k = 0; k < 4; ++k) e.q[k] = float(q[k]);
+                    e.axis = 0;
+                }
+            }
+        }
+    }
+
+    buildTree(0, total);
+    entries = ownedEntries.constData();
+    count = total;
+    resolution = res;
+    model = modelHash(ArmKinematics::activeParams());
+}
+
+void IkSeedDatabase::buildTree(int begin, int end)
+{
+    if (end - begin <= 1) {
+        return;
+    }
+
+    // 选取跨度最大的维度，中位数节点放在区间中点，形成无指针的隐式KD树
+    float lo[KeySize], hi[KeySize];
+    for (int k = 0; k < KeySize; ++k) {
+        lo[k] = hi[k] = ownedEntries[begin].key[k];
+    }
+    for (int i = begin + 1; i < end; ++i) {
+        for (int k = 0; k < KeySize; ++k) {
+            lo[k] = std::min(lo[k], ownedEntries[i].key[k]);
+            hi[k] = std::max(hi[k], ownedEntries[i].key[k]);
+        }
+    }
+    int axis = 0;
+    for (int k = 1; k < KeySize; ++k) {
+        if (hi[k] - lo[k] > hi[axis] - lo[axis]) axis = k;
+    }
+
+    const int mid = (begin + end) / 2;
+    std::nth_element(ownedEntries.begin() + begin, ownedEntries.begin() + mid, ownedEntries.begin() + end,
+                     [axis](const Entry &a, const Entry &b) { return a.key[axis] < b.key[axis]; });
+    ownedEntries[mid].axis = axis;
+    buildTree(begin, mid);
+    buildTree(mid + 1, end);
+}
+
+bool IkSeedDatabase::save(const QString &fileName) const
+{
+    if (isEmpty()) {
+        return false;
+    }
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    FileHeader header;
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.entrySize = sizeof(Entry);
+    header.count = quint32(count);
+    header.resolution = quint32(resolution);
+    header.modelHash = model;
+    const qint64 bytes = qint64(count) * qint64(sizeof(Entry));
+    return file.write(reinterpret_cast<const char *>(&header), sizeof(header)) == qint64(sizeof(header))
+           && file.write(reinterpret_cast<const char *>(entries), bytes) == bytes;
+}
+
+bool IkSeedDatabase::load(const QString &fileName)
+{
+    clear();
+    mappedFile.setFileName(fileName);
+    if (!mappedFile.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    const qint64 fileSize = mappedFile.size();
+    if (fileSize < qint64(sizeof(FileHeader))) {
+        mappedFile.close();
+        return false;
+    }
+    const uchar *data = mappedFile.map(0, fileSize);
+    if (!data) {
+        mappedFile.close();
+        return false;
+    }
+
+    FileHeader header;
+    std::memcpy(&header, data, sizeof(header));
+    if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 || header.version != kVersion
+        || header.entrySize != sizeof(Entry) || header.count > quint32(MaxResolution) * MaxResolution * MaxResolution * MaxResolution
+        || fileSize != qint64(sizeof(FileHeader)) + qint64(header.count) * qint64(sizeof(Entry))) {
+        mappedFile.close();
+        return false;
+    }
+    // 标定后换了模型，旧的采样位姿与当前正解不一致，作为初值会把迭代引向错误的构型
+    if (header.modelHash != modelHash(ArmKinematics::activeParams())) {
+        qWarning("逆解初值数据库%s不是按当前运动学模型生成的，已忽略；请用--build-ik-seeds重新生成",
+                 qPrintable(fileName));
+        mappedFile.close();
+        return false;
+    }
+
+    entries = reinterpret_cast<const Entry *>(data + sizeof(FileHeader));
+    count = int(header.count);
+    resolution = int(header.resolution);
+    model = header.modelHash;
+    return true;
+}
+
+int IkSeedDatabase::nearest(const double T[16], int k, double *seeds) const
+{
+    k = qBound(1, k, int(kMaxNeighbors));
+    if (isEmpty()) {
+        return 0;
+    }
+
+    double key[KeySize];
+    poseKey(T, key);
+    double bestDist[kMaxNeighbors];
+    int bestIndex[kMaxNeighbors];
+    int found = 0;
+    search(0, count, key, k, found, bestDist, bestIndex);
+
+    for (int i = 0; i < found; ++i) {
+        for (int j = 0; j < 4; ++j) {
+            seeds[i * 4 + j] = entries[bestIndex[i]].q[j];
+        }
+    }
+    return found;
+}
+
+void IkSeedDatabase::search(int begin, int end, const double key[KeySize], int k, int &found,
+                            double *bestDist, int *bestIndex) const
+{
+    if (begin >= end) {
+        return;
+    }
+    const int mid = (begin + end) / 2;
+    const Entry &e = entries[mid];
+
+    // 插入有序的候选列表
+    const double d = keyDistance(key, e.key);
+    if (found < k || d < bestDist[found - 1]) {
+        int pos = found < k ? found++ : k - 1;
+        while (pos > 0 && bestDist[pos - 1] > d) {
+            bestDist[pos] = bestDist[pos - 1];
+            bestIndex[pos] = bestIndex[pos - 1];
+            --pos;
+        }
+        bestDist[pos] = d;
+        bestIndex[pos] = mid;
+    }
+
+    const double diff = key[e.axis] - e.key[e.axis];
+    if (diff < 0) {
+        search(begin, mid, key, k, found, bestDist, bestIndex);
+        if (found < k || diff * diff < bestDist[found - 1]) search(mid + 1, end, key, k, found, bestDist, bestIndex);
+    } else {
+        search(mid + 1, end, key, k, found, bestDist, bestIndex);
+        if (found < k || diff * diff < bestDist[found - 1]) search(begin, mid, key, k, found, bestDist, bestIndex);
+    }
+}
+
+bool IkSeedDatabase::refine(const double T[16], double q[4], int maxIterations, double *residual)
+{
+    double target[KeySize];
+    poseKey(T, target);
+
+    double r[KeySize];
+    residualAt(target, q, r);
+    double err = residualNorm(r);
+    double lambda = 1e-3;
+    const double h = 1e-7;
+
+    for (int iter = 0; iter < maxIterations && err > 1e-9; ++iter) {
+        // 前向差分数值雅可比
+        double J[KeySize][4];
+        for (int j = 0; j < 4; ++j) {
+            double qh[4] = {q[0], q[1], q[2], q[3]};
+            qh[j] += h;
+            double rh[KeySize];
+            residualAt(target, qh, rh);
+            for (int i = 0; i < KeySize; ++i) J[i][j] = (rh[i] - r[i]) / h;
+        }
+
+        double A[4][4], g[4];
+        for (int a = 0; a < 4; ++a) {
+            g[a] = 0;
+            for (int i = 0; i < KeySize; ++i) g[a] -= J[i][a] * r[i];
+            for (int b = 0; b < 4; ++b) {
+                A[a][b] = 0;
+                for (int i = 0; i < KeySize; ++i) A[a][b] += J[i][a] * J[i][b];
+            }
+            A[a][a] += lambda;
+        }
+
+        double delta[4];
+        if (!solve4(A, g, delta)) {
+            break;
+        }
+        double qNew[4];
+        for (int j = 0; j < 4; ++j) {
+            qNew[j] = qBound(ArmKinematics::jointMin[j], q[j] + delta[j], ArmKinematics::jointMax[j]);
+        }
+        double rNew[KeySize];
+        residualAt(target, qNew, rNew);
+        const double errNew = residualNorm(rNew);
+        if (errNew < err) {
+            std::copy(qNew, qNew + 4, q);
+            std::copy(rNew, rNew + KeySize, r);
+            err = errNew;
+            lambda = qMax(lambda * 0.3, 1e-9);
+        } else {
+            lambda *= 10;
+            if (lambda > 1e6) break;
+        }
+    }
+
+    if (residual) {
+        *residual = err;
+    }
+    return err < 1e-4;
+}
+
+bool IkSeedDatabase::solve(const double T[16], double q[4], double *residual) const
+{
+    // 命中率 = 由初值收敛的次数 / 查询次数
+    static Metrics::Counter *lookups = Metrics::counter("arm_ik_seed_lookups_total", "逆解初值数据库查询次数");
+    static Metrics::Counter *hits = Metrics::counter("arm_ik_seed_hits_total", "逆解初值数据库查询后数值解收敛的次数");
+    static Metrics::Histogram *latency = Metrics::histogram("arm_ik_seed_solve_seconds", "逆解初值数据库查询加数值迭代的耗时");
+    Metrics::ScopedTimer timer(latency);
+    lookups->add();
+
+    double seeds[4 * 4];
+    const int n = nearest(T, 4, seeds);
+    double bestErr = INFINITY;
+    for (int i = 0; i < n; ++i) {
+        double candidate[4] = {seeds[i * 4], seeds[i * 4 + 1], seeds[i * 4 + 2], seeds[i * 4 + 3]};
+        double err;
+        refine(T, candidate, 30, &err);
+        if (err < bestErr) {
+            bestErr = err;
+            std::copy(candidate, candidate + 4, q);
+        }
+        if (bestErr < 1e-6) {
+            break;
+        }
+    }
+    if (residual) {
+        *residual = bestErr;
+    }
+    if (bestErr < 1e-4) {
+        hits->add();
+    }
+    return bestErr < 1e-4;
+}
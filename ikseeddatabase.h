@@ -0,0 +1,67 @@
+#ifndef IKSEEDDATABASE_H
+#define IKSEEDDATABASE_H
+
+#include "armkinematics.h"
+#include <QFile>
+#include <QString>
+#include <QVector>
+
+// 逆解初值数据库：离线在关节限位内均匀采样，记录末端位姿，
+// 按隐式KD树排列后写入文件；运行时内存映射加载，按目标位姿查询最近的若干构型作为数值迭代初值
+// 采样位姿按ArmKinematics::activeParams()计算，文件头记录这组MDH参数的摘要，模型不同时拒绝加载
+class IkSeedDatabase
+{
+public:
+    // 检索键：末端位置(米) + 加权后的接近方向(T04的z轴)和x轴方向
+    enum { KeySize = 9 };
+    struct Entry
+    {
+        float key[KeySize];
+        float q[4];
+        qint32 axis; // 该节点的划分维度
+    };
+
+    enum {
+        DefaultResolution = 32, // 32^4个采样点，约56MB
+        MaxResolution = 64      // 64^4个采样点，约0.9GB；采样点数须在int范围内
+    };
+    static const double orientationWeight; // 方向误差折算为长度的权重（米）
+
+    IkSeedDatabase();
+    ~IkSeedDatabase();
+
+    // 离线构建：每个关节在限位内取resolution个采样值（限制在2..MaxResolution）
+    void build(int resolution = DefaultResolution);
+    bool save(const QString &fileName) const;
+    // 内存映射方式加载；文件由其他MDH参数生成时（如标定前）输出警告并返回false
+    bool load(const QString &fileName);
+    void clear();
+
+    bool isEmpty() const { return count == 0; }
+    int size() const { return count; }
+    qint64 memoryBytes() const { return qint64(count) * qint64(sizeof(Entry)); }
+
+    // 查询最近的k个构型（k不超过16），seeds按每4个关节角连续存储，返回实际数量
+    int nearest(const double T[16], int k, double *seeds) const;
+    // 查询初值并迭代求解，返回误差最小的解
+    bool solve(const double T[16], double q[4], double *residual = nullptr) const;
+
+    // 阻尼最小二乘迭代：以q为初值逼近目标位姿
+    static bool refine(const double T[16], double q[4], int maxIterations = 30, double *residual = nullptr);
+    static void poseKey(const double T[16], double key[KeySize]);
+    // MDH参数的摘要（16个double逐字节的FNV-1a），只用于判断数据库与模型是否一致
+    static quint64 modelHash(const ArmKinematics::MdhParams &params);
+
+private:
+    void buildTree(int begin, int end);
+    void search(int begin, int end, const double key[KeySize], int k, int &found, double *bestDist, int *bestIndex) const;
+
+    QVector<Entry> ownedEntries; // build()生成的数据
+    QFile mappedFile;            // load()映射的文件
+    const Entry *entries;
+    int count;
+    int resolution;
+    quint64 model; // 生成采样时MDH参数的摘要
+};
+
+#endif // IKSEEDDATABASE_H
@@ -0,0 +1,349 @@
+#include "kinematicsserver.h"
+#include "armkinematics.h"
+#include "metrics.h"
+#include <QAtomicInt>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QPointer>
+#include <QSharedMemory>
+#include <cstring>
+
+using namespace KinematicsProtocol;
+
+namespace {
+
+// 单个请求经套接字传输的负载上限，更大的批量应走共享内存
+const qint64 kMaxSocketPayload = 64 * 1024 * 1024;
+// 单个请求的项数上限
+const quint32 kMaxItems = 1u << 24;
+// 线程池中每个任务处理的项数
+const int kChunkItems = 1024;
+
+// 线程池中尚未全部完成的批量请求
+struct PendingBatch
+{
+    RequestHeader header;
+    QElapsedTimer received;
+    QAtomicInt remaining;
+    QByteArray input;   // 套接字模式下复制出的输入
+    QByteArray output;
+    const char *in = nullptr;
+    char *out = nullptr;
+    QSharedPointer<QSharedMemory> sharedMemory; // 保证计算期间共享内存不被分离
+};
+
+} // namespace
+
+namespace KinematicsProtocol {
+
+int inputSize(quint16 operation)
+{
+    switch (operation) {
+    case Ping: return 0;
+    case Forward: return 4 * sizeof(double);
+    case Inverse: return 16 * sizeof(double);
+    case Jacobian: return 4 * sizeof(double);
+    default: return 0;
+    }
+}
+
+int outputSize(quint16 operation)
+{
+    switch (operation) {
+    case Ping: return 0;
+    case Forward: return 16 * sizeof(double);
+    case Inverse: return sizeof(InverseResult);
+    case Jacobian: return 24 * sizeof(double);
+    default: return 0;
+    }
+}
+
+} // namespace KinematicsProtocol
+
+KinematicsServer::KinematicsServer(QObject *parent)
+    : QObject(parent)
+    , server(new QLocalServer(this))
+    , inlineLimit(32)
+    , totalNanoseconds(0)
+{
+    connect(server, &QLocalServer::newConnection, this, &KinematicsServer::onNewConnection);
+}
+
+KinematicsServer::~KinematicsServer()
+{
+    pool.waitForDone();
+}
+
+bool KinematicsServer::listen(const QString &name)
+{
+    // 清理上次异常退出残留的套接字文件
+    QLocalServer::removeServer(name);
+    return server->listen(name);
+}
+
+QString KinematicsServer::errorString() const
+{
+    return server->errorString();
+}
+
+void KinematicsServer::setInlineLimit(int items)
+{
+    inlineLimit = qMax(0, items);
+}
+
+void KinematicsServer::setMaxThreads(int threads)
+{
+    if (threads > 0) {
+        pool.setMaxThreadCount(threads);
+    }
+}
+
+KinematicsServer::Stats KinematicsServer::takeStats()
+{
+    Stats result = stats;
+    if (result.requests > 0) {
+        result.meanMicroseconds = totalNanoseconds / 1000.0 / result.requests;
+    }
+    stats = Stats();
+    totalNanoseconds = 0;
+    return result;
+}
+
+void KinematicsServer::compute(quint16 operation, const char *in, int count, char *out)
+{
+    const int inBytes = inputSize(operation);
+    const int outBytes = outputSize(operation);
+    for (int i = 0; i < count; ++i, in += inBytes, out += outBytes) {
+        switch (operation) {
+        case Forward: {
+            double q[4], T[16];
+            std::memcpy(q, in, sizeof(q));
+            ArmKinematics::forward(q, T);
+            std::memcpy(out, T, sizeof(T));
+            break;
+        }
+        case Inverse: {
+            double T[16];
+            InverseResult result;
+            std::memcpy(T, in, sizeof(T));
+            ArmKinematics::inverse(T, result.solutions, &result.clampedMask);
+            result.flippedMask = ArmKinematics::flippedWristMask;
+            std::memcpy(out, &result, sizeof(result));
+            break;
+        }
+        case Jacobian: {
+            double q[4], J[6][4];
+            std::memcpy(q, in, sizeof(q));
+            ArmKinematics::jacobian(q, J);
+            std::memcpy(out, J, sizeof(J));
+            break;
+        }
+        default:
+            break;
+        }
+    }
+}
+
+void KinematicsServer::onNewConnection()
+{
+    while (QLocalSocket *socket = server->nextPendingConnection()) {
+        Connection &connection = connections[socket];
+        connection.socket = socket;
+        connect(socket, &QLocalSocket::readyRead, this, [this, socket]() { onReadyRead(socket); });
+        connect(socket, &QLocalSocket::disconnected, this, [this, socket]() { onDisconnected(socket); });
+    }
+}
+
+void KinematicsServer::onDisconnected(QLocalSocket *socket)
+{
+    connections.remove(socket);
+    socket->deleteLater();
+}
+
+void KinematicsServer::onReadyRead(QLocalSocket *socket)
+{
+    auto it = connections.find(socket);
+    if (it == connections.end()) {
+        return;
+    }
+    Connection &connection = it.value();
+    connection.buffer.append(socket->readAll());
+
+    // 一次读取中可能包含多个流水线请求，依次处理所有完整的帧
+    const int headerBytes = int(sizeof(RequestHeader));
+    int offset = 0;
+    while (connection.buffer.size() - offset >= headerBytes) {
+        RequestHeader header;
+        std::memcpy(&header, connection.buffer.constData() + offset, sizeof(header));
+
+        qint64 payloadBytes = 0;
+        if (header.operation == AttachSharedMemory) {
+            payloadBytes = header.count;
+        } else if (!(header.flags & PayloadInSharedMemory)) {
+            payloadBytes = qint64(header.count) * inputSize(header.operation);
+        }
+        if (header.magic != RequestMagic || header.count > kMaxItems || payloadBytes > kMaxSocketPayload) {
+            // 帧边界已无法确定，只能断开
+            socket->abort();
+            return;
+        }
+        if (connection.buffer.size() - offset < headerBytes + payloadBytes) {
+            break;
+        }
+
+        QElapsedTimer received;
+        received.start();
+        if (!handleRequest(connection, header, connection.buffer.constData() + offset + headerBytes, received)) {
+            socket->abort();
+            return;
+        }
+        offset += headerBytes + int(payloadBytes);
+    }
+    connection.buffer.remove(0, offset);
+    socket->flush();
+}
+
+bool KinematicsServer::handleRequest(Connection &connection, const RequestHeader &header, const char *payload,
+                                     const QElapsedTimer &received)
+{
+    QLocalSocket *socket = connection.socket;
+
+    if (header.operation == Ping) {
+        writeResponse(socket, header, Ok, nullptr, 0, received);
+        return true;
+    }
+    if (header.operation == AttachSharedMemory) {
+        const QString key = QString::fromUtf8(payload, int(header.count));
+        QSharedPointer<QSharedMemory> memory(new QSharedMemory(key));
+        if (memory->attach(QSharedMemory::ReadWrite)) {
+            connection.sharedMemory = memory;
+            writeResponse(socket, header, Ok, nullptr, 0, received);
+        } else {
+            writeResponse(socket, header, NoSharedMemory, nullptr, 0, received);
+        }
+        return true;
+    }
+
+    const int inBytes = inputSize(header.operation);
+    const int outBytes = outputSize(header.operation);
+    if (inBytes == 0 || outBytes == 0) {
+        // 未知操作，无法确定负载长度
+        return false;
+    }
+
+    const bool useSharedMemory = header.flags & PayloadInSharedMemory;
+    const char *in = payload;
+    char *out = nullptr;
+    if (useSharedMemory) {
+        QSharedMemory *memory = connection.sharedMemory.data();
+        if (!memory) {
+            writeResponse(socket, header, NoSharedMemory, nullptr, 0, received);
+            return true;
+        }
+        const quint64 size = quint64(memory->size());
+        const quint64 inEnd = header.inputOffset + quint64(header.count) * inBytes;
+        const quint64 outEnd = header.outputOffset + quint64(header.count) * outBytes;
+        if (header.inputOffset > size || header.outputOffset > size || inEnd > size || outEnd > size) {
+            writeResponse(socket, header, OutOfRange, nullptr, 0, received);
+            return true;
+        }
+        // 逐项先读输入再写输出，输出区域覆盖尚未读取的输入会得到错误结果
+        if (header.count > 0 && header.inputOffset < outEnd && header.outputOffset < inEnd) {
+            writeResponse(socket, header, OverlappingRegions, nullptr, 0, received);
+            return true;
+        }
+        char *base = static_cast<char *>(memory->data());
+        in = base + header.inputOffset;
+        out = base + header.outputOffset;
+    }
+
+    const int count = int(header.count);
+    if (count <= inlineLimit) {
+        // 小请求直接计算，避免线程切换带来的延迟
+        if (!useSharedMemory) {
+            connection.output.resize(count * outBytes);
+            out = connection.output.data();
+        }
+        compute(header.operation, in, count, out);
+        writeResponse(socket, header, Ok, useSharedMemory ? nullptr : out,
+                      useSharedMemory ? 0 : qint64(count) * outBytes, received);
+        return true;
+    }
+
+    // 大批量请求按kChunkItems切分到线程池，最后完成的任务通知套接字线程发送响应
+    QSharedPointer<PendingBatch> batch(new PendingBatch);
+    batch->header = header;
+    batch->received = received;
+    if (useSharedMemory) {
+        batch->sharedMemory = connection.sharedMemory;
+        batch->in = in;
+        batch->out = out;
+    } else {
+        batch->input = QByteArray(payload, int(qint64(count) * inBytes));
+        batch->output.resize(int(qint64(count) * outBytes));
+        batch->in = batch->input.constData();
+        batch->out = batch->output.data();
+    }
+    const int chunks = (count + kChunkItems - 1) / kChunkItems;
+    batch->remaining.storeRelaxed(chunks);
+    static Metrics::Gauge *pending = Metrics::gauge("arm_server_pending_batches", "运动学服务：线程池中尚未完成的批量请求数");
+    pending->add(1);
+
+    QPointer<QLocalSocket> target(socket);
+    for (int chunk = 0; chunk < chunks; ++chunk) {
+        const int begin = chunk * kChunkItems;
+        const int items = qMin(kChunkItems, count - begin);
+        pool.start([this, batch, target, begin, items, inBytes, outBytes]() {
+            compute(batch->header.operation, batch->in + qint64(begin) * inBytes, items,
+                    batch->out + qint64(begin) * outBytes);
+            if (batch->remaining.fetchAndSubOrdered(1) != 1) {
+                return;
+            }
+            pending->add(-1);
+            QMetaObject::invokeMethod(this, [this, batch, target]() {
+                if (!target || !connections.contains(target.data())) {
+                    return;
+                }
+                const bool shared = batch->header.flags & PayloadInSharedMemory;
+                writeResponse(target.data(), batch->header, Ok, shared ? nullptr : batch->output.constData(),
+                              shared ? 0 : batch->output.size(), batch->received);
+                target->flush();
+            }, Qt::QueuedConnection);
+        });
+    }
+    return true;
+}
+
+void KinematicsServer::writeResponse(QLocalSocket *socket, const RequestHeader &request, quint16 status,
+                                     const char *payload, qint64 payloadBytes, const QElapsedTimer &received)
+{
+    ResponseHeader response;
+    response.magic = ResponseMagic;
+    response.id = request.id;
+    response.operation = request.operation;
+    response.status = status;
+    response.count = request.count;
+    response.payloadBytes = quint64(payloadBytes);
+    response.serviceNanoseconds = quint64(received.nsecsElapsed());
+
+    socket->write(reinterpret_cast<const char *>(&response), sizeof(response));
+    if (payloadBytes > 0) {
+        socket->write(payload, payloadBytes);
+    }
+    recordLatency(qint64(response.serviceNanoseconds), request.count);
+}
+
+void KinematicsServer::recordLatency(qint64 nanoseconds, quint32 items)
+{
+    static Metrics::Counter *requests = Metrics::counter("arm_server_requests_total", "运动学服务：已应答的请求数");
+    static Metrics::Counter *itemCount = Metrics::counter("arm_server_items_total", "运动学服务：已计算的项数");
+    static Metrics::Histogram *latency = Metrics::histogram("arm_server_request_seconds", "运动学服务：从收到请求到写出响应的时间");
+    requests->add();
+    itemCount->add(items);
+    latency->record(quint64(nanoseconds));
+
+    ++stats.requests;
+    stats.items += items;
+    totalNanoseconds += quint64(nanoseconds);
+    stats.maxMicroseconds = qMax(stats.maxMicroseconds, nanoseconds / 1000.0);
+}
@@ -0,0 +1,149 @@
+#ifndef KINEMATICSSERVER_H
+#define KINEMATICSSERVER_H
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QObject>
+#include <QSharedPointer>
+#include <QString>
+#include <QThreadPool>
+
+class QLocalServer;
+class QLocalSocket;
+class QSharedMemory;
+
+// 本机运动学服务的二进制协议（本机字节序）
+// 客户端在Unix域套接字上连续发送请求（可流水线发送，无需等待响应），
+// 服务端按请求id返回响应；大批量请求可能乱序完成
+//
+// 共享内存：客户端创建一段共享内存并用AttachSharedMemory告知服务端，之后的请求在请求头中给出
+// 输入、输出在这段内存中的偏移，服务端只按偏移读写，不维护读写指针。
+// 这段内存由客户端分配，可以当作环形缓冲使用：按顺序往后分配每个请求的输入、输出区域，
+// 到末尾后回到开头，收到某个请求的响应后才回收它的区域。服务端不检查请求之间的区域，约定：
+//   1. 同一请求的输入和输出区域不能重叠（服务端检查，重叠时返回OverlappingRegions）
+//   2. 在途请求（已发送、尚未收到响应）的输出区域不能与其他在途请求的输入或输出区域重叠，
+//      收到响应前客户端也不能改写该请求的输入区域；大批量请求在线程池中并发执行，违反时结果不确定
+// 与控制器仿真的ControllerProtocol::Ring不同，这里的请求长度不定且可能乱序完成，
+// 因此不用固定槽位的环，由客户端按上面的约定自行管理区域
+namespace KinematicsProtocol {
+
+const quint32 RequestMagic = 0x4b524551;  // "KREQ"
+const quint32 ResponseMagic = 0x4b525350; // "KRSP"
+
+enum Operation : quint16 {
+    Ping = 0,
+    Forward = 1,            // 输入每项4个double（关节角），输出16个double（T04，行优先）
+    Inverse = 2,            // 输入每项16个double（位姿），输出InverseResult
+    Jacobian = 3,           // 输入每项4个double，输出24个double（6x4，行优先）
+    AttachSharedMemory = 4  // 套接字负载为QSharedMemory的key（UTF-8，count为字节数）
+};
+
+enum Flags : quint16 {
+    PayloadInSharedMemory = 0x1 // 输入从共享内存inputOffset处读取，输出写到outputOffset处
+};
+
+enum Status : quint16 {
+    Ok = 0,
+    BadRequest = 1,
+    NoSharedMemory = 2,
+    OutOfRange = 3,
+    OverlappingRegions = 4 // 共享内存中同一请求的输入和输出区域重叠
+};
+
+struct RequestHeader
+{
+    quint32 magic;
+    quint32 id;
+    quint16 operation;
+    quint16 flags;
+    quint32 count;        // 批量项数
+    quint64 inputOffset;  // 仅PayloadInSharedMemory时有效
+    quint64 outputOffset;
+};
+
+struct ResponseHeader
+{
+    quint32 magic;
+    quint32 id;
+    quint16 operation;
+    quint16 status;
+    quint32 count;
+    quint64 serviceNanoseconds; // 服务端从收到完整请求到响应就绪的耗时
+    quint64 payloadBytes;       // 紧随其后的负载长度，共享内存模式下为0
+};
+
+struct InverseResult
+{
+    double solutions[8][4];
+    quint32 clampedMask; // 第k位：第k组解有关节角被限位截断
+    quint32 flippedMask; // 第k位：第k组解末端x轴与目标相反（关节4转了180°），目前恒为ArmKinematics::flippedWristMask
+};
+
+// 每项输入/输出的字节数，操作无效时返回0
+int inputSize(quint16 operation);
+int outputSize(quint16 operation);
+
+} // namespace KinematicsProtocol
+
+// 无界面的运动学服务：QLocalServer接收请求，小请求在套接字线程内联计算以降低往返延迟，
+// 大批量请求交给线程池；批量数据可通过客户端创建的共享内存传递，套接字只传请求头
+class KinematicsServer : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Stats
+    {
+        quint64 requests = 0;
+        quint64 items = 0;
+        double meanMicroseconds = 0;
+        double maxMicroseconds = 0;
+    };
+
+    explicit KinematicsServer(QObject *parent = nullptr);
+    ~KinematicsServer() override;
+
+    bool listen(const QString &name);
+    QString errorString() const;
+
+    // 项数不超过该值的请求在套接字线程内直接计算
+    void setInlineLimit(int items);
+    void setMaxThreads(int threads);
+
+    // 返回自上次调用以来的延迟统计并清零
+    Stats takeStats();
+
+    // 线程安全的批量计算，in/out可不对齐
+    static void compute(quint16 operation, const char *in, int count, char *out);
+
+private slots:
+    void onNewConnection();
+
+private:
+    struct Connection
+    {
+        QLocalSocket *socket = nullptr;
+        QByteArray buffer;
+        QByteArray output;
+        QSharedPointer<QSharedMemory> sharedMemory;
+    };
+
+    void onReadyRead(QLocalSocket *socket);
+    void onDisconnected(QLocalSocket *socket);
+    // 处理一个完整请求，返回false表示协议错误需断开连接
+    bool handleRequest(Connection &connection, const KinematicsProtocol::RequestHeader &header,
+                       const char *payload, const QElapsedTimer &received);
+    void writeResponse(QLocalSocket *socket, const KinematicsProtocol::RequestHeader &request, quint16 status,
+                       const char *payload, qint64 payloadBytes, const QElapsedTimer &received);
+    void recordLatency(qint64 nanoseconds, quint32 items);
+
+    QLocalServer *server;
+    QHash<QLocalSocket *, Connection> connections;
+    QThreadPool pool;
+    int inlineLimit;
+    Stats stats;
+    quint64 totalNanoseconds;
+};
+
+#endif // KINEMATICSSERVER_H
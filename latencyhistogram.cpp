@@ -0,0 +1,101 @@
+#include "latencyhistogram.h"
+#include <QtGlobal>
+#include <cmath>
+
+LatencyHistogram::LatencyHistogram(double bucketMicroseconds, int bucketCount)
+    : buckets(qMax(1, bucketCount), 0)
+    , bucketWidth(bucketMicroseconds > 0 ? bucketMicroseconds : 1.0)
+{
+}
+
+void LatencyHistogram::add(double microseconds)
+{
+    if (!(microseconds >= 0)) {
+        microseconds = 0;
+    }
+    const int index = qMin(int(microseconds / bucketWidth), int(buckets.size()) - 1);
+    ++buckets[index];
+    ++total;
+    sum += microseconds;
+    maxValue = qMax(maxValue, microseconds);
+}
+
+void LatencyHistogram::merge(const LatencyHistogram &other)
+{
+    if (other.buckets.size() != buckets.size() || other.bucketWidth != bucketWidth) {
+        return;
+    }
+    for (int i = 0; i < buckets.size(); ++i) {
+        buckets[i] += other.buckets[i];
+    }
+    total += other.total;
+    sum += other.sum;
+    maxValue = qMax(maxValue, other.maxValue);
+}
+
+void LatencyHistogram::clear()
+{
+    buckets.fill(0);
+    total = 0;
+    sum = 0;
+    maxValue = 0;
+}
+
+double LatencyHistogram::percentile(double p) const
+{
+    if (total == 0) {
+        return 0.0;
+    }
+    const quint64 rank = quint64(std::ceil(qBound(0.0, p, 1.0) * total));
+    quint64 seen = 0;
+    for (int i = 0; i < buckets.size(); ++i) {
+        seen += buckets[i];
+        if (seen >= rank && seen > 0) {
+            // 最后一个桶包含所有超出范围的样本，用实际最大值代替上沿
+            return i == buckets.size() - 1 ? maxValue : qMin((i + 1) * bucketWidth, maxValue);
+        }
+    }
+    return maxValue;
+}
+
+QString LatencyHistogram::summary() const
+{
+    return QString("%1个样本，平均%2 us，p50 %3 us，p99 %4 us，p99.9 %5 us，最大%6 us")
+        .arg(total)
+        .arg(mean(), 0, 'f', 1)
+        .arg(percentile(0.5), 0, 'f', 1)
+        .arg(percentile(0.99), 0, 'f', 1)
+        .arg(percentile(0.999), 0, 'f', 1)
+        .arg(maximum(), 0, 'f', 1);
+}
+
+QString LatencyHistogram::table() const
+{
+    // 区间上沿按1-2-5递增
+    QString text;
+    double lower = 0;
+    double upper = bucketWidth;
+    int bucket = 0;
+    while (bucket < buckets.size()) {
+        quint64 n = 0;
+        while (bucket < buckets.size() && (bucket + 1) * bucketWidth <= upper + 1e-9) {
+            n += buckets[bucket++];
+        }
+        const bool last = bucket >= buckets.size();
+        if (n > 0) {
+            const double share = 100.0 * n / total;
+            const QString range = last && n > 0 && maxValue > upper
+                ? QString("≥%1").arg(lower)
+                : QString("%1-%2").arg(lower).arg(upper);
+            text += QString("%1 us\t%2\t%3%\t%4\n")
+                        .arg(range, 12)
+                        .arg(n, 10)
+                        .arg(share, 6, 'f', 2)
+                        .arg(QString(qMax(1, int(std::ceil(share / 2))), QChar('#')));
+        }
+        lower = upper;
+        const double mantissa = upper / std::pow(10.0, std::floor(std::log10(upper) + 1e-9));
+        upper *= mantissa < 1.5 ? 2.0 : (mantissa < 3 ? 2.5 : 2.0);
+    }
+    return text;
+}
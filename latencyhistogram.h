@@ -0,0 +1,37 @@
+#ifndef LATENCYHISTOGRAM_H
+#define LATENCYHISTOGRAM_H
+
+#include <QString>
+#include <QVector>
+
+// 定宽分桶的延迟直方图（单位：微秒），超出范围的样本计入最后一个桶；
+// 记录时不分配内存，可在实时循环中调用
+class LatencyHistogram
+{
+public:
+    explicit LatencyHistogram(double bucketMicroseconds = 1.0, int bucketCount = 10000);
+
+    void add(double microseconds);
+    void merge(const LatencyHistogram &other);
+    void clear();
+
+    quint64 count() const { return total; }
+    double mean() const { return total ? sum / total : 0.0; }
+    double maximum() const { return total ? maxValue : 0.0; }
+    // 分位数（p取0..1），返回所在桶的上沿
+    double percentile(double p) const;
+
+    // 一行摘要：样本数、平均、p50/p99/p99.9、最大
+    QString summary() const;
+    // 按对数区间汇总的分布表，每行一个区间
+    QString table() const;
+
+private:
+    QVector<quint64> buckets;
+    double bucketWidth;
+    quint64 total = 0;
+    double sum = 0;
+    double maxValue = 0;
+};
+
+#endif // LATENCYHISTOGRAM_H
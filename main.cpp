@@ -1,11 +1,489 @@
 #include "mainwindow.h"
+#include "armcalibration.h"
+#include "armkinematics.h"
+#include "cellsimulation.h"
+#include "collisionchecker.h"
+#include "ikbranchtracker.h"
+#include "ikseeddatabase.h"
+#include "kinematicsserver.h"
+#include "metricsexporter.h"
+#include "offscreenrenderer.h"
+#include "setpointstreamer.h"
+#include "simulatedcontroller.h"
+#include "startupprofiler.h"
+#include "trajectorytiming.h"
+#include "sweptvolume.h"
 
 #include <QApplication>
+#include <QCoreApplication>
+#include <QGuiApplication>
 #include <QSurfaceFormat>
 #include <QLoggingCategory>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QThread>
+#include <QThreadPool>
+#include <QTimer>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+// 程序目录下存在标定结果时，用其替换名义MDH参数
+static void loadCalibratedModel()
+{
+    ArmKinematics::MdhParams calibrated;
+    if (ArmKinematics::loadParams(QCoreApplication::applicationDirPath() + "/arm_model.json", calibrated)) {
+        ArmKinematics::setActiveParams(calibrated);
+    }
+}
+
+// 离线生成逆解初值数据库：work --build-ik-seeds <文件> [每关节采样数，2..64]
+static int buildIkSeeds(int argc, char *argv[])
+{
+    if (argc < 3) {
+        std::fprintf(stderr, "用法：%s --build-ik-seeds <文件> [每关节采样数，2..64]\n", argv[0]);
+        return 1;
+    }
+    const int resolution = argc > 3 ? qBound(2, std::atoi(argv[3]), int(IkSeedDatabase::MaxResolution))
+                                    : int(IkSeedDatabase::DefaultResolution);
+    // 采样位姿按界面和服务实际使用的模型计算，数据库文件记录模型摘要，换模型后需重新生成
+    QCoreApplication app(argc, argv);
+    loadCalibratedModel();
+
+    QElapsedTimer timer;
+    timer.start();
+    IkSeedDatabase database;
+    database.build(resolution);
+    if (!database.save(QString::fromLocal8Bit(argv[2]))) {
+        std::fprintf(stderr, "写入失败：%s\n", argv[2]);
+        return 1;
+    }
+    std::printf("已生成%d个采样点，%.1f MB，用时%lld ms\n", database.size(),
+                database.memoryBytes() / (1024.0 * 1024.0), timer.elapsed());
+    return 0;
+}
+
+// 离线运动学标定：work --calibrate <测量文件> <输出模型文件>
+static int calibrate(int argc, char *argv[])
+{
+    if (argc < 4) {
+        std::fprintf(stderr, "用法：%s --calibrate <测量文件> <输出模型文件>\n", argv[0]);
+        return 1;
+    }
+
+    ArmCalibration calibration;
+    QString error;
+    if (!calibration.loadSamples(QString::fromLocal8Bit(argv[2]), &error)) {
+        std::fprintf(stderr, "%s\n", error.toLocal8Bit().constData());
+        return 1;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    const ArmCalibration::Result result = calibration.calibrate(ArmKinematics::nominalParams());
+    std::printf("%d个样本，迭代%d次，用时%lld ms%s\n", int(calibration.samples().size()), result.iterations,
+                timer.elapsed(), result.converged ? "" : result.stalled ? "（迭代停滞，未收敛）" : "（未收敛）");
+    std::printf("位置误差RMS：%.3f mm -> %.3f mm，姿态误差RMS：%.4f°\n", result.initialPositionRms * 1000,
+                result.finalPositionRms * 1000, result.finalOrientationRms * 180 / M_PI);
+
+    if (!ArmKinematics::saveParams(QString::fromLocal8Bit(argv[3]), result.params)) {
+        std::fprintf(stderr, "写入失败：%s\n", argv[3]);
+        return 1;
+    }
+    return 0;
+}
+
+// 指标导出：设置ARM_METRICS_PORT（本地HTTP端口）或ARM_METRICS_FILE（定时写入的文件）时启用
+static void startMetrics(MetricsExporter &exporter)
+{
+    if (exporter.startFromEnvironment()) {
+        if (exporter.serverPort()) {
+            std::fprintf(stderr, "指标端点：http://127.0.0.1:%u/metrics\n", unsigned(exporter.serverPort()));
+        }
+    } else if (!exporter.errorString().isEmpty()) {
+        std::fprintf(stderr, "%s\n", exporter.errorString().toLocal8Bit().constData());
+    }
+}
+
+// 无界面运动学服务：work --serve [服务名]，每10秒输出一次延迟统计
+static int serve(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    loadCalibratedModel();
+
+    const QString name = argc > 2 ? QString::fromLocal8Bit(argv[2]) : QString("arm-kinematics");
+    KinematicsServer server;
+    if (!server.listen(name)) {
+        std::fprintf(stderr, "监听失败：%s\n", server.errorString().toLocal8Bit().constData());
+        return 1;
+    }
+    std::printf("运动学服务已启动：%s\n", name.toLocal8Bit().constData());
+    MetricsExporter metrics;
+    startMetrics(metrics);
+
+    QTimer statsTimer;
+    QObject::connect(&statsTimer, &QTimer::timeout, [&server]() {
+        const KinematicsServer::Stats stats = server.takeStats();
+        if (stats.requests > 0) {
+            std::printf("请求%llu个，共%llu项，平均%.1f us，最大%.1f us\n", stats.requests, stats.items,
+                        stats.meanMicroseconds, stats.maxMicroseconds);
+            std::fflush(stdout);
+        }
+    });
+    statsTimer.start(10000);
+    return app.exec();
+}
+
+// 仿真控制器：work --sim-controller <udp:端口|shm:名称>，每秒输出一次接收统计
+static int simulateController(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    const ControllerProtocol::Endpoint endpoint =
+        ControllerProtocol::parseEndpoint(argc > 2 ? QString::fromLocal8Bit(argv[2]) : QString("udp:45000"));
+    SimulatedController controller;
+    if (!controller.listen(endpoint)) {
+        std::fprintf(stderr, "启动失败：%s\n", controller.errorString().toLocal8Bit().constData());
+        return 1;
+    }
+    std::printf("仿真控制器已启动：%s\n", argc > 2 ? argv[2] : "udp:45000");
+    std::fflush(stdout);
+
+    QTimer statsTimer;
+    QObject::connect(&statsTimer, &QTimer::timeout, [&controller]() {
+        const SimulatedController::Stats stats = controller.takeStats();
+        if (stats.received > 0 || stats.badPackets > 0) {
+            std::printf("收到%llu个设定值，丢失%llu，乱序%llu，饱和%llu，无效%llu\n", stats.received, stats.lost,
+                        stats.reordered, stats.saturated, stats.badPackets);
+            std::fflush(stdout);
+        }
+    });
+    statsTimer.start(1000);
+    return app.exec();
+}
+
+// 测试用设定值序列：关节空间的正弦摆动经正解得到末端位姿（与myfkine相同），
+// 再逐点由逆解分支跟踪求关节角，与实际下发前的位姿->关节角转换路径一致
+static QVector<double> makeStreamTestPath(int rate, double seconds, IkBranchTracker::Stats &stats)
+{
+    const double center[4] = {0.0, 0.3, -0.5, 0.0};
+    const double amplitude[4] = {0.6, 0.25, 0.3, 1.0};
+    const double frequency[4] = {0.25, 0.4, 0.3, 0.5}; // Hz
+
+    const int count = qMax(1, int(rate * seconds));
+    QVector<double> path;
+    path.reserve(4 * count);
+    IkBranchTracker tracker;
+    tracker.reset(center);
+    IkBranchTracker::Result result;
+    for (int k = 0; k < count; ++k) {
+        const double t = double(k) / rate;
+        double q[4], T[16];
+        for (int j = 0; j < 4; ++j) {
+            q[j] = center[j] + amplitude[j] * std::sin(2 * M_PI * frequency[j] * t);
+        }
+        ArmKinematics::forward(q, T);
+        // 无有效解时沿用上一构型
+        tracker.track(T, result);
+        const double *selected = tracker.previous();
+        path << selected[0] << selected[1] << selected[2] << selected[3];
+    }
+    stats = tracker.stats();
+    return path;
+}
+
+// 实时流测试：work --stream-test <udp:端口|shm:名称> [频率Hz] [秒数]
+static int streamTest(int argc, char *argv[])
+{
+    if (argc < 3) {
+        std::fprintf(stderr, "用法：%s --stream-test <udp:端口|shm:名称> [频率Hz] [秒数]\n", argv[0]);
+        return 1;
+    }
+    QCoreApplication app(argc, argv);
+    loadCalibratedModel();
+
+    SetpointStreamer::Options options;
+    options.rateHz = argc > 3 ? qBound(1, std::atoi(argv[3]), 4000) : 1000;
+    const double seconds = argc > 4 ? QByteArray(argv[4]).toDouble() : 10.0;
+
+    SetpointStreamer streamer;
+    streamer.setOptions(options);
+    if (!streamer.connectTo(ControllerProtocol::parseEndpoint(QString::fromLocal8Bit(argv[2])))) {
+        std::fprintf(stderr, "%s\n", streamer.errorString().toLocal8Bit().constData());
+        return 1;
+    }
+
+    IkBranchTracker::Stats ikStats;
+    QElapsedTimer ikTimer;
+    ikTimer.start();
+    const QVector<double> path = makeStreamTestPath(options.rateHz, seconds, ikStats);
+    std::printf("逆解分支跟踪：%llu个采样点，含正解平均每点%.2f us，无解%llu，分支切换%llu，不连续%llu，最大关节步长%.4f rad\n",
+                ikStats.samples, ikTimer.nsecsElapsed() / 1e3 / qMax<quint64>(1, ikStats.samples), ikStats.failures,
+                ikStats.branchSwitches, ikStats.discontinuities, ikStats.maxJointStep);
+    std::printf("以%d Hz发送%d个设定值…\n", options.rateHz, int(path.size() / 4));
+    std::fflush(stdout);
+    SetpointStreamer::Report report;
+    if (!streamer.stream(path, report)) {
+        std::fprintf(stderr, "%s\n", streamer.errorString().toLocal8Bit().constData());
+        return 1;
+    }
+
+    const double periodUs = 1e6 / options.rateHz;
+    std::printf("发送%llu，收到%llu，丢失%llu，饱和%llu，超周期%llu，实际频率%.1f Hz\n", report.sent,
+                report.received, report.lost, report.saturated, report.overruns,
+                report.sent / qMax(report.durationSeconds, 1e-9));
+    std::printf("\n往返延迟：%s\n%s", report.latency.summary().toLocal8Bit().constData(),
+                report.latency.table().toLocal8Bit().constData());
+    std::printf("\n发送抖动：%s\n%s", report.jitter.summary().toLocal8Bit().constData(),
+                report.jitter.table().toLocal8Bit().constData());
+
+    // 判定：无丢失、无超周期，且99.9%的往返延迟小于一个周期
+    const bool keepsUp = report.lost == 0 && report.overruns == 0 && report.latency.percentile(0.999) < periodUs;
+    std::printf("\n%s（周期%.1f us）\n", keepsUp ? "流式传输满足实时要求" : "流式传输未满足实时要求", periodUs);
+    return keepsUp ? 0 : 2;
+}
+
+// 多机器人单元仿真的多核扩展性测试：work --cell-bench [机器人数] [步数]
+// 依次用1, 2, 4 ... 个线程推进同一个演示单元，输出吞吐量和相对单线程的加速比
+static int cellBenchmark(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    loadCalibratedModel();
+    const int robots = argc > 2 ? qBound(1, std::atoi(argv[2]), 64) : 6;
+    const int steps = argc > 3 ? qMax(1, std::atoi(argv[3])) : 200000;
+
+    CellSimulation simulation;
+    simulation.setupDemoCell(robots);
+    simulation.setStopOnCollision(false);
+    std::printf("%d台机器人，%d步（步长%.1f ms）\n", robots, steps, simulation.timeStep() * 1000);
+
+    double baseline = 0;
+    const int maxThreads = QThread::idealThreadCount();
+    for (int threads = 1;; threads = qMin(threads * 2, maxThreads)) {
+        QThreadPool pool;
+        pool.setMaxThreadCount(threads);
+        simulation.setThreadPool(&pool);
+        simulation.reset();
+        QElapsedTimer timer;
+        timer.start();
+        simulation.advance(steps);
+        const double stepsPerSecond = steps / qMax(timer.nsecsElapsed() / 1e9, 1e-9);
+        if (threads == 1) {
+            baseline = stepsPerSecond;
+        }
+        const CellSimulation::Stats stats = simulation.stats();
+        std::printf("%2d线程：%10.0f 步/秒，加速比%.2f，精确距离计算%llu次，碰撞%llu次\n", threads, stepsPerSecond,
+                    stepsPerSecond / baseline, stats.pairChecks, stats.collisions);
+        if (threads >= maxThreads) {
+            break;
+        }
+    }
+    simulation.setThreadPool(nullptr);
+    return 0;
+}
+
+// 读取关节路径CSV：按表头中的q1..q4列读取关节角（如磨抛路径生成的*_path.csv），没有这些列时取前4列
+static bool readJointPath(const char *fileName, QVector<double> &path)
+{
+    QFile in(QString::fromLocal8Bit(fileName));
+    if (!in.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        std::fprintf(stderr, "无法读取路径文件：%s\n", fileName);
+        return false;
+    }
+    int columns[4] = {0, 1, 2, 3};
+    path.clear();
+    bool header = true;
+    while (!in.atEnd()) {
+        const QByteArray line = in.readLine().trimmed();
+        if (line.isEmpty()) {
+            continue;
+        }
+        const QList<QByteArray> fields = line.split(',');
+        if (header) {
+            header = false;
+            const int first = fields.indexOf("q1");
+            if (first >= 0 && fields.indexOf("q4") == first + 3) {
+                for (int j = 0; j < 4; ++j) {
+                    columns[j] = first + j;
+                }
+                continue;
+            }
+        }
+        if (fields.size() <= columns[3]) {
+            continue;
+        }
+        double q[4];
+        bool ok = true;
+        for (int j = 0; j < 4 && ok; ++j) {
+            q[j] = fields[columns[j]].toDouble(&ok);
+        }
+        if (ok) {
+            path << q[0] << q[1] << q[2] << q[3];
+        }
+    }
+    if (path.isEmpty()) {
+        std::fprintf(stderr, "路径文件中没有关节角\n");
+        return false;
+    }
+    return true;
+}
+
+// 扫掠体积与间隙：work --swept-volume <路径CSV> <输出OBJ> [体素边长]
+static int sweptVolume(int argc, char *argv[])
+{
+    if (argc < 4) {
+        std::fprintf(stderr, "用法：%s --swept-volume <路径CSV> <输出OBJ> [体素边长]\n", argv[0]);
+        return 1;
+    }
+    QCoreApplication app(argc, argv);
+    loadCalibratedModel();
+    QVector<double> path;
+    if (!readJointPath(argv[2], path)) {
+        return 1;
+    }
+
+    // 与界面相同的环境
+    CollisionChecker checker;
+    if (!checker.setupDefaultEnvironment()) {
+        std::fprintf(stderr, "%s，只使用地面和底座\n", checker.errorString().toLocal8Bit().constData());
+    }
+
+    SweptVolume swept(checker);
+    SweptVolume::Options options;
+    if (argc > 4) {
+        options.voxelSize = QByteArray(argv[4]).toDouble();
+    }
+    swept.setOptions(options);
+    if (!swept.compute(path.constData(), path.size() / 4) || !swept.exportObj(QString::fromLocal8Bit(argv[3]))) {
+        std::fprintf(stderr, "%s\n", swept.errorString().toLocal8Bit().constData());
+        return 1;
+    }
+    const SweptVolume::Result &r = swept.result();
+    std::printf("采样点%d，关键构型%d，体素%lld（边长%.3f m），扫掠体积%.4f m^3\n", r.samples, r.keyConfigurations,
+                r.voxelCount, options.voxelSize, r.volume);
+    std::printf("范围：[%.3f, %.3f, %.3f] - [%.3f, %.3f, %.3f]\n", r.boundsMin[0], r.boundsMin[1], r.boundsMin[2],
+                r.boundsMax[0], r.boundsMax[1], r.boundsMax[2]);
+    std::printf("最小间隙%.4f m（第%d个采样点）\n", r.minClearance, r.minClearanceSample);
+    std::printf("栅格化%.1f ms，间隙计算%.1f ms\n", r.rasterMs, r.clearanceMs);
+    return r.minClearance > 0 ? 0 : 2;
+}
+
+// 离线渲染路径视频：work --render <路径CSV> <输出> [宽x高] [帧率]
+// 路径按关节速度/加速度限值做时间参数化后按帧率采样；输出为目录、图像文件名模板（如out/frame.png）
+// 或原始RGB24视频（.rgb/.raw，或"-"写到标准输出），例如：
+//   work --render path.csv - 1280x720 30 | ffmpeg -f rawvideo -pix_fmt rgb24 -s 1280x720 -r 30 -i - out.mp4
+// 没有显示环境时使用offscreen平台插件和软件OpenGL（Mesa llvmpipe；Linux上该插件的OpenGL依赖GLX，可配合xvfb-run）
+static int renderVideo(int argc, char *argv[])
+{
+    if (argc < 4) {
+        std::fprintf(stderr, "用法：%s --render <路径CSV> <输出目录|图像模板|视频.rgb|-> [宽x高] [帧率]\n", argv[0]);
+        return 1;
+    }
+    OffscreenRenderer::Options options;
+    options.output = QString::fromLocal8Bit(argv[3]);
+    if (argc > 4) {
+        int width = 0, height = 0;
+        if (std::sscanf(argv[4], "%dx%d", &width, &height) != 2 || width <= 0 || height <= 0) {
+            std::fprintf(stderr, "分辨率格式应为宽x高：%s\n", argv[4]);
+            return 1;
+        }
+        options.size = QSize(width, height);
+    }
+    const double frameRate = argc > 5 ? QByteArray(argv[5]).toDouble() : 30.0;
+    if (!(frameRate > 0)) {
+        std::fprintf(stderr, "帧率必须大于0\n");
+        return 1;
+    }
+
+    const bool headless = qEnvironmentVariableIsEmpty("DISPLAY") && qEnvironmentVariableIsEmpty("WAYLAND_DISPLAY");
+    if (headless && qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    if (headless && qEnvironmentVariableIsEmpty("LIBGL_ALWAYS_SOFTWARE")) {
+        qputenv("LIBGL_ALWAYS_SOFTWARE", "1");
+        QCoreApplication::setAttribute(Qt::AA_UseSoftwareOpenGL);
+    }
+    QSurfaceFormat format;
+    format.setRenderableType(QSurfaceFormat::OpenGL);
+    format.setVersion(3, 2);
+    format.setProfile(QSurfaceFormat::CoreProfile);
+    QSurfaceFormat::setDefaultFormat(format);
+
+    QGuiApplication app(argc, argv);
+    loadCalibratedModel();
+    QVector<double> path;
+    if (!readJointPath(argv[2], path)) {
+        return 1;
+    }
+    TrajectoryTiming::Profile profile;
+    QVector<double> frames, velocities;
+    if (!TrajectoryTiming::computeProfile(path.constData(), path.size() / 4, TrajectoryTiming::defaultLimits(), profile)) {
+        std::fprintf(stderr, "路径时间参数化失败\n");
+        return 1;
+    }
+    TrajectoryTiming::resample(path.constData(), path.size() / 4, profile, frameRate, frames, velocities);
+    const int frameCount = frames.size() / 4;
+    std::fprintf(stderr, "路径时长%.2f s，%d帧（%dx%d，%.1f帧/秒）\n", profile.duration, frameCount,
+                 options.size.width(), options.size.height(), frameRate);
+
+    // 状态信息写到标准错误，标准输出可能用于原始视频
+    OffscreenRenderer renderer;
+    const int reportEvery = qMax(1, int(frameRate));
+    QObject::connect(&renderer, &OffscreenRenderer::progress, [reportEvery](int done, int total) {
+        if (done % reportEvery == 0 || done == total) {
+            std::fprintf(stderr, "\r已渲染 %d/%d", done, total);
+        }
+    });
+    QObject::connect(&renderer, &OffscreenRenderer::finished, &app, [&app](bool ok) { app.exit(ok ? 0 : 1); });
+    if (!renderer.start(frames, options)) {
+        std::fprintf(stderr, "%s\n", renderer.errorString().toLocal8Bit().constData());
+        return 1;
+    }
+    const int code = app.exec();
+    std::fprintf(stderr, "\n");
+    if (code != 0) {
+        std::fprintf(stderr, "%s\n", renderer.errorString().toLocal8Bit().constData());
+        return code;
+    }
+
+    const OffscreenRenderer::Stats &s = renderer.stats();
+    const double seconds = qMax(s.wallMs / 1000, 1e-9);
+    std::fprintf(stderr, "%d帧用时%.2f s（%.1f帧/秒，实时的%.1f倍），渲染与读回%.1f ms/帧，编码与写盘%.1f ms/帧\n",
+                 s.frames, seconds, s.frames / seconds, s.frames / frameRate / seconds,
+                 s.renderMs / qMax(s.frames, 1), s.encodeMs / qMax(s.frames, 1));
+    return 0;
+}
 
 int main(int argc, char *argv[])
 {
+    if (argc > 1 && std::strcmp(argv[1], "--build-ik-seeds") == 0) {
+        return buildIkSeeds(argc, argv);
+    }
+    if (argc > 1 && std::strcmp(argv[1], "--calibrate") == 0) {
+        return calibrate(argc, argv);
+    }
+    if (argc > 1 && std::strcmp(argv[1], "--serve") == 0) {
+        return serve(argc, argv);
+    }
+    if (argc > 1 && std::strcmp(argv[1], "--sim-controller") == 0) {
+        return simulateController(argc, argv);
+    }
+    if (argc > 1 && std::strcmp(argv[1], "--stream-test") == 0) {
+        return streamTest(argc, argv);
+    }
+    if (argc > 1 && std::strcmp(argv[1], "--cell-bench") == 0) {
+        return cellBenchmark(argc, argv);
+    }
+    if (argc > 1 && std::strcmp(argv[1], "--swept-volume") == 0) {
+        return sweptVolume(argc, argv);
+    }
+    if (argc > 1 && std::strcmp(argv[1], "--render") == 0) {
+        return renderVideo(argc, argv);
+    }
+
+    // 启动耗时统计（--startup-report 或 ARM_STARTUP_REPORT 时输出）
+    StartupProfiler::start(argc, argv);
+
     // 设置 OpenGL 版本
     QSurfaceFormat format;
     format.setRenderableType(QSurfaceFormat::OpenGL);
@@ -21,7 +499,14 @@ int main(int argc, char *argv[])
     QLoggingCategory::setFilterRules("qt.rhi.*=true");
 
     QApplication a(argc, argv);
+    loadCalibratedModel();
+    MetricsExporter metrics;
+    startMetrics(metrics);
+    StartupProfiler::mark("QApplication就绪");
+
+    // 三维场景在窗口首次显示后才创建，见MainWindow::initScene
     MainWindow w;
     w.show();
+    StartupProfiler::mark("主窗口显示");
     return a.exec();
 }
@@ -1,9 +1,16 @@
 #include "mainwindow.h"
 #include "ui_mainwindow.h"
 #include <cmath>
+#include <limits>
 #include <QMessageBox>
 #include <QHeaderView>
 #include <QTextEdit>
+#include <QFileDialog>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QDir>
+#include <QSaveFile>
+#include <QInputDialog>
 #include <Qt3DExtras/Qt3DWindow>
 #include <Qt3DExtras/QOrbitCameraController>
 #include <Qt3DCore/QEntity>
@@ -19,182 +26,113 @@
 #include <Qt3DExtras/QForwardRenderer>
 #include <QPointLight>
 #include <Qt3DExtras/QDiffuseSpecularMaterial>
+#include <Qt3DExtras/QPhongAlphaMaterial>
+#include <Qt3DRender/QMesh>
 #include <QTimer>
+#include <QtConcurrent>
+#include "armscene.h"
+#include "metrics.h"
+#include "startupprofiler.h"
+#include "trajectorytiming.h"
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
     , ui(new Ui::MainWindow)
+    , view3D(nullptr)
+    , camera(nullptr)
+    , armScene(nullptr)
+    , descriptionDialog(nullptr)
+    , motionPlanner(collisionChecker)
+    , currentAngles(4, 0.0)
+    , animationIndex(0)
+    , renderScheduler(nullptr)
+    , cellThread(nullptr)
+    , cellRoot(nullptr)
+    , sweptEntity(nullptr)
 {
     ui->setupUi(this);
 
-    // 创建3D窗口
-    view3D = new Qt3DExtras::Qt3DWindow();
-    container3D = QWidget::createWindowContainer(view3D, this); // 将3D窗口嵌入到QWidget
-    container3D->setMinimumSize(QSize(400, 300)); // 设置最小尺寸
-
-    // 创建根实体
-    rootEntity = new Qt3DCore::QEntity();
-
-    // 设置相机
-    camera = view3D->camera();
-    // 调整视点位置，使相机远离机械臂，扩大展示范围
-    camera->setPosition(QVector3D(5, 5, 5));
-    camera->setViewCenter(QVector3D(0, 0, 0));
-    camera->setUpVector(QVector3D(0, 1, 0));
-    camera->setProjectionType(Qt3DRender::QCameraLens::PerspectiveProjection);
-    // 增大视场角，从45.0f调整为60.0f
-    camera->setFieldOfView(60.0f);
-    // 调整近裁剪面，适当缩小，从0.1f调整为0.01f
-    camera->setNearPlane(0.01f);
-    // 调整远裁剪面，适当增大，从1000.0f调整为2000.0f
-    camera->setFarPlane(2000.0f);
-
-
-
-    // 设置光照
-    Qt3DCore::QEntity *lightEntity = new Qt3DCore::QEntity(rootEntity);
-    Qt3DRender::QPointLight *light = new Qt3DRender::QPointLight(lightEntity);
-    light->setColor(Qt::white);
-    light->setIntensity(1.0f);
-    lightEntity->addComponent(light);
-
-    // 设置光源位置
-    Qt3DCore::QTransform *lightTransform = new Qt3DCore::QTransform(lightEntity);
-    lightTransform->setTranslation(QVector3D(5, 5, 5)); // 调整光源位置
-    lightEntity->addComponent(lightTransform);
-
-    // 创建坐标系辅助线
-    createCoordinateAxes();
-
-    // 创建末端执行器（红色球体）
-    endEffector = new Qt3DCore::QEntity(rootEntity);
-    Qt3DExtras::QSphereMesh *eeMesh = new Qt3DExtras::QSphereMesh();
-    eeMesh->setRadius(0.08f); // 半径8厘米
-    Qt3DExtras::QPhongMaterial *eeMaterial = new Qt3DExtras::QPhongMaterial();
-    eeMaterial->setDiffuse(Qt::red); // 红色材质
-    eeTransform = new Qt3DCore::QTransform();
-    endEffector->addComponent(eeMesh);
-    endEffector->addComponent(eeMaterial);
-    endEffector->addComponent(eeTransform);
-
-
-
-    // // 1. 创建关节实体
-    // Qt3DCore::QEntity *joint1 = new Qt3DCore::QEntity(rootEntity);
-
-    // // 2. 添加圆柱体网格（表示关节）
-    // Qt3DExtras::QCylinderMesh *jointMesh = new Qt3DExtras::QCylinderMesh(joint1);
-    // jointMesh->setRadius(0.1f);    // 半径
-    // jointMesh->setLength(0.5f);    // 长度
-    // jointMesh->setRings(10);       // 细分段数（提高渲染质量）
-
-    // // 3. 添加材质（黄色）
-    // Qt3DExtras::QDiffuseSpecularMaterial *jointMaterial = new Qt3DExtras::QDiffuseSpecularMaterial(joint1);
-    // jointMaterial->setDiffuse(QColor(255, 255, 0)); // 黄色
-    // jointMaterial->setSpecular(QColor(0, 0, 0, 0)); // 禁用高光
-
-    // // 4. 添加变换组件（控制位置和旋转）
-    // jointTransform = new Qt3DCore::QTransform(joint1);
-    // jointTransform->setTranslation(QVector3D(0, 0.25f, 0)); // 居中（长度的一半）
-
-    // // 5. 将组件附加到实体
-    // joint1->addComponent(jointMesh);
-    // joint1->addComponent(jointMaterial);
-    // joint1->addComponent(jointTransform);
-    // 关节参数配置（单位：米）
-    // 关节位置参数
-    const QVector<QVector3D> jointPositions = {
-        QVector3D(0.0, 0.0, 0.0),     // 关节1位置
-        QVector3D(0.0, 0.2, 0.0),     // 关节2位置
-        QVector3D(0.0, 0.4, 0.0),     // 关节3位置
-        QVector3D(0.0, 0.6, 0.0),     // 关节4位置
-        //QVector3D(0.0, 0.8, 0.0),     // 关节5位置
-        //QVector3D(0.0, 1.0, 0.0)      // 关节6位置
-    };
-
-    // MDH参数格式：{theta_i, d_i, a_i, alpha_i}
-    const QVector<QVector<double>> MDH = {
-        {0, 0, 0, 0},               // 关节1: alpha=0（绕X轴旋转0°）
-        {0, 0, 0.325, -M_PI/2},     // 关节2: alpha=-90°（绕X轴旋转-90°）
-        {0, 0, 1.150, 0},           // 关节3: alpha=0
-        {0, 1.225, 0.300, -M_PI/2}, // 关节4: alpha=-90°
-        //{0, 0, 0, M_PI/2},          // 关节5: alpha=90°
-        //{0, 0, 0, -M_PI/2}          // 关节6: alpha=-90°
-    };
-
-    // 将根实体绑定到窗口
-    view3D->setRootEntity(rootEntity);
+    // 加载逆解初值数据库（由 work --build-ik-seeds 离线生成，不存在时跳过）
+    ikSeedDatabase.load(QCoreApplication::applicationDirPath() + "/ik_seeds.bin");
+
+    // 路径播放定时器（约60帧/秒）
+    pathTimer = new QTimer(this);
+    pathTimer->setInterval(16);
+    connect(pathTimer, &QTimer::timeout, this, &MainWindow::onPathAnimationStep);
+
+    // 正解、逆解和路径规划在线程池中执行，完成后由GUI线程统一刷新界面
+    forwardWatcher = new QFutureWatcher<ForwardSolveResult>(this);
+    inverseWatcher = new QFutureWatcher<InverseSolveResult>(this);
+    planWatcher = new QFutureWatcher<PathPlanResult>(this);
+    connect(forwardWatcher, &QFutureWatcherBase::finished, this, [this]() {
+        if (!forwardWatcher->isCanceled() && forwardWatcher->future().resultCount() > 0) {
+            applyForwardResult(forwardWatcher->result());
+        }
+    });
+    connect(inverseWatcher, &QFutureWatcherBase::finished, this, [this]() {
+        if (!inverseWatcher->isCanceled() && inverseWatcher->future().resultCount() > 0) {
+            applyInverseResult(inverseWatcher->result());
+        }
+    });
+    connect(planWatcher, &QFutureWatcherBase::finished, this, [this]() {
+        if (!planWatcher->isCanceled() && planWatcher->future().resultCount() > 0) {
+            applyPathPlan(planWatcher->result());
+        }
+    });
+    toolPathWatcher = new QFutureWatcher<ToolPathResult>(this);
+    connect(toolPathWatcher, &QFutureWatcherBase::finished, this, [this]() {
+        if (!toolPathWatcher->isCanceled() && toolPathWatcher->future().resultCount() > 0) {
+            applyToolPath(toolPathWatcher->result());
+        }
+    });
 
-    for(int i = 0; i < 4; i++){
-        Qt3DCore::QEntity *joint = new Qt3DCore::QEntity(rootEntity);
-        // 修改为球体网格
-        Qt3DExtras::QSphereMesh *mesh = new Qt3DExtras::QSphereMesh();
-        mesh->setRadius(0.05); // 设置球体半径
-
-        // Qt3DCore::QTransform *transform = new Qt3DCore::QTransform();
-        // transform->setTranslation(jointParams[i]);
-
-        Qt3DExtras::QPhongMaterial *material = new Qt3DExtras::QPhongMaterial();
-        material->setDiffuse(QColor(255, 255, 0)); // 黄色
-
-        // 变换组件（设置位置和初始旋转轴）
-        Qt3DCore::QTransform *transform = new Qt3DCore::QTransform(joint);
-        transform->setTranslation(jointPositions[i]); // 设置位置
-        // transform->setRotationX(qRadiansToDegrees(MDH[i][3])); // 设置绕X轴的初始旋转（alpha_i）
-        transform->setRotationX(0); // 初始无旋转
-
-        joint->addComponent(mesh);
-        joint->addComponent(material);
-        joint->addComponent(transform);
-        jointTransforms.append(transform);
-
-        // 创建连杆
-        if (i > 0) {
-            Qt3DCore::QEntity *link = new Qt3DCore::QEntity(rootEntity);
-            Qt3DExtras::QCylinderMesh *linkMesh = new Qt3DExtras::QCylinderMesh();
-            linkMesh->setRadius(0.03);
-
-            // 计算连杆的长度和方向
-            QVector3D start = jointPositions[i - 1];
-            QVector3D end = jointPositions[i];
-            QVector3D direction = end - start;
-            float length = direction.length();
-            linkMesh->setLength(length);
-
-            // 计算连杆的旋转
-            QVector3D up = QVector3D(0, 1, 0);
-            QVector3D axis = QVector3D::crossProduct(up, direction.normalized());
-            float angle = qRadiansToDegrees(qAcos(QVector3D::dotProduct(up, direction.normalized())));
-
-            Qt3DCore::QTransform *linkTransform = new Qt3DCore::QTransform();
-            linkTransform->setTranslation(start + direction / 2);
-            linkTransform->setRotation(QQuaternion::fromAxisAndAngle(axis, angle));
-
-            Qt3DExtras::QPhongMaterial *linkMaterial = new Qt3DExtras::QPhongMaterial();
-            linkMaterial->setDiffuse(QColor(128, 128, 128)); // 灰色
-            link->addComponent(linkMesh);
-            link->addComponent(linkMaterial);
-            link->addComponent(linkTransform);
-
-            linkEntities.append(link);
-            linkTransforms.append(linkTransform);
+    sweptWatcher = new QFutureWatcher<SweptVolumeResult>(this);
+    connect(sweptWatcher, &QFutureWatcherBase::finished, this, [this]() {
+        if (!sweptWatcher->isCanceled() && sweptWatcher->future().resultCount() > 0) {
+            pendingSweptFile.clear();
+            applySweptVolume(sweptWatcher->result());
         }
-    }
+        removeDiscardedSweptFiles();
+    });
 
-    // 记录关节和连杆的初始变换
-    for (int i = 0; i < jointTransforms.size(); ++i) {
-        jointInitialTransforms.append(jointTransforms[i]->matrix());
-    }
-    for (int i = 0; i < linkTransforms.size(); ++i) {
-        linkInitialTransforms.append(linkTransforms[i]->matrix());
-    }
+    // 单元仿真在专用线程中按实时推进，每步的并行计算使用独立线程池，界面只定时读取最新快照
+    cellSimulation.setThreadPool(&cellPool);
+    cellViewTimer = new QTimer(this);
+    cellViewTimer->setInterval(33);
+    connect(cellViewTimer, &QTimer::timeout, this, &MainWindow::updateCellView);
 
     this->setWindowTitle("4自由度磨抛机器人控制界面");
 
     // 创建输入输出表格
     poseMatrixInputTable = new QTableWidget(4, 4, this);
-    forwardResultTable = new QTableWidget(4, 4, this);
-    inverseResultTable = new QTableWidget(8, 6, this);
+    forwardResultTable = new QTableView(this);
+    inverseResultTable = new QTableView(this);
+    trajectoryTable = new QTableView(this);
+    forwardModel = new NumericTableModel(this);
+    inverseModel = new NumericTableModel(this);
+    trajectoryModel = new NumericTableModel(this);
+    forwardResultTable->setModel(forwardModel);
+    inverseResultTable->setModel(inverseModel);
+    trajectoryTable->setModel(trajectoryModel);
+    // 行高固定，大量行时视图无需逐行测量
+    for (QTableView *view : {forwardResultTable, inverseResultTable, trajectoryTable}) {
+        view->verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
+        view->setSelectionBehavior(QAbstractItemView::SelectRows);
+    }
+    inverseResultTable->horizontalHeader()->setSortIndicator(-1, Qt::AscendingOrder);
+    inverseResultTable->setSortingEnabled(true);
+
+    // 逆解过滤条件：残差上限和限位裕度下限
+    residualFilter = new QDoubleSpinBox(this);
+    residualFilter->setDecimals(6);
+    residualFilter->setRange(0, 1000);
+    residualFilter->setSingleStep(0.001);
+    residualFilter->setValue(1000);
+    marginFilter = new QDoubleSpinBox(this);
+    marginFilter->setDecimals(3);
+    marginFilter->setRange(0, M_PI);
+    marginFilter->setSingleStep(0.05);
+    marginFilter->setValue(0);
 
     // 创建关节角度输入框
     theta1Edit = new QLineEdit(this);
@@ -212,16 +150,18 @@ MainWindow::MainWindow(QWidget *parent)
     // 创建错误提示标签
     errorLabel = new QLabel(this);
 
+    // 构建碰撞检测场景（工作单元文件读取失败时在错误提示标签中显示）
+    setupCollisionScene();
+
     // 设置表格表头
     QStringList horizontalHeaders = {"R11", "R12", "R13", "T1"};
     QStringList verticalHeaders = {"R21", "R22", "R23", "T2"};
     poseMatrixInputTable->setHorizontalHeaderLabels(horizontalHeaders);
     poseMatrixInputTable->setVerticalHeaderLabels(verticalHeaders);
-    forwardResultTable->setHorizontalHeaderLabels(horizontalHeaders);
-    forwardResultTable->setVerticalHeaderLabels(verticalHeaders);
-
-    horizontalHeaders << "关节1" << "关节2" << "关节3" << "关节4" << "关节5" << "关节6";
-    inverseResultTable->setHorizontalHeaderLabels(horizontalHeaders);
+    forwardModel->setHeaders(horizontalHeaders);
+    inverseModel->setHeaders({"关节1", "关节2", "关节3", "关节4", "残差", "限位裕度"});
+    trajectoryModel->setHeaders({"时间(s)", "关节1", "关节2", "关节3", "关节4",
+                                 "力矩1", "力矩2", "力矩3", "力矩4"});
 
     // 布局管理
     QVBoxLayout *inputLayout = new QVBoxLayout;
@@ -243,7 +183,15 @@ MainWindow::MainWindow(QWidget *parent)
     outputLayout->addWidget(new QLabel("正解结果："));
     outputLayout->addWidget(forwardResultTable);
     outputLayout->addWidget(new QLabel("逆解结果："));
+    QHBoxLayout *filterLayout = new QHBoxLayout;
+    filterLayout->addWidget(new QLabel("残差≤"));
+    filterLayout->addWidget(residualFilter);
+    filterLayout->addWidget(new QLabel("限位裕度≥"));
+    filterLayout->addWidget(marginFilter);
+    outputLayout->addLayout(filterLayout);
     outputLayout->addWidget(inverseResultTable);
+    outputLayout->addWidget(new QLabel("轨迹采样："));
+    outputLayout->addWidget(trajectoryTable);
 
     QHBoxLayout *mainLayout = new QHBoxLayout;
     mainLayout->addLayout(inputLayout);
@@ -258,16 +206,31 @@ MainWindow::MainWindow(QWidget *parent)
     connect(forwardSolveButton, &QPushButton::clicked, this, &MainWindow::onForwardSolveClicked);
     connect(inverseSolveButton, &QPushButton::clicked, this, &MainWindow::onInverseSolveClicked);
     connect(resetButton, &QPushButton::clicked, this, &MainWindow::onResetClicked);
-    connect(inverseResultTable, &QTableWidget::cellClicked, this, &MainWindow::onInverseResultSelected);
+    connect(inverseResultTable, &QTableView::clicked, this, &MainWindow::onInverseResultSelected);
+    connect(residualFilter, &QDoubleSpinBox::valueChanged, this, &MainWindow::onInverseFilterChanged);
+    connect(marginFilter, &QDoubleSpinBox::valueChanged, this, &MainWindow::onInverseFilterChanged);
 
     // 创建菜单栏和状态栏
     QMenu *fileMenu = menuBar()->addMenu("文件");
+    QAction *toolPathAction = new QAction("由工件网格生成磨抛路径…", this);
+    connect(toolPathAction, &QAction::triggered, this, &MainWindow::onGenerateToolPath);
+    fileMenu->addAction(toolPathAction);
+    QAction *sweptAction = new QAction("当前路径的扫掠体积与间隙", this);
+    connect(sweptAction, &QAction::triggered, this, &MainWindow::onSweptVolume);
+    fileMenu->addAction(sweptAction);
+    cellAction = new QAction("多机器人单元仿真（演示）", this);
+    cellAction->setCheckable(true);
+    connect(cellAction, &QAction::toggled, this, &MainWindow::onCellSimulationToggled);
+    fileMenu->addAction(cellAction);
     QAction *exitAction = new QAction("退出", this);
     connect(exitAction, &QAction::triggered, qApp, &QApplication::quit);
     fileMenu->addAction(exitAction);
 
     statusBar()->showMessage("准备就绪");
 
+    renderStatsLabel = new QLabel(this);
+    statusBar()->addPermanentWidget(renderStatsLabel);
+
     // 为关节角度输入框添加工具提示，提示用户输入有效的数字
     theta1Edit->setToolTip("请输入关节1的角度值（单位：弧度）");
     theta2Edit->setToolTip("请输入关节2的角度值（单位：弧度）");
@@ -283,7 +246,10 @@ MainWindow::MainWindow(QWidget *parent)
     forwardResultTable->setToolTip("正解计算结果将显示在此表格中，格式为4x4的位姿矩阵");
 
     // 为逆解结果输出表格添加工具提示，提示用户查看逆解计算结果
-    inverseResultTable->setToolTip("逆解计算结果将显示在此表格中，每行表示一组关节角度解");
+    inverseResultTable->setToolTip("逆解计算结果将显示在此表格中，每行表示一组关节角度解，点击表头可排序");
+    residualFilter->setToolTip("只显示位姿残差不超过该值的解");
+    marginFilter->setToolTip("只显示各关节距限位的最小距离（弧度）不小于该值的解");
+    trajectoryTable->setToolTip("规划轨迹按播放频率的采样点及估算的关节力矩");
 
     // 为正解计算按钮添加工具提示
     forwardSolveButton->setToolTip("点击此按钮进行正解计算，根据输入的关节角度计算末端执行器位姿矩阵");
@@ -297,45 +263,11 @@ MainWindow::MainWindow(QWidget *parent)
     // 创建展开/折叠按钮
     QPushButton *toggleButton = new QPushButton("矩阵和机械臂说明", this);
 
-    // 创建一个对话框用于显示矩阵描述
-    QDialog *descriptionDialog = new QDialog(this);
-    descriptionDialog->setWindowTitle("矩阵和机械臂说明");
-    descriptionDialog->setMinimumSize(400, 300); // 设置对话框的最小尺寸
-
-    // 创建文本编辑框用于显示矩阵描述
-    QTextEdit *descriptionTextEdit = new QTextEdit(descriptionDialog);
-    descriptionTextEdit->setReadOnly(true);
-
-    // 矩阵描述内容
-    QString matrixDescription = "矩阵各元素含义说明\n\n"
-                                "旋转矩阵部分\n"
-                                "- R11：旋转矩阵第一行第一列元素，代表末端执行器在基础坐标系下X轴旋转分量。\n"
-                                "- R12：旋转矩阵第一行第二列元素，代表末端执行器在基础坐标系下Y轴旋转分量。\n"
-                                "- R13：旋转矩阵第一行第三列元素，代表末端执行器在基础坐标系下Z轴旋转分量。\n"
-                                "- R21：旋转矩阵第二行第一列元素，代表末端执行器在基础坐标系下X轴旋转分量。\n"
-                                "- R22：旋转矩阵第二行第二列元素，代表末端执行器在基础坐标系下Y轴旋转分量。\n"
-                                "- R23：旋转矩阵第二行第三列元素，代表末端执行器在基础坐标系下Z轴旋转分量。\n\n"
-                                "平移向量部分\n"
-                                "- T1：平移向量第一个元素，代表末端执行器在基础坐标系下X轴的平移分量。\n"
-                                "- T2：平移向量第二个元素，代表末端执行器在基础坐标系下Y轴的平移分量。\n\n"
-                                "机械臂 3D 显示相关说明\n"
-                                "- 关节表示：在 3D 显示中，每个关节用黄色球体表示，其位置根据机械臂的运动学模型和关节角度确定。当输入不同的关节角度进行正解计算时，关节的旋转会根据输入的角度值进行更新，从而改变机械臂的姿态。\n"
-                                "- 连杆表示：连杆用灰色圆柱体表示，连接相邻的两个关节。连杆的长度和方向会根据关节的位置动态计算和更新。当关节位置改变时，连杆会自动调整其长度、方向和旋转，以正确连接两个关节。\n"
-                                "- 末端执行器表示：末端执行器用红色球体表示，其位姿由旋转矩阵和平移向量共同确定。在进行正解计算后，末端执行器会根据计算得到的位姿矩阵更新其位置和姿态，在 3D 场景中同步显示。\n"
-                                "- 坐标系辅助线：为了便于观察和理解机械臂的运动，3D 场景中添加了坐标系辅助线。X 轴为红色圆柱体，Y 轴为绿色圆柱体，Z 轴为蓝色圆柱体，帮助确定机械臂在空间中的位置和方向。\n";
-    descriptionTextEdit->setPlainText(matrixDescription);
-
-    // 创建关闭按钮
-    QPushButton *closeButton = new QPushButton("关闭", descriptionDialog);
-    connect(closeButton, &QPushButton::clicked, descriptionDialog, &QDialog::close);
-
-    // 设置对话框的布局
-    QVBoxLayout *dialogLayout = new QVBoxLayout(descriptionDialog);
-    dialogLayout->addWidget(descriptionTextEdit);
-    dialogLayout->addWidget(closeButton);
-
-    // 连接按钮点击信号到槽函数
-    connect(toggleButton, &QPushButton::clicked, [=]() {
+    // 说明对话框很少打开，首次点击时再创建
+    connect(toggleButton, &QPushButton::clicked, this, [=]() {
+        if (!descriptionDialog) {
+            createDescriptionDialog();
+        }
         if (descriptionDialog->isHidden()) {
             descriptionDialog->show();
             toggleButton->setText("折叠矩阵描述");
@@ -348,6 +280,11 @@ MainWindow::MainWindow(QWidget *parent)
     // 创建一个垂直布局用于放置按钮
    // QVBoxLayout *mainLayout = new QVBoxLayout;
     mainLayout->addWidget(toggleButton);
+    // 三维视图在窗口显示后再创建（见initScene），先用占位标签保持布局
+    QLabel *placeholder = new QLabel("正在加载三维视图…", this);
+    placeholder->setAlignment(Qt::AlignCenter);
+    placeholder->setMinimumSize(QSize(400, 300));
+    container3D = placeholder;
     mainLayout->addWidget(container3D); // 假设mainLayout是QHBoxLayout
 
     // 创建一个中心部件并设置布局
@@ -368,238 +305,121 @@ MainWindow::MainWindow(QWidget *parent)
     // 连接信号槽
     connect(zoomInButton, &QPushButton::clicked, this, &MainWindow::onZoomInClicked);
     connect(zoomOutButton, &QPushButton::clicked, this, &MainWindow::onZoomOutClicked);
+
+    StartupProfiler::mark("主窗口构造完成");
 }
 
 MainWindow::~MainWindow()
 {
+    // 后台任务引用碰撞检测等成员，需在析构前结束；
+    // 被新任务取代的任务不再由监视器持有，但仍可能在运行，因此等待整个线程池
+    cancelPendingSolves();
+    solvePool.waitForDone();
+    stopCellSimulation();
+    clearSweptVolume();
+    delete armScene;
     delete ui;
 }
 
-QVector<QVector<double>> multiplyMatrix(const QVector<QVector<double>>& m1, const QVector<QVector<double>>& m2);
-
-QVector<QVector<double>> MainWindow::myfkine(double theta1, double theta2, double theta3, double theta4)
+void MainWindow::showEvent(QShowEvent *event)
 {
-    // 根据原MATLAB代码中的myfkine函数逻辑实现
-    QVector<QVector<double>> MDH = {
-        {theta1, 0, 0, 0},
-        {theta2, 0, 0.325, -M_PI/2},
-        {theta3, 0, 1.150, 0},
-        {theta4, 1.225, 0.300, -M_PI/2}
-        //{theta5, 0, 0, M_PI/2},
-        //{theta6, 0, 0, -M_PI/2}
-    };
-
-    QVector<QVector<double>> T01 = {
-        {cos(MDH[0][0]), -sin(MDH[0][0]), 0, MDH[0][2]},
-        {cos(MDH[0][3])*sin(MDH[0][0]), cos(MDH[0][3])*cos(MDH[0][0]), -sin(MDH[0][3]), -MDH[0][1]*sin(MDH[0][3])},
-        {sin(MDH[0][3])*sin(MDH[0][0]), sin(MDH[0][3])*cos(MDH[0][0]), cos(MDH[0][3]), MDH[0][1]*cos(MDH[0][3])},
-        {0, 0, 0, 1}
-    };
-
-    QVector<QVector<double>> T12 = {
-        {cos(MDH[1][0]), -sin(MDH[1][0]), 0, MDH[1][2]},
-        {cos(MDH[1][3])*sin(MDH[1][0]), cos(MDH[1][3])*cos(MDH[1][0]), -sin(MDH[1][3]), -MDH[1][1]*sin(MDH[1][3])},
-        {sin(MDH[1][3])*sin(MDH[1][0]), sin(MDH[1][3])*cos(MDH[1][0]), cos(MDH[1][3]), MDH[1][1]*cos(MDH[1][3])},
-        {0, 0, 0, 1}
-    };
-
-    QVector<QVector<double>> T23 = {
-        {cos(MDH[2][0]), -sin(MDH[2][0]), 0, MDH[2][2]},
-        {cos(MDH[2][3])*sin(MDH[2][0]), cos(MDH[2][3])*cos(MDH[2][0]), -sin(MDH[2][3]), -MDH[2][1]*sin(MDH[2][3])},
-        {sin(MDH[2][3])*sin(MDH[2][0]), sin(MDH[2][3])*cos(MDH[2][0]), cos(MDH[2][3]), MDH[2][1]*cos(MDH[2][3])},
-        {0, 0, 0, 1}
-    };
-
-    QVector<QVector<double>> T34 = {
-        {cos(MDH[3][0]), -sin(MDH[3][0]), 0, MDH[3][2]},
-        {cos(MDH[3][3])*sin(MDH[3][0]), cos(MDH[3][3])*cos(MDH[3][0]), -sin(MDH[3][3]), -MDH[3][1]*sin(MDH[3][3])},
-        {sin(MDH[3][3])*sin(MDH[3][0]), sin(MDH[3][3])*cos(MDH[3][0]), cos(MDH[3][3]), MDH[3][1]*cos(MDH[3][3])},
-        {0, 0, 0, 1}
-    };
-
-    // QVector<QVector<double>> T45 = {
-    //     {cos(MDH[4][0]), -sin(MDH[4][0]), 0, MDH[4][2]},
-    //     {cos(MDH[4][3])*sin(MDH[4][0]), cos(MDH[4][3])*cos(MDH[4][0]), -sin(MDH[4][3]), -MDH[4][1]*sin(MDH[4][3])},
-    //     {sin(MDH[4][3])*sin(MDH[4][0]), sin(MDH[4][3])*cos(MDH[4][0]), cos(MDH[4][3]), MDH[4][1]*cos(MDH[4][3])},
-    //     {0, 0, 0, 1}
-    // };
-
-    // QVector<QVector<double>> T56 = {
-    //     {cos(MDH[5][0]), -sin(MDH[5][0]), 0, MDH[5][2]},
-    //     {cos(MDH[5][3])*sin(MDH[5][0]), cos(MDH[5][3])*cos(MDH[5][0]), -sin(MDH[5][3]), -MDH[5][1]*sin(MDH[5][3])},
-    //     {sin(MDH[5][3])*sin(MDH[5][0]), sin(MDH[5][3])*cos(MDH[5][0]), cos(MDH[5][3]), MDH[5][1]*cos(MDH[5][3])},
-    //     {0, 0, 0, 1}
-    // };
-
-    // 矩阵相乘计算T04
-    QVector<QVector<double>> T04 = T01;
-    T04 = multiplyMatrix(T04, T12);
-    T04 = multiplyMatrix(T04, T23);
-    T04 = multiplyMatrix(T04, T34);
-    //T06 = multiplyMatrix(T06, T45);
-    //T06 = multiplyMatrix(T06, T56);
-
-    return T04;
+    QMainWindow::showEvent(event);
+    if (!view3D && !sceneInitQueued) {
+        // 先让输入界面完成首次绘制并响应操作，下一轮事件循环再创建Qt3D窗口；
+        // Qt3D的渲染器、场景导入等插件在此之前都不会加载
+        sceneInitQueued = true;
+        QTimer::singleShot(0, this, [this]() {
+            StartupProfiler::mark("首次可交互");
+            QTimer::singleShot(0, this, &MainWindow::initScene);
+        });
+    }
 }
 
-// 定义multiplyMatrix函数
-QVector<QVector<double>> multiplyMatrix(const QVector<QVector<double>>& m1, const QVector<QVector<double>>& m2) {
-    QVector<QVector<double>> result(4, QVector<double>(4, 0));
-    for (int i = 0; i < 4; ++i) {
-        for (int j = 0; j < 4; ++j) {
-            for (int k = 0; k < 4; ++k) {
-                result[i][j] += m1[i][k] * m2[k][j];
-            }
-        }
+void MainWindow::initScene()
+{
+    if (view3D) {
+        return;
     }
-    return result;
+
+    // 创建3D窗口
+    view3D = new Qt3DExtras::Qt3DWindow();
+    QWidget *container = QWidget::createWindowContainer(view3D, this); // 将3D窗口嵌入到QWidget
+    container->setMinimumSize(QSize(400, 300)); // 设置最小尺寸
+
+    // 设置相机
+    camera = view3D->camera();
+    ArmScene::setupCamera(camera);
+
+    // 创建根实体及机械臂场景
+    Qt3DCore::QEntity *rootEntity = new Qt3DCore::QEntity();
+    armScene = new ArmScene(rootEntity);
+
+    // 将根实体绑定到窗口
+    view3D->setRootEntity(rootEntity);
+
+    // 只在位姿、相机或场景变化时绘制；播放路径时关节角按帧率上限合并后应用
+    renderScheduler = new RenderScheduler(view3D->renderSettings(), this);
+    renderScheduler->setMaxFrameRate(60);
+    connect(renderScheduler, &RenderScheduler::poseReady, this, &MainWindow::updateJointTransforms);
+    connect(renderScheduler, &RenderScheduler::statsUpdated, this, [this](double poses, double cpu) {
+        renderStatsLabel->setText(QString("位姿刷新 %1 次/秒  CPU %2%").arg(poses, 0, 'f', 1).arg(cpu, 0, 'f', 1));
+    });
+
+    // 替换占位标签
+    delete centralWidget()->layout()->replaceWidget(container3D, container);
+    delete container3D;
+    container3D = container;
+
+    // 场景创建前已完成的正解或路径播放
+    if (endEffectorPose.size() == 16) {
+        armScene->setEndEffectorPose(endEffectorPose.constData());
+    }
+    if (currentAngles != QVector<double>(4, 0.0)) {
+        armScene->setJointAngles(currentAngles.constData());
+    }
+
+    StartupProfiler::mark("三维场景就绪");
+    StartupProfiler::report();
 }
 
-QVector<QVector<double>> MainWindow::mymodikine(const QVector<QVector<double>> &Tbe)
+void MainWindow::createDescriptionDialog()
 {
-    // 根据原MATLAB代码中的mymodikine函数逻辑实现
-    const double deg = M_PI / 180;
-    QVector<QVector<double>> MDH = {
-        {0, 0, 0, 0, -180 * deg, 180 * deg},
-        {0, 0, 0.325, -M_PI / 2, -60 * deg, 76 * deg},
-        {0, 0, 1.150, 0, -147 * deg, 90 * deg},
-        {0, 1.225, 0.300, -M_PI / 2, -210 * deg, 210 * deg}
-        // {0, 0, 0, M_PI / 2, -130 * deg, 130 * deg},
-        // {0, 0, 0, -M_PI / 2, -210 * deg, 210 * deg}
-    };
-
-    // 提取Tbe中的元素
-    double nx = Tbe[0][0], ny = Tbe[1][0], nz = Tbe[2][0];
-    double ox = Tbe[0][1], oy = Tbe[1][1], oz = Tbe[2][1];
-    double ax = Tbe[0][2], ay = Tbe[1][2], az = Tbe[2][2];
-    double px = Tbe[0][3], py = Tbe[1][3], pz = Tbe[2][3];
-
-    double d4 = MDH[3][1], d2 = 0, d3 = 0;
-    double a1 = MDH[1][2], a2 = MDH[2][2], a3 = MDH[3][2];
-    double f1 = -M_PI / 2, f3 = -M_PI / 2, f4 = M_PI / 2, f5 = -M_PI / 2;
-
-    QVector<QVector<double>> ikine_t(8, QVector<double>(4));
-
-    // 计算t1
-    double t11 = -atan2(-py, px)+atan2((d2 - d3) / sin(f1), sqrt(pow(px * sin(f1), 2)+pow(py * sin(f1), 2)-pow(d2 - d3, 2)));
-    double t12 = -atan2(-py, px)+atan2((d2 - d3) / sin(f1), -sqrt(pow(px * sin(f1), 2)+pow(py * sin(f1), 2)-pow(d2 - d3, 2)));
-
-    // 检查t11和t12是否在有效范围内
-    t11 = qBound(MDH[0][4], t11, MDH[0][5]);
-    t12 = qBound(MDH[0][4], t12, MDH[0][5]);
-
-    // 计算t3
-    double m3_1 = pz * sin(f1);
-    double n3_1 = a1 - px * cos(t11)-py * sin(t11);
-    double m3_2 = pz * sin(f1);
-    double n3_2 = a1 - px * cos(t12)-py * sin(t12);
-
-    double t31 = -atan2(a2 * a3 / sin(f3), a2 * d4)+atan2((pow(m3_1, 2)+pow(n3_1, 2)-a2 * a2 - a3 * a3 - d4 * d4) / sin(f3),
-                                                         sqrt(pow(2 * a2 * d4 * sin(f3), 2)+pow(2 * a2 * a3, 2)-pow(pow(m3_1, 2)+pow(n3_1, 2)-a2 * a2 - a3 * a3 - d4 * d4, 2)));
-    double t32 = -atan2(a2 * a3 / sin(f3), a2 * d4)+atan2((pow(m3_1, 2)+pow(n3_1, 2)-a2 * a2 - a3 * a3 - d4 * d4) / sin(f3),
-                                                         -sqrt(pow(2 * a2 * d4 * sin(f3), 2)+pow(2 * a2 * a3, 2)-pow(pow(m3_1, 2)+pow(n3_1, 2)-a2 * a2 - a3 * a3 - d4 * d4, 2)));
-    double t33 = -atan2(a2 * a3 / sin(f3), a2 * d4)+atan2((pow(m3_2, 2)+pow(n3_2, 2)-a2 * a2 - a3 * a3 - d4 * d4) / sin(f3),
-                                                         sqrt(pow(2 * a2 * d4 * sin(f3), 2)+pow(2 * a2 * a3, 2)-pow(pow(m3_2, 2)+pow(n3_2, 2)-a2 * a2 - a3 * a3 - d4 * d4, 2)));
-    double t34 = -atan2(a2 * a3 / sin(f3), a2 * d4)+atan2((pow(m3_2, 2)+pow(n3_2, 2)-a2 * a2 - a3 * a3 - d4 * d4) / sin(f3),
-                                                         -sqrt(pow(2 * a2 * d4 * sin(f3), 2)+pow(2 * a2 * a3, 2)-pow(pow(m3_2, 2)+pow(n3_2, 2)-a2 * a2 - a3 * a3 - d4 * d4, 2)));
-
-    // 检查t31 - t34是否在有效范围内
-    t31 = qBound(MDH[2][4], t31, MDH[2][5]);
-    t32 = qBound(MDH[2][4], t32, MDH[2][5]);
-    t33 = qBound(MDH[2][4], t33, MDH[2][5]);
-    t34 = qBound(MDH[2][4], t34, MDH[2][5]);
-
-    // 计算t2
-    double m2_1 = a2 + a3 * cos(t31)+d4 * sin(f3) * sin(t31);
-    double n2_1 = a3 * sin(t31)-d4 * sin(f3) * cos(t31);
-    double m2_2 = a2 + a3 * cos(t32)+d4 * sin(f3) * sin(t32);
-    double n2_2 = a3 * sin(t32)-d4 * sin(f3) * cos(t32);
-    double m2_3 = a2 + a3 * cos(t33)+d4 * sin(f3) * sin(t33);
-    double n2_3 = a3 * sin(t33)-d4 * sin(f3) * cos(t33);
-    double m2_4 = a2 + a3 * cos(t34)+d4 * sin(f3) * sin(t34);
-    double n2_4 = a3 * sin(t34)-d4 * sin(f3) * cos(t34);
-
-    double t21 = atan2(m3_1 * m2_1 + n2_1 * n3_1, m3_1 * n2_1 - m2_1 * n3_1);
-    double t22 = atan2(m3_1 * m2_2 + n2_2 * n3_1, m3_1 * n2_2 - m2_2 * n3_1);
-    double t23 = atan2(m3_2 * m2_3 + n2_3 * n3_2, m3_2 * n2_3 - m2_3 * n3_2);
-    double t24 = atan2(m3_2 * m2_4 + n2_4 * n3_2, m3_2 * n2_4 - m2_4 * n3_2);
-
-    // 检查t21 - t24是否在有效范围内
-    t21 = qBound(MDH[1][4], t21, MDH[1][5]);
-    t22 = qBound(MDH[1][4], t22, MDH[1][5]);
-    t23 = qBound(MDH[1][4], t23, MDH[1][5]);
-    t24 = qBound(MDH[1][4], t24, MDH[1][5]);
-
-    // 计算t5
-    double m5_1 = -sin(f5) * (ax * cos(t11) * cos(t21)+ay * sin(t11) * cos(t21)+az * sin(f1) * sin(t21));
-    double n5_1 = sin(f5) * (ax * cos(t11) * sin(t21)+ay * sin(t11) * sin(t21)-az * sin(f1) * cos(t21));
-    double m5_2 = -sin(f5) * (ax * cos(t11) * cos(t22)+ay * sin(t11) * cos(t22)+az * sin(f1) * sin(t22));
-    double n5_2 = sin(f5) * (ax * cos(t11) * sin(t22)+ay * sin(t11) * sin(t22)-az * sin(f1) * cos(t22));
-    double m5_3 = -sin(f5) * (ax * cos(t12) * cos(t23)+ay * sin(t12) * cos(t23)+az * sin(f1) * sin(t23));
-    double n5_3 = sin(f5) * (ax * cos(t12) * sin(t23)+ay * sin(t12) * sin(t23)-az * sin(f1) * cos(t23));
-    double m5_4 = -sin(f5) * (ax * cos(t12) * cos(t24)+ay * sin(t12) * cos(t24)+az * sin(f1) * sin(t24));
-    double n5_4 = sin(f5) * (ax * cos(t12) * sin(t24)+ay * sin(t12) * sin(t24)-az * sin(f1) * cos(t24));
-
-    double t51 = atan2(sqrt(pow(ay * cos(t11)-ax * sin(t11), 2)+pow(m5_1 * cos(t31)+n5_1 * sin(t31), 2)),
-                       (m5_1 * sin(t31)-n5_1 * cos(t31)) / (sin(f3) * sin(f4)));
-    double t52 = atan2(-sqrt(pow(ay * cos(t11)-ax * sin(t11), 2)+pow(m5_1 * cos(t31)+n5_1 * sin(t31), 2)),
-                       (m5_1 * sin(t31)-n5_1 * cos(t31)) / (sin(f3) * sin(f4)));
-    double t53 = atan2(sqrt(pow(ay * cos(t11)-ax * sin(t11), 2)+pow(m5_2 * cos(t32)+n5_2 * sin(t32), 2)),
-                       (m5_2 * sin(t32)-n5_2 * cos(t32)) / (sin(f3) * sin(f4)));
-    double t54 = atan2(-sqrt(pow(ay * cos(t11)-ax * sin(t11), 2)+pow(m5_2 * cos(t32)+n5_2 * sin(t32), 2)),
-                       (m5_2 * sin(t32)-n5_2 * cos(t32)) / (sin(f3) * sin(f4)));
-    double t55 = atan2(sqrt(pow(ay * cos(t12)-ax * sin(t12), 2)+pow(m5_3 * cos(t33)+n5_3 * sin(t33), 2)),
-                       (m5_3 * sin(t33)-n5_3 * cos(t33)) / (sin(f3) * sin(f4)));
-    double t56 = atan2(-sqrt(pow(ay * cos(t12)-ax * sin(t12), 2)+pow(m5_3 * cos(t33)+n5_3 * sin(t33), 2)),
-                       (m5_3 * sin(t33)-n5_3 * cos(t33)) / (sin(f3) * sin(f4)));
-    double t57 = atan2(sqrt(pow(ay * cos(t12)-ax * sin(t12), 2)+pow(m5_4 * cos(t34)+n5_4 * sin(t34), 2)),
-                       (m5_4 * sin(t34)-n5_4 * cos(t34)) / (sin(f3) * sin(f4)));
-    double t58 = atan2(-sqrt(pow(ay * cos(t12)-ax * sin(t12), 2)+pow(m5_4 * cos(t34)+n5_4 * sin(t34), 2)),
-                       (m5_4 * sin(t34)-n5_4 * cos(t34)) / (sin(f3) * sin(f4)));
-
-    // 计算t4
-    double t41 = sin(t51) == 0? 0 : atan2((ay * cos(t11)-ax * sin(t11)) * sin(f1) * sin(f5) / (-sin(t51) * sin(f3)),
-                                           (-m5_1 * cos(t31)-n5_1 * sin(t31)) / sin(t51));
-    double t42 = sin(t52) == 0? 0 : atan2((ay * cos(t11)-ax * sin(t11)) * sin(f1) * sin(f5) / (-sin(t52) * sin(f3)),
-                                           (-m5_1 * cos(t31)-n5_1 * sin(t31)) / sin(t52));
-    double t43 = sin(t53) == 0? 0 : atan2((ay * cos(t11)-ax * sin(t11)) * sin(f1) * sin(f5) / (-sin(t53) * sin(f3)),
-                                           (-m5_2 * cos(t32)-n5_2 * sin(t32)) / sin(t53));
-    double t44 = sin(t54) == 0? 0 : atan2((ay * cos(t11)-ax * sin(t11)) * sin(f1) * sin(f5) / (-sin(t54) * sin(f3)),
-                                           (-m5_2 * cos(t32)-n5_2 * sin(t32)) / sin(t54));
-    double t45 = sin(t55) == 0? 0 : atan2((ay * cos(t12)-ax * sin(t12)) * sin(f1) * sin(f5) / (-sin(t55) * sin(f3)),
-                                           (-m5_3 * cos(t33)-n5_3 * sin(t33)) / sin(t55));
-    double t46 = sin(t56) == 0? 0 : atan2((ay * cos(t12)-ax * sin(t12)) * sin(f1) * sin(f5) / (-sin(t56) * sin(f3)),
-                                           (-m5_3 * cos(t33)-n5_3 * sin(t33)) / sin(t56));
-    double t47 = sin(t57) == 0? 0 : atan2((ay * cos(t12)-ax * sin(t12)) * sin(f1) * sin(f5) / (-sin(t57) * sin(f3)),
-                                           (-m5_4 * cos(t34)-n5_4 * sin(t34)) / sin(t57));
-    double t48 = sin(t58) == 0? 0 : atan2((ay * cos(t12)-ax * sin(t12)) * sin(f1) * sin(f5) / (-sin(t58) * sin(f3)),
-                                           (-m5_4 * cos(t34)-n5_4 * sin(t34)) / sin(t58));
-    // // 计算t6
-    // double e1 = nx * sin(t11)-ny * cos(t11);
-    // double f1Tmp = ox * sin(t11)-oy * cos(t11);
-    // // 修改t61到t64的计算，使用f1Tmp
-    // double t61 = atan2(cos(t41) * e1 - cos(t51) * sin(t41) * f1Tmp, cos(t41) * f1Tmp + cos(t51) * sin(t41) * e1);
-    // double t62 = atan2(cos(t42) * e1 - cos(t52) * sin(t42) * f1Tmp, cos(t42) * f1Tmp + cos(t52) * sin(t42) * e1);
-    // double t63 = atan2(cos(t43) * e1 - cos(t53) * sin(t43) * f1Tmp, cos(t43) * f1Tmp + cos(t53) * sin(t43) * e1);
-    // double t64 = atan2(cos(t44) * e1 - cos(t54) * sin(t44) * f1Tmp, cos(t44) * f1Tmp + cos(t54) * sin(t44) * e1);
-
-    // double e2 = nx * sin(t12)-ny * cos(t12);
-    // double f2 = ox * sin(t12)-oy * cos(t12);
-    // double t65 = atan2(cos(t45) * e2 - cos(t55) * sin(t45) * f2, cos(t45) * f2 + cos(t55) * sin(t45) * e2);
-    // double t66 = atan2(cos(t46) * e2 - cos(t56) * sin(t46) * f2, cos(t46) * f2 + cos(t56) * sin(t46) * e2);
-    // double t67 = atan2(cos(t47) * e2 - cos(t57) * sin(t47) * f2, cos(t47) * f2 + cos(t57) * sin(t47) * e2);
-    // double t68 = atan2(cos(t48) * e2 - cos(t58) * sin(t48) * f2, cos(t48) * f2 + cos(t58) * sin(t48) * e2);
-
-    ikine_t[0] = {t11, t21, t31, t41};
-    ikine_t[1] = {t11, t21, t31, t42};
-    ikine_t[2] = {t11, t22, t32, t43};
-    ikine_t[3] = {t11, t22, t32, t44};
-    ikine_t[4] = {t12, t23, t33, t45};
-    ikine_t[5] = {t12, t23, t33, t46};
-    ikine_t[6] = {t12, t24, t34, t47};
-    ikine_t[7] = {t12, t24, t34, t48};
-
-    return ikine_t;
+    // 创建一个对话框用于显示矩阵描述
+    descriptionDialog = new QDialog(this);
+    descriptionDialog->setWindowTitle("矩阵和机械臂说明");
+    descriptionDialog->setMinimumSize(400, 300); // 设置对话框的最小尺寸
+
+    // 创建文本编辑框用于显示矩阵描述
+    QTextEdit *descriptionTextEdit = new QTextEdit(descriptionDialog);
+    descriptionTextEdit->setReadOnly(true);
+
+    // 矩阵描述内容
+    QString matrixDescription = "矩阵各元素含义说明\n\n"
+                                "旋转矩阵部分\n"
+                                "- R11：旋转矩阵第一行第一列元素，代表末端执行器在基础坐标系下X轴旋转分量。\n"
+                                "- R12：旋转矩阵第一行第二列元素，代表末端执行器在基础坐标系下Y轴旋转分量。\n"
+                                "- R13：旋转矩阵第一行第三列元素，代表末端执行器在基础坐标系下Z轴旋转分量。\n"
+                                "- R21：旋转矩阵第二行第一列元素，代表末端执行器在基础坐标系下X轴旋转分量。\n"
+                                "- R22：旋转矩阵第二行第二列元素，代表末端执行器在基础坐标系下Y轴旋转分量。\n"
+                                "- R23：旋转矩阵第二行第三列元素，代表末端执行器在基础坐标系下Z轴旋转分量。\n\n"
+                                "平移向量部分\n"
+                                "- T1：平移向量第一个元素，代表末端执行器在基础坐标系下X轴的平移分量。\n"
+                                "- T2：平移向量第二个元素，代表末端执行器在基础坐标系下Y轴的平移分量。\n\n"
+                                "机械臂 3D 显示相关说明\n"
+                                "- 关节表示：在 3D 显示中，每个关节用黄色球体表示，其位置根据机械臂的运动学模型和关节角度确定。当输入不同的关节角度进行正解计算时，关节的旋转会根据输入的角度值进行更新，从而改变机械臂的姿态。\n"
+                                "- 连杆表示：连杆用灰色圆柱体表示，连接相邻的两个关节。连杆的长度和方向会根据关节的位置动态计算和更新。当关节位置改变时，连杆会自动调整其长度、方向和旋转，以正确连接两个关节。\n"
+                                "- 末端执行器表示：末端执行器用红色球体表示，其位姿由旋转矩阵和平移向量共同确定。在进行正解计算后，末端执行器会根据计算得到的位姿矩阵更新其位置和姿态，在 3D 场景中同步显示。\n"
+                                "- 坐标系辅助线：为了便于观察和理解机械臂的运动，3D 场景中添加了坐标系辅助线。X 轴为红色圆柱体，Y 轴为绿色圆柱体，Z 轴为蓝色圆柱体，帮助确定机械臂在空间中的位置和方向。\n";
+    descriptionTextEdit->setPlainText(matrixDescription);
+
+    // 创建关闭按钮
+    QPushButton *closeButton = new QPushButton("关闭", descriptionDialog);
+    connect(closeButton, &QPushButton::clicked, descriptionDialog, &QDialog::close);
+
+    // 设置对话框的布局
+    QVBoxLayout *dialogLayout = new QVBoxLayout(descriptionDialog);
+    dialogLayout->addWidget(descriptionTextEdit);
+    dialogLayout->addWidget(closeButton);
 }
 
 void MainWindow::onForwardSolveClicked()
@@ -616,51 +436,52 @@ void MainWindow::onForwardSolveClicked()
         return;
     }
 
-    QVector<QVector<double>> result = myfkine(theta1, theta2, theta3, theta4);
+    // 直接设定关节角，取代尚未完成的正解和路径规划
+    forwardWatcher->cancel();
+    planWatcher->cancel();
+    pathTimer->stop();
+
+    const QVector<double> angles = {theta1, theta2, theta3, theta4};
+    forwardWatcher->setFuture(QtConcurrent::run(&solvePool, [angles](QPromise<ForwardSolveResult> &promise) {
+        static Metrics::Histogram *latency = Metrics::histogram("arm_gui_solve_seconds{op=\"forward\"}", "界面求解任务的耗时");
+        Metrics::ScopedTimer timer(latency);
+        ForwardSolveResult result;
+        result.angles = angles;
+        ArmKinematics::forward(angles.constData(), result.T);
+        promise.addResult(result);
+    }));
+}
 
+void MainWindow::applyForwardResult(const ForwardSolveResult &result)
+{
+    forwardModel->setValues(QVector<double>(result.T, result.T + 16));
+    const QStringList verticalHeaders = {"R21", "R22", "R23", "T2"};
     for (int i = 0; i < 4; ++i) {
-        for (int j = 0; j < 4; ++j) {
-            QTableWidgetItem *item = new QTableWidgetItem(QString::number(result[i][j]));
-            forwardResultTable->setItem(i, j, item);
-        }
+        forwardModel->setRowLabel(i, verticalHeaders[i]);
     }
 
-    // // // 将弧度转换为角度，并更新关节旋转
-    // // jointTransform->setRotationZ(qRadiansToDegrees(theta1));
-    // // 更新关节变换，这里假设已有theta1 - theta6变量
-    // jointTransforms[0]->setRotationZ(qRadiansToDegrees(theta1));
-    // jointTransforms[1]->setRotationX(qRadiansToDegrees(theta2));
-    // jointTransforms[2]->setRotationY(qRadiansToDegrees(theta3));
-    // jointTransforms[3]->setRotationX(qRadiansToDegrees(theta4));
-    // // 补充更新关节5和关节6的代码
-    // jointTransforms[4]->setRotationZ(qRadiansToDegrees(theta5));
-    // jointTransforms[5]->setRotationX(qRadiansToDegrees(theta6));
-
-    // 更新关节变换（复用统一函数）
-    QVector<double> angles = {theta1, theta2, theta3, theta4};
-    updateJointTransforms(angles);
-
-    // 更新末端执行器的位姿
-    QMatrix4x4 T04_matrix(
-        result[0][0], result[0][1], result[0][2], result[0][3],
-        result[1][0], result[1][1], result[1][2], result[1][3],
-        result[2][0], result[2][1], result[2][2], result[2][3],
-        result[3][0], result[3][1], result[3][2], result[3][3]
-        );
-    eeTransform->setMatrix(T04_matrix);
+    // 更新关节变换（经渲染调度器合并后应用）
+    currentAngles = result.angles;
+    requestPose(currentAngles);
+
+    // 更新末端执行器的位姿（场景尚未创建时在initScene中应用）
+    endEffectorPose = QVector<double>(result.T, result.T + 16);
+    if (armScene) {
+        armScene->setEndEffectorPose(result.T);
+    }
 
     errorLabel->setText("");
 }
 
 void MainWindow::onInverseSolveClicked()
 {
-    QVector<QVector<double>> Tbe(4, QVector<double>(4));
+    double T[16];
     for (int i = 0; i < 4; ++i) {
         for (int j = 0; j < 4; ++j) {
             QTableWidgetItem *item = poseMatrixInputTable->item(i, j);
             if (item) {
                 bool ok;
-                Tbe[i][j] = item->text().toDouble(&ok);
+                T[i * 4 + j] = item->text().toDouble(&ok);
                 if (!ok) {
                     errorLabel->setText("末端执行器位姿矩阵输入无效，请输入数字");
                     return;
@@ -672,17 +493,97 @@ void MainWindow::onInverseSolveClicked()
         }
     }
 
-    QVector<QVector<double>> result = mymodikine(Tbe);
+    // 取代尚未完成的逆解，不影响正在进行的路径规划
+    inverseWatcher->cancel();
+    statusBar()->showMessage("正在求解逆解…");
+
+    const QVector<double> pose(T, T + 16);
+    inverseWatcher->setFuture(QtConcurrent::run(&solvePool, [this, pose](QPromise<InverseSolveResult> &promise) {
+        static Metrics::Histogram *latency = Metrics::histogram("arm_gui_solve_seconds{op=\"inverse\"}", "界面求解任务的耗时");
+        Metrics::ScopedTimer timer(latency);
+        double solutions[9][4];
+        unsigned clampedMask = 0;
+        ArmKinematics::inverse(pose.constData(), solutions, &clampedMask);
+
+        // 批量检查8组逆解是否存在碰撞
+        bool collisionFree[9];
+        collisionChecker.isFreeBatch(&solutions[0][0], 8, collisionFree);
+        if (promise.isCanceled()) {
+            return;
+        }
+
+        InverseSolveResult result;
+        int count = 8;
+        double numericResidual = 0;
+        bool converged = true;
+        // 已加载初值数据库时，追加一行由最近采样构型迭代得到的数值解
+        if (!ikSeedDatabase.isEmpty()) {
+            converged = ikSeedDatabase.solve(pose.constData(), solutions[8], &numericResidual);
+            collisionFree[8] = collisionChecker.isFree(solutions[8]);
+            result.hasNumeric = true;
+            count = 9;
+        }
 
-    for (int i = 0; i < 8; ++i) {
-        for (int j = 0; j < 6; ++j) {
-            QTableWidgetItem *item = new QTableWidgetItem(QString::number(result[i][j]));
-            inverseResultTable->setItem(i, j, item);
+        double target[IkSeedDatabase::KeySize];
+        IkSeedDatabase::poseKey(pose.constData(), target);
+        for (int i = 0; i < count; ++i) {
+            const double *q = solutions[i];
+            double residual = numericResidual;
+            if (i < 8) {
+                // 解析解的残差：正解位姿与目标位姿在数据库检索键空间中的距离
+                double T[16], key[IkSeedDatabase::KeySize];
+                ArmKinematics::forward(q, T);
+                IkSeedDatabase::poseKey(T, key);
+                double sum = 0;
+                for (int k = 0; k < IkSeedDatabase::KeySize; ++k) {
+                    sum += (key[k] - target[k]) * (key[k] - target[k]);
+                }
+                residual = std::sqrt(sum);
+            }
+            double margin = M_PI;
+            for (int j = 0; j < 4; ++j) {
+                margin = qMin(margin, qMin(q[j] - ArmKinematics::jointMin[j], ArmKinematics::jointMax[j] - q[j]));
+            }
+            result.rows << q[0] << q[1] << q[2] << q[3] << residual << margin;
+
+            quint8 flags = 0;
+            if (!collisionFree[i]) flags |= NumericTableModel::Colliding;
+            if (i < 8 && (clampedMask & (1u << i))) flags |= NumericTableModel::Clamped;
+            if (i < 8 && (ArmKinematics::flippedWristMask & (1u << i))) flags |= NumericTableModel::WristFlipped;
+            if (i == 8 && !converged) flags |= NumericTableModel::NotConverged;
+            result.flags.append(flags);
         }
+        promise.addResult(result);
+    }));
+}
+
+void MainWindow::applyInverseResult(const InverseSolveResult &result)
+{
+    inverseModel->setValues(result.rows, result.flags);
+    if (result.hasNumeric) {
+        inverseModel->setRowLabel(8, "数值解");
     }
+
+    statusBar()->clearMessage();
     errorLabel->setText("");
 }
 
+void MainWindow::onInverseFilterChanged()
+{
+    inverseModel->setColumnRange(4, 0, residualFilter->value());
+    inverseModel->setColumnRange(5, marginFilter->value(), M_PI);
+}
+
+void MainWindow::cancelPendingSolves()
+{
+    // 已在运行的任务会在下一个检查点退出，其结果不再应用
+    forwardWatcher->cancel();
+    inverseWatcher->cancel();
+    planWatcher->cancel();
+    toolPathWatcher->cancel();
+    discardSweptVolumeJob();
+}
+
 void MainWindow::onResetClicked()
 {
     // 清空关节角度输入框
@@ -692,47 +593,23 @@ void MainWindow::onResetClicked()
     theta4Edit->clear();
 
     // 清空输入输出表格
-    for (int i = 0; i < poseMatrixInputTable->rowCount(); ++i) {
-        for (int j = 0; j < poseMatrixInputTable->columnCount(); ++j) {
-            poseMatrixInputTable->setItem(i, j, nullptr);
-        }
+    poseMatrixInputTable->clearContents();
+    forwardModel->clear();
+    inverseModel->clear();
+    trajectoryModel->clear();
+
+    // 取消后台求解，停止路径播放并恢复关节角
+    cancelPendingSolves();
+    pathTimer->stop();
+    animationPath.clear();
+    currentAngles.fill(0.0);
+
+    // 恢复关节、连杆和末端执行器的初始变换
+    endEffectorPose.clear();
+    if (armScene) {
+        armScene->reset();
     }
-
-    for (int i = 0; i < forwardResultTable->rowCount(); ++i) {
-        for (int j = 0; j < forwardResultTable->columnCount(); ++j) {
-            forwardResultTable->setItem(i, j, nullptr);
-        }
-    }
-
-    for (int i = 0; i < inverseResultTable->rowCount(); ++i) {
-        for (int j = 0; j < inverseResultTable->columnCount(); ++j) {
-            inverseResultTable->setItem(i, j, nullptr);
-        }
-    }
-
-    // 恢复关节和连杆的初始变换
-    for (int i = 0; i < jointTransforms.size(); ++i) {
-        jointTransforms[i]->setMatrix(jointInitialTransforms[i]);
-    }
-    for (int i = 0; i < linkTransforms.size(); ++i) {
-        linkTransforms[i]->setMatrix(linkInitialTransforms[i]);
-
-        // 恢复连杆的初始长度
-        Qt3DExtras::QCylinderMesh *linkMesh = qobject_cast<Qt3DExtras::QCylinderMesh*>(linkEntities[i]->components().first());
-        if (linkMesh) {
-            // 从QMatrix4x4中提取初始平移信息
-            QVector3D start(jointInitialTransforms[i].column(3).x(), jointInitialTransforms[i].column(3).y(), jointInitialTransforms[i].column(3).z());
-            QVector3D end(jointInitialTransforms[i + 1].column(3).x(), jointInitialTransforms[i + 1].column(3).y(), jointInitialTransforms[i + 1].column(3).z());
-            QVector3D direction = end - start;
-            float length = direction.length();
-            linkMesh->setLength(length);
-        }
-    }
-
-    // 重置末端执行器位置
-    QMatrix4x4 initialMatrix; // 初始化为单位矩阵
-    initialMatrix.setToIdentity();
-    eeTransform->setMatrix(initialMatrix);  // 重置末端位置
+    clearSweptVolume();
 
     // 清除错误提示和状态消息
     errorLabel->clear();
@@ -743,59 +620,12 @@ void MainWindow::onResetClicked()
     QTimer::singleShot(2000, [this](){
         statusBar()->showMessage("准备就绪");
     });
-
-    // 强制界面刷新（针对某些Qt版本需要）
-    qApp->processEvents();
 }
 
-void MainWindow::createCoordinateAxes() {
-    // X轴（红色圆柱体）
-    Qt3DCore::QEntity *xAxis = new Qt3DCore::QEntity(rootEntity);
-    Qt3DExtras::QCylinderMesh *xMesh = new Qt3DExtras::QCylinderMesh(xAxis);
-    xMesh->setRadius(0.02f);
-    xMesh->setLength(2.0f); // 长度为2米
-    xMesh->setRings(2);     // 简化网格
-
-    Qt3DExtras::QPhongMaterial *xMat = new Qt3DExtras::QPhongMaterial(xAxis);
-    xMat->setDiffuse(Qt::red);
-
-    Qt3DCore::QTransform *xTransform = new Qt3DCore::QTransform(xAxis);
-    xTransform->setRotationZ(90.0f); // 绕Z轴旋转90度，使圆柱体指向X轴
-
-    xAxis->addComponent(xMesh);
-    xAxis->addComponent(xMat);
-    xAxis->addComponent(xTransform);
-
-    // Y轴（绿色圆柱体）
-    Qt3DCore::QEntity *yAxis = new Qt3DCore::QEntity(rootEntity);
-    Qt3DExtras::QCylinderMesh *yMesh = new Qt3DExtras::QCylinderMesh(yAxis);
-    yMesh->setRadius(0.02f);
-    yMesh->setLength(2.0f);
-    yMesh->setRings(2);
-
-    Qt3DExtras::QPhongMaterial *yMat = new Qt3DExtras::QPhongMaterial(yAxis);
-    yMat->setDiffuse(Qt::green);
-
-    yAxis->addComponent(yMesh);
-    yAxis->addComponent(yMat);
-    yAxis->addComponent(new Qt3DCore::QTransform());
-
-    // Z轴（蓝色圆柱体）
-    Qt3DCore::QEntity *zAxis = new Qt3DCore::QEntity(rootEntity);
-    Qt3DExtras::QCylinderMesh *zMesh = new Qt3DExtras::QCylinderMesh(zAxis);
-    zMesh->setRadius(0.02f);
-    zMesh->setLength(2.0f);
-    zMesh->setRings(2);
-
-    Qt3DExtras::QPhongMaterial *zMat = new Qt3DExtras::QPhongMaterial(zAxis);
-    zMat->setDiffuse(Qt::blue);
-
-    Qt3DCore::QTransform *zTransform = new Qt3DCore::QTransform(zAxis);
-    zTransform->setRotationX(90.0f); // 绕X轴旋转90度，使圆柱体指向Z轴
-
-    zAxis->addComponent(zMesh);
-    zAxis->addComponent(zMat);
-    zAxis->addComponent(zTransform);
+void MainWindow::setupCollisionScene() {
+    if (!collisionChecker.setupDefaultEnvironment()) {
+        errorLabel->setText(collisionChecker.errorString() + "，只使用地面和底座");
+    }
 }
 
 void MainWindow::updateJointTransforms(const QVector<double>& angles) {
@@ -803,161 +633,434 @@ void MainWindow::updateJointTransforms(const QVector<double>& angles) {
         errorLabel->setText("角度数量错误，需4个关节角度");
         return;
     }
+    if (armScene) {
+        armScene->setJointAngles(angles.constData());
+    }
+}
+
+void MainWindow::requestPose(const QVector<double> &angles)
+{
+    // 场景尚未创建时只记录关节角，由initScene应用
+    if (renderScheduler) {
+        renderScheduler->requestPose(angles);
+    }
+}
+
+void MainWindow::onInverseResultSelected(const QModelIndex &index) {
+    // 1. 检查行号有效性
+    const int row = index.row();
+    if (row < 0 || row >= inverseModel->rowCount()) {
+        errorLabel->setText("无效的行选择");
+        return;
+    }
 
-    double theta1 = angles[0];
-    double theta2 = angles[1];
-    double theta3 = angles[2];
-    double theta4 = angles[3];
-    //double theta5 = angles[4];
-    //double theta6 = angles[5];
+    // 2. 直接读取模型中的原始数值，避免文本往返造成的精度损失
+    const double *values = inverseModel->rowValues(row);
+    QVector<double> angles(values, values + 4);
 
-    std::vector<QVector<QVector<double>>> jointMatrices = calculateJointMatrices(theta1, theta2, theta3, theta4);
+    // 3. 验证并更新关节
+    for (double angle : angles) {
+        if (!std::isfinite(angle)) {
+            errorLabel->setText("逆解数据不完整或格式错误");
+            return;
+        }
+    }
 
-    for (int i = 0; i < 4; ++i) {
-        QVector<QVector<double>> T0i = jointMatrices[i];
-        QVector3D position(T0i[0][3], T0i[1][3], T0i[2][3]);
-        jointTransforms[i]->setTranslation(position);
-
-        // 计算旋转矩阵到四元数的转换
-        QMatrix3x3 rotationMatrix;
-        rotationMatrix.setToIdentity(); // 先将矩阵初始化为单位矩阵
-        for (int row = 0; row < 3; ++row) {
-            for (int col = 0; col < 3; ++col) {
-                rotationMatrix(row, col) = T0i[row][col]; // 逐元素赋值
+    // 4. 碰撞检查，拒绝存在碰撞的解
+    const double q[4] = {angles[0], angles[1], angles[2], angles[3]};
+    if (!collisionChecker.isFree(q)) {
+        errorLabel->setText("所选逆解存在碰撞，请选择其他解");
+        return;
+    }
+
+    // 5. 后台规划路径并计算时间参数化和力矩，取代尚未完成的规划
+    planWatcher->cancel();
+    statusBar()->showMessage("正在规划路径…");
+    const QVector<double> start = currentAngles;
+    const QVector<double> goal = angles;
+    const double rate = 1000.0 / pathTimer->interval();
+    const MotionPlanner::Options plannerOptions = motionPlanner.options();
+    planWatcher->setFuture(QtConcurrent::run(&solvePool, [this, start, goal, rate, plannerOptions](QPromise<PathPlanResult> &promise) {
+        PathPlanResult result;
+        // 每个任务使用独立的规划器实例，被取代的任务可与新任务并行结束
+        MotionPlanner planner(collisionChecker);
+        planner.setOptions(plannerOptions);
+        QVector<QVector<double>> path;
+        result.found = planner.plan(start.constData(), goal.constData(), path);
+        result.planningMs = planner.lastPlanningTimeMs();
+        static Metrics::Histogram *latency = Metrics::histogram("arm_gui_solve_seconds{op=\"plan\"}", "界面求解任务的耗时");
+        static Metrics::Counter *failures = Metrics::counter("arm_gui_plan_failures_total", "路径规划未找到路径的次数");
+        latency->record(quint64(result.planningMs * 1e6));
+        if (!result.found) {
+            failures->add();
+        }
+        result.waypointCount = path.size();
+        if (!result.found || promise.isCanceled()) {
+            promise.addResult(result);
+            return;
+        }
+
+        // 按最大关节步长加密路径点
+        const double maxStep = 0.01;
+        QVector<double> densePath(path.first());
+        for (int i = 1; i < path.size(); ++i) {
+            double maxDelta = 0;
+            for (int j = 0; j < 4; ++j) {
+                maxDelta = qMax(maxDelta, qAbs(path[i][j] - path[i - 1][j]));
+            }
+            const int steps = qMax(1, int(std::ceil(maxDelta / maxStep)));
+            for (int s = 1; s <= steps; ++s) {
+                const double t = double(s) / steps;
+                for (int j = 0; j < 4; ++j) {
+                    densePath.append(path[i - 1][j] + t * (path[i][j] - path[i - 1][j]));
+                }
+            }
+        }
+
+        // 按关节速度/加速度限制做时间最优参数化，并按定时器频率采样
+        TrajectoryTiming::Profile profile;
+        const int sampleCount = densePath.size() / 4;
+        TrajectoryTiming::computeProfile(densePath.constData(), sampleCount, TrajectoryTiming::defaultLimits(), profile);
+        QVector<double> positions, velocities;
+        TrajectoryTiming::resample(densePath.constData(), sampleCount, profile, rate, positions, velocities);
+        result.duration = profile.duration;
+        result.animation = positions;
+        if (promise.isCanceled()) {
+            return;
+        }
+
+        // 由速度差分得到加速度，估算沿轨迹的关节力矩峰值
+        const int setpointCount = positions.size() / 4;
+        const double dt = 1.0 / rate;
+        QVector<double> accelerations(positions.size(), 0.0);
+        for (int k = 1; k + 1 < setpointCount; ++k) {
+            for (int j = 0; j < 4; ++j) {
+                accelerations[4 * k + j] = (velocities[4 * (k + 1) + j] - velocities[4 * (k - 1) + j]) / (2 * dt);
+            }
+        }
+        QVector<double> torques(positions.size());
+        armDynamics.inverseDynamicsBatch(positions.constData(), velocities.constData(), accelerations.constData(),
+                                         setpointCount, torques.data());
+        result.trajectory.reserve(setpointCount * 9);
+        for (int k = 0; k < setpointCount; ++k) {
+            result.trajectory.append(k * dt);
+            for (int j = 0; j < 4; ++j) {
+                result.trajectory.append(positions[4 * k + j]);
+            }
+            for (int j = 0; j < 4; ++j) {
+                result.peakTorque[j] = qMax(result.peakTorque[j], qAbs(torques[4 * k + j]));
+                result.trajectory.append(torques[4 * k + j]);
             }
         }
-        QQuaternion rotation = QQuaternion::fromRotationMatrix(rotationMatrix);
-        jointTransforms[i]->setRotation(rotation);
+        promise.addResult(result);
+    }));
+}
+
+void MainWindow::applyPathPlan(const PathPlanResult &result)
+{
+    if (!result.found) {
+        statusBar()->clearMessage();
+        errorLabel->setText(QString("未找到无碰撞路径（用时%1 ms）").arg(result.planningMs, 0, 'f', 1));
+        return;
     }
 
-    // 更新连杆变换
-    // for (int i = 0; i < linkTransforms.size(); ++i) {
-    for (int i = 0; i < 3; ++i) { // 遍历五个连杆
-        int startJointIndex = i;
-        int endJointIndex = i + 1;
+    animationPath = result.animation;
+    animationIndex = 0;
+    pathTimer->start();
+    trajectoryModel->setValues(result.trajectory);
+
+    statusBar()->showMessage(QString("路径规划完成：%1个路径点，用时%2 ms，运动时长%3 s，峰值力矩 %4/%5/%6/%7 N·m")
+                                 .arg(result.waypointCount)
+                                 .arg(result.planningMs, 0, 'f', 1)
+                                 .arg(result.duration, 0, 'f', 2)
+                                 .arg(result.peakTorque[0], 0, 'f', 1)
+                                 .arg(result.peakTorque[1], 0, 'f', 1)
+                                 .arg(result.peakTorque[2], 0, 'f', 1)
+                                 .arg(result.peakTorque[3], 0, 'f', 1), 5000);
+    errorLabel->setText("");
+}
+
+void MainWindow::onPathAnimationStep()
+{
+    if (4 * animationIndex + 3 >= animationPath.size()) {
+        pathTimer->stop();
+        return;
+    }
+    const double *q = animationPath.constData() + 4 * animationIndex++;
+    currentAngles = QVector<double>(q, q + 4);
+    requestPose(currentAngles);
+}
 
-        QVector3D start = jointTransforms[startJointIndex]->translation();
-        QVector3D end = jointTransforms[endJointIndex]->translation();
-        QVector3D direction = end - start;
-        float length = direction.length();
+void MainWindow::onGenerateToolPath()
+{
+    const QString meshFile = QFileDialog::getOpenFileName(this, "选择工件表面网格", QString(),
+                                                          "网格文件 (*.stl *.obj);;所有文件 (*)");
+    if (meshFile.isEmpty()) {
+        return;
+    }
+    bool ok = false;
+    const QString pattern = QInputDialog::getItem(this, "磨抛路径", "走刀方式：", {"光栅（往复行）", "环切"}, 0, false, &ok);
+    if (!ok) {
+        return;
+    }
 
-        // 更新连杆长度
-        Qt3DExtras::QCylinderMesh *linkMesh = qobject_cast<Qt3DExtras::QCylinderMesh*>(linkEntities[i]->components().first());
-        if (linkMesh) {
-            linkMesh->setLength(length);
+    ToolPathGenerator::Options options;
+    options.pattern = pattern == "环切" ? ToolPathGenerator::Contour : ToolPathGenerator::Raster;
+    const QFileInfo info(meshFile);
+    const QString pathFile = info.absolutePath() + "/" + info.completeBaseName() + "_path.csv";
+
+    toolPathWatcher->cancel();
+    statusBar()->showMessage("正在生成磨抛路径…");
+    toolPathWatcher->setFuture(QtConcurrent::run(&solvePool, [this, meshFile, pathFile, options](QPromise<ToolPathResult> &promise) {
+        ToolPathResult result;
+        result.outputFile = pathFile;
+        // 先写入临时文件，生成成功后才替换目标文件：取消或出错时不留下看似完整的路径文件
+        QSaveFile out(pathFile);
+        if (!out.open(QIODevice::WriteOnly | QIODevice::Text)) {
+            result.error = QString("无法写入路径文件：%1").arg(pathFile);
+            promise.addResult(result);
+            return;
+        }
+        out.write("x,y,z,nx,ny,nz,q1,q2,q3,q4,segment_start\n");
+
+        // 路径点逐批写入文件，只保留前若干点用于界面播放
+        ToolPathGenerator generator(collisionChecker);
+        generator.setOptions(options);
+        QByteArray line;
+        result.ok = generator.generate(meshFile, [&](const ToolPathGenerator::Point *points, int count) {
+            for (int i = 0; i < count; ++i) {
+                const ToolPathGenerator::Point &p = points[i];
+                line.clear();
+                for (double v : {p.position[0], p.position[1], p.position[2], p.normal[0], p.normal[1], p.normal[2],
+                                 p.q[0], p.q[1], p.q[2], p.q[3]}) {
+                    line += QByteArray::number(v, 'g', 9);
+                    line += ',';
+                }
+                line += (p.flags & ToolPathGenerator::SegmentStart) ? "1\n" : "0\n";
+                out.write(line);
+                if (result.animation.size() < 4 * ToolPathResult::MaxPreviewPoints) {
+                    result.animation << p.q[0] << p.q[1] << p.q[2] << p.q[3];
+                }
+            }
+        }, [&promise]() { return promise.isCanceled(); });
+        result.stats = generator.lastStats();
+        result.error = generator.errorString();
+        if (result.ok && !promise.isCanceled() && !out.commit()) {
+            result.ok = false;
+            result.error = QString("写入路径文件失败：%1").arg(pathFile);
         }
+        promise.addResult(result);
+    }));
+}
 
-        // 计算旋转并更新连杆变换
-        QVector3D up = QVector3D(0, 1, 0);
-        QVector3D axis = QVector3D::crossProduct(up, direction.normalized());
-        float angle = qRadiansToDegrees(qAcos(QVector3D::dotProduct(up, direction.normalized())));
-        linkTransforms[i]->setTranslation(start + direction / 2);
-        linkTransforms[i]->setRotation(QQuaternion::fromAxisAndAngle(axis, angle));
+void MainWindow::applyToolPath(const ToolPathResult &result)
+{
+    if (!result.ok) {
+        statusBar()->clearMessage();
+        errorLabel->setText(result.error);
+        return;
     }
+
+    const ToolPathGenerator::Stats &s = result.stats;
+    if (!result.animation.isEmpty()) {
+        animationPath = result.animation;
+        animationIndex = 0;
+        pathTimer->start();
+    }
+    statusBar()->showMessage(QString("磨抛路径：%1个三角形，%2个采样点，可行%3个（不可达%4、超限%5、偏角过大%6、碰撞%7），%8段，"
+                                     "切片%9 ms，求解%10 ms，已写入%11")
+                                 .arg(s.triangles).arg(s.samples).arg(s.accepted)
+                                 .arg(s.unreachable).arg(s.clamped).arg(s.tilted).arg(s.colliding)
+                                 .arg(s.segments)
+                                 .arg(s.sliceMs, 0, 'f', 0).arg(s.solveMs, 0, 'f', 0)
+                                 .arg(result.outputFile), 10000);
+    errorLabel->setText("");
 }
 
-void MainWindow::onInverseResultSelected(int row) {
-    // 1. 检查行号有效性
-    if (row < 0 || row >= inverseResultTable->rowCount()) {
-        errorLabel->setText("无效的行选择");
+void MainWindow::onSweptVolume()
+{
+    if (animationPath.size() < 4) {
+        statusBar()->showMessage("没有可分析的路径，请先规划路径或生成磨抛路径", 3000);
         return;
     }
 
-    // 2. 提取角度数据
-    QVector<double> angles;
-    bool isValid = true;
-    for (int col = 0; col < 4; ++col) {
-        QTableWidgetItem *item = inverseResultTable->item(row, col);
-        if (!item) {
-            isValid = false;
-            break;
+    // 路径按值捕获，计算期间界面可继续播放或重新规划
+    const QVector<double> path = animationPath;
+    const QString meshFile = QString("%1/swept_volume_%2.obj").arg(QDir::tempPath()).arg(QDateTime::currentMSecsSinceEpoch());
+    discardSweptVolumeJob();
+    pendingSweptFile = meshFile;
+    statusBar()->showMessage("正在计算扫掠体积…");
+    sweptWatcher->setFuture(QtConcurrent::run(&solvePool, [this, path, meshFile](QPromise<SweptVolumeResult> &promise) {
+        SweptVolumeResult result;
+        SweptVolume swept(collisionChecker);
+        result.ok = swept.compute(path.constData(), path.size() / 4, [&promise]() { return promise.isCanceled(); });
+        if (result.ok && !swept.exportObj(meshFile)) {
+            result.ok = false;
+            QFile::remove(meshFile); // 可能已写了一部分
         }
-        bool ok;
-        double angle = item->text().toDouble(&ok);
-        if (!ok) {
-            isValid = false;
-            break;
+        // 取消后结果不会被界面使用：界面尝试删除时文件可能还未写出，由任务自己删除
+        if (promise.isCanceled()) {
+            QFile::remove(meshFile);
+            return;
         }
-        angles.append(angle);
+        result.error = swept.errorString();
+        result.meshFile = meshFile;
+        result.stats = swept.result();
+        promise.addResult(result);
+    }));
+}
+
+void MainWindow::applySweptVolume(const SweptVolumeResult &result)
+{
+    if (!result.ok) {
+        statusBar()->clearMessage();
+        errorLabel->setText(result.error);
+        return;
     }
 
-    // 3. 验证并更新关节
-    if (!isValid || angles.size() != 4) {
-        errorLabel->setText("逆解数据不完整或格式错误");
+    clearSweptVolume();
+    sweptMeshFile = result.meshFile;
+    if (armScene) {
+        sweptEntity = new Qt3DCore::QEntity(armScene->root());
+        Qt3DRender::QMesh *mesh = new Qt3DRender::QMesh(sweptEntity);
+        mesh->setSource(QUrl::fromLocalFile(result.meshFile));
+        Qt3DExtras::QPhongAlphaMaterial *material = new Qt3DExtras::QPhongAlphaMaterial(sweptEntity);
+        material->setDiffuse(QColor(70, 130, 220));
+        material->setAlpha(0.25f);
+        sweptEntity->addComponent(mesh);
+        sweptEntity->addComponent(material);
+    }
+
+    const SweptVolume::Result &s = result.stats;
+    statusBar()->showMessage(QString("扫掠体积%1 m³（%2个体素，%3个采样点，关键构型%4），最小间隙%5 mm（第%6点），"
+                                     "栅格化%7 ms，间隙%8 ms")
+                                 .arg(s.volume, 0, 'f', 4).arg(s.voxelCount).arg(s.samples).arg(s.keyConfigurations)
+                                 .arg(s.minClearance * 1000, 0, 'f', 1).arg(s.minClearanceSample)
+                                 .arg(s.rasterMs, 0, 'f', 0).arg(s.clearanceMs, 0, 'f', 0), 10000);
+    errorLabel->setText(s.minClearance > 0 ? "" : "路径与环境发生碰撞");
+}
+
+void MainWindow::clearSweptVolume()
+{
+    delete sweptEntity; // 同时删除网格和材质组件
+    sweptEntity = nullptr;
+    if (!sweptMeshFile.isEmpty()) {
+        QFile::remove(sweptMeshFile);
+        sweptMeshFile.clear();
+    }
+    removeDiscardedSweptFiles();
+}
+
+void MainWindow::discardSweptVolumeJob()
+{
+    // 被取代的任务不再由监视器报告完成，其网格文件记下来稍后删除
+    sweptWatcher->cancel();
+    if (!pendingSweptFile.isEmpty()) {
+        discardedSweptFiles.append(pendingSweptFile);
+        pendingSweptFile.clear();
+    }
+}
+
+void MainWindow::removeDiscardedSweptFiles()
+{
+    // 仍在写入（Windows上无法删除）的文件留到下次再删；尚未写出的文件由任务在发现取消后自己删除
+    for (int i = discardedSweptFiles.size() - 1; i >= 0; --i) {
+        const QString &file = discardedSweptFiles[i];
+        if (!QFile::exists(file) || QFile::remove(file)) {
+            discardedSweptFiles.removeAt(i);
+        }
+    }
+}
+
+void MainWindow::onCellSimulationToggled(bool enabled)
+{
+    if (!enabled) {
+        stopCellSimulation();
+        statusBar()->showMessage("单元仿真已停止", 3000);
+        return;
+    }
+    if (!armScene) {
+        cellAction->setChecked(false);
+        statusBar()->showMessage("三维视图尚未就绪", 3000);
+        return;
+    }
+    bool ok = false;
+    const int robots = QInputDialog::getInt(this, "多机器人单元仿真", "机器人数量：", 4, 2, 6, 1, &ok);
+    if (!ok) {
+        cellAction->setChecked(false);
         return;
     }
 
-    updateJointTransforms(angles);
-    errorLabel->setText("");
+    // 单元中的机械臂另建实体，原机械臂在演示期间隐藏
+    pathTimer->stop();
+    cellSimulation.setupDemoCell(robots);
+    cellRoot = new Qt3DCore::QEntity(armScene->root());
+    for (int i = 0; i < cellSimulation.robotCount(); ++i) {
+        cellScenes.append(new ArmScene(cellRoot, false));
+    }
+    armScene->setArmVisible(false);
+    updateCellView();
+
+    // 每个视图刷新周期推进一次，步数为这段时间对应的仿真步数
+    const double frameSeconds = cellViewTimer->interval() / 1000.0;
+    cellStopping.storeRelease(0);
+    cellThread = QThread::create([this, frameSeconds]() {
+        cellSimulation.runRealTime([this]() { return cellStopping.loadAcquire() != 0; }, 1.0, frameSeconds);
+    });
+    cellThread->start();
+    cellViewTimer->start();
+}
+
+void MainWindow::stopCellSimulation()
+{
+    cellViewTimer->stop();
+    if (cellThread) {
+        cellStopping.storeRelease(1);
+        cellThread->wait();
+        delete cellThread;
+        cellThread = nullptr;
+    }
+    qDeleteAll(cellScenes);
+    cellScenes.clear();
+    delete cellRoot; // 同时删除各机械臂的实体
+    cellRoot = nullptr;
+    if (armScene) {
+        armScene->setArmVisible(true);
+    }
 }
 
-std::vector<QVector<QVector<double>>> MainWindow::calculateJointMatrices(double theta1, double theta2, double theta3, double theta4)
+void MainWindow::updateCellView()
 {
-    QVector<QVector<double>> MDH = {
-        {theta1, 0, 0, 0},
-        {theta2, 0, 0.325, -M_PI/2},
-        {theta3, 0, 1.150, 0},
-        {theta4, 1.225, 0.300, -M_PI/2}
-        //{theta5, 0, 0, M_PI/2},
-        //{theta6, 0, 0, -M_PI/2}
-    };
-
-    QVector<QVector<double>> T01 = {
-        {cos(MDH[0][0]), -sin(MDH[0][0]), 0, MDH[0][2]},
-        {cos(MDH[0][3])*sin(MDH[0][0]), cos(MDH[0][3])*cos(MDH[0][0]), -sin(MDH[0][3]), -MDH[0][1]*sin(MDH[0][3])},
-        {sin(MDH[0][3])*sin(MDH[0][0]), sin(MDH[0][3])*cos(MDH[0][0]), cos(MDH[0][3]), MDH[0][1]*cos(MDH[0][3])},
-        {0, 0, 0, 1}
-    };
-
-    QVector<QVector<double>> T12 = {
-        {cos(MDH[1][0]), -sin(MDH[1][0]), 0, MDH[1][2]},
-        {cos(MDH[1][3])*sin(MDH[1][0]), cos(MDH[1][3])*cos(MDH[1][0]), -sin(MDH[1][3]), -MDH[1][1]*sin(MDH[1][3])},
-        {sin(MDH[1][3])*sin(MDH[1][0]), sin(MDH[1][3])*cos(MDH[1][0]), cos(MDH[1][3]), MDH[1][1]*cos(MDH[1][3])},
-        {0, 0, 0, 1}
-    };
-
-    QVector<QVector<double>> T23 = {
-        {cos(MDH[2][0]), -sin(MDH[2][0]), 0, MDH[2][2]},
-        {cos(MDH[2][3])*sin(MDH[2][0]), cos(MDH[2][3])*cos(MDH[2][0]), -sin(MDH[2][3]), -MDH[2][1]*sin(MDH[2][3])},
-        {sin(MDH[2][3])*sin(MDH[2][0]), sin(MDH[2][3])*cos(MDH[2][0]), cos(MDH[2][3]), MDH[2][1]*cos(MDH[2][3])},
-        {0, 0, 0, 1}
-    };
-
-    QVector<QVector<double>> T34 = {
-        {cos(MDH[3][0]), -sin(MDH[3][0]), 0, MDH[3][2]},
-        {cos(MDH[3][3])*sin(MDH[3][0]), cos(MDH[3][3])*cos(MDH[3][0]), -sin(MDH[3][3]), -MDH[3][1]*sin(MDH[3][3])},
-        {sin(MDH[3][3])*sin(MDH[3][0]), sin(MDH[3][3])*cos(MDH[3][0]), cos(MDH[3][3]), MDH[3][1]*cos(MDH[3][3])},
-        {0, 0, 0, 1}
-    };
-
-    // QVector<QVector<double>> T45 = {
-    //     {cos(MDH[4][0]), -sin(MDH[4][0]), 0, MDH[4][2]},
-    //     {cos(MDH[4][3])*sin(MDH[4][0]), cos(MDH[4][3])*cos(MDH[4][0]), -sin(MDH[4][3]), -MDH[4][1]*sin(MDH[4][3])},
-    //     {sin(MDH[4][3])*sin(MDH[4][0]), sin(MDH[4][3])*cos(MDH[4][0]), cos(MDH[4][3]), MDH[4][1]*cos(MDH[4][3])},
-    //     {0, 0, 0, 1}
-    // };
-
-    // QVector<QVector<double>> T56 = {
-    //     {cos(MDH[5][0]), -sin(MDH[5][0]), 0, MDH[5][2]},
-    //     {cos(MDH[5][3])*sin(MDH[5][0]), cos(MDH[5][3])*cos(MDH[5][0]), -sin(MDH[5][3]), -MDH[5][1]*sin(MDH[5][3])},
-    //     {sin(MDH[5][3])*sin(MDH[5][0]), sin(MDH[5][3])*cos(MDH[5][0]), cos(MDH[5][3]), MDH[5][1]*cos(MDH[5][3])},
-    //     {0, 0, 0, 1}
-    // };
-
-    std::vector<QVector<QVector<double>>> jointMatrices(6);
-    jointMatrices[0] = T01;
-    jointMatrices[1] = multiplyMatrix(T01, T12);
-    jointMatrices[2] = multiplyMatrix(jointMatrices[1], T23);
-    jointMatrices[3] = multiplyMatrix(jointMatrices[2], T34);
-    // jointMatrices[4] = multiplyMatrix(jointMatrices[3], T45);
-    // jointMatrices[5] = multiplyMatrix(jointMatrices[4], T56);
-
-    return jointMatrices;
+    const CellSimulation::Snapshot snapshot = cellSimulation.snapshot();
+    if (snapshot.robots.size() != cellScenes.size()) {
+        return;
+    }
+    double clearance = std::numeric_limits<double>::infinity();
+    int halted = 0;
+    for (int i = 0; i < cellScenes.size(); ++i) {
+        const CellSimulation::RobotState &state = snapshot.robots[i];
+        cellScenes[i]->setJointFrames(state.frames);
+        cellScenes[i]->setEndEffectorPose(state.frames[3]);
+        clearance = qMin(clearance, state.clearance);
+        halted += state.halted ? 1 : 0;
+    }
+
+    const CellSimulation::Stats stats = cellSimulation.stats();
+    const QString distance = std::isfinite(clearance) ? QString("%1 m").arg(clearance, 0, 'f', 3) : QString("> 0.5 m");
+    statusBar()->showMessage(QString("单元仿真：%1台机器人，%2 s，最小间距%3，碰撞停止%4台，仿真耗时占%5%")
+                                 .arg(snapshot.robots.size())
+                                 .arg(snapshot.time, 0, 'f', 1)
+                                 .arg(distance)
+                                 .arg(halted)
+                                 .arg(snapshot.time > 0 ? 100.0 * stats.busySeconds / snapshot.time : 0.0, 0, 'f', 1));
 }
 
 // 放大视野按钮点击事件
 void MainWindow::onZoomInClicked()
 {
+    if (!camera) {
+        return;
+    }
     float currentFOV = camera->fieldOfView();
     float newFOV = qMax(currentFOV - 5.0f, 10.0f); // 最小FOV限制为10度
     camera->setFieldOfView(newFOV);
@@ -967,6 +1070,9 @@ void MainWindow::onZoomInClicked()
 // 缩小视野按钮点击事件
 void MainWindow::onZoomOutClicked()
 {
+    if (!camera) {
+        return;
+    }
     float currentFOV = camera->fieldOfView();
     float newFOV = qMin(currentFOV + 5.0f, 120.0f); // 最大FOV限制为120度
     camera->setFieldOfView(newFOV);
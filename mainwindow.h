@@ -3,6 +3,8 @@
 
 #include <QMainWindow>
 #include <QTableWidget>
+#include <QTableView>
+#include <QDoubleSpinBox>
 #include <QLineEdit>
 #include <QPushButton>
 #include <QLabel>
@@ -20,6 +22,22 @@
 #include <Qt3DExtras/QCylinderMesh>
 #include <Qt3DExtras/QSphereMesh>
 #include <Qt3DCore/QTransform>
+#include <QTimer>
+#include <QDialog>
+#include <QFutureWatcher>
+#include <QThread>
+#include <QThreadPool>
+#include <QAtomicInteger>
+#include "armdynamics.h"
+#include "armscene.h"
+#include "cellsimulation.h"
+#include "collisionchecker.h"
+#include "ikseeddatabase.h"
+#include "motionplanner.h"
+#include "numerictablemodel.h"
+#include "renderscheduler.h"
+#include "sweptvolume.h"
+#include "toolpathgenerator.h"
 
 QT_BEGIN_NAMESPACE
 namespace Ui { class MainWindow; }
@@ -33,45 +51,130 @@ public:
     MainWindow(QWidget *parent = nullptr);
     ~MainWindow();
 
+protected:
+    void showEvent(QShowEvent *event) override;
+
 private slots:
     void onForwardSolveClicked();
     void onInverseSolveClicked();
     void onResetClicked();
-    void onInverseResultSelected(int row); // 新增
+    void onInverseResultSelected(const QModelIndex &index); // 新增
+    void onInverseFilterChanged();
     void onZoomInClicked();  // 新增：放大视野按钮槽函数
     void onZoomOutClicked(); // 新增：缩小视野按钮槽函数
+    void onPathAnimationStep(); // 沿规划路径播放一帧
+    void onGenerateToolPath();  // 由工件网格生成磨抛路径
+    void onCellSimulationToggled(bool enabled); // 多机器人单元仿真演示
+    void onSweptVolume();       // 当前路径的扫掠体积与间隙
 
 private:
+    // 后台求解任务的结果，在GUI线程中一次性应用到界面
+    struct ForwardSolveResult
+    {
+        QVector<double> angles;
+        double T[16];
+    };
+    struct InverseSolveResult
+    {
+        QVector<double> rows;    // 每行：关节1..4、位姿残差、限位裕度
+        QVector<quint8> flags;   // NumericTableModel::RowFlag
+        bool hasNumeric = false; // 最后一行为初值数据库给出的数值解
+    };
+    struct PathPlanResult
+    {
+        bool found = false;
+        int waypointCount = 0;
+        double planningMs = 0;
+        double duration = 0;
+        double peakTorque[4] = {0, 0, 0, 0};
+        QVector<double> animation;  // 每4个数为一个采样点的关节角
+        QVector<double> trajectory; // 每行：时间、关节1..4、力矩1..4
+    };
+    struct ToolPathResult
+    {
+        enum { MaxPreviewPoints = 20000 }; // 界面播放的路径点上限，完整路径见输出文件
+        bool ok = false;
+        QString error;
+        QString outputFile;
+        ToolPathGenerator::Stats stats;
+        QVector<double> animation; // 每4个数为一个路径点的关节角
+    };
+    struct SweptVolumeResult
+    {
+        bool ok = false;
+        QString error;
+        QString meshFile;          // 表面网格OBJ文件（临时目录）
+        SweptVolume::Result stats;
+    };
+
     Ui::MainWindow *ui;
     QTableWidget *poseMatrixInputTable;
-    QTableWidget *forwardResultTable;
-    QTableWidget *inverseResultTable;
+    QTableView *forwardResultTable;
+    QTableView *inverseResultTable;
+    QTableView *trajectoryTable;
+    NumericTableModel *forwardModel;
+    NumericTableModel *inverseModel;
+    NumericTableModel *trajectoryModel;
+    QDoubleSpinBox *residualFilter;   // 逆解表格：残差上限
+    QDoubleSpinBox *marginFilter;     // 逆解表格：限位裕度下限
     QLineEdit *theta1Edit, *theta2Edit, *theta3Edit, *theta4Edit;
     //*theta5Edit, *theta6Edit;
     QLabel *errorLabel;
-    Qt3DExtras::Qt3DWindow *view3D;   // 3D窗口容器
-    Qt3DCore::QEntity *rootEntity;    // 根实体
-    QWidget *container3D;             // 用于嵌入3D窗口的QWidget
-    Qt3DCore::QTransform *jointTransform; // 关节的变换组件
-    QVector<Qt3DCore::QTransform*> jointTransforms; // 用于存储每个关节的变换组件
-    QVector<Qt3DCore::QEntity*> linkEntities; // 用于存储每个连杆的实体
-    QVector<Qt3DCore::QTransform*> linkTransforms; // 用于存储每个连杆的变换组件
-    Qt3DCore::QEntity *endEffector;      // 末端执行器实体
-    Qt3DCore::QTransform *eeTransform;   // 末端执行器的变换组件
+    Qt3DExtras::Qt3DWindow *view3D;   // 3D窗口容器（窗口显示后才创建）
+    QWidget *container3D;             // 用于嵌入3D窗口的QWidget，创建前为占位标签
     Qt3DRender::QCamera *camera;
+    ArmScene *armScene;               // 关节、连杆、末端执行器等三维实体
+    bool sceneInitQueued = false;
+    QDialog *descriptionDialog;       // 矩阵和机械臂说明，首次打开时创建
     QPushButton *zoomInButton;    // 放大视野按钮
     QPushButton *zoomOutButton;   // 缩小视野按钮
 
-    QVector<QMatrix4x4> jointInitialTransforms;
-    QVector<QMatrix4x4> linkInitialTransforms;
-
+    CollisionChecker collisionChecker; // 自碰撞与环境碰撞检测
+    MotionPlanner motionPlanner;       // 关节空间路径规划
+    IkSeedDatabase ikSeedDatabase;     // 逆解初值数据库
+    ArmDynamics armDynamics;           // 逆动力学（关节力矩估算）
+    QVector<double> currentAngles;     // 机械臂当前关节角
+    QVector<double> endEffectorPose;   // 最近一次正解的末端位姿，复位后为空
+    QTimer *pathTimer;                 // 路径播放定时器
+    QVector<double> animationPath;     // 插值后的播放路径，每4个数为一个采样点
+    int animationIndex;
+    RenderScheduler *renderScheduler;  // 按需渲染与帧率限制
+    QLabel *renderStatsLabel;          // 状态栏中的位姿刷新率/CPU占用
+    QThreadPool solvePool;             // 正解、逆解、规划、磨抛路径、扫掠体积等后台任务
+    QFutureWatcher<ForwardSolveResult> *forwardWatcher;
+    QFutureWatcher<InverseSolveResult> *inverseWatcher;
+    QFutureWatcher<PathPlanResult> *planWatcher;
+    QFutureWatcher<ToolPathResult> *toolPathWatcher;
+    CellSimulation cellSimulation;     // 多机器人单元仿真，在专用线程按实时推进
+    QThreadPool cellPool;              // 单元仿真的并行计算，不占用全局线程池和solvePool
+    QThread *cellThread;
+    QAtomicInteger<int> cellStopping;
+    QTimer *cellViewTimer;             // 定时读取仿真快照刷新三维视图
+    QAction *cellAction;
+    Qt3DCore::QEntity *cellRoot;       // 单元中各机械臂实体的父实体
+    QVector<ArmScene*> cellScenes;
+    QFutureWatcher<SweptVolumeResult> *sweptWatcher;
+    Qt3DCore::QEntity *sweptEntity;    // 扫掠体积的半透明网格
+    QString sweptMeshFile;
+    QString pendingSweptFile;          // 正在计算的任务将写入的网格文件
+    QStringList discardedSweptFiles;   // 已取消或被取代的任务的网格文件，任务结束后删除
 
-    // 声明正解和逆解函数
-    QVector<QVector<double>> myfkine(double theta1, double theta2, double theta3, double theta4);
-    QVector<QVector<double>> mymodikine(const QVector<QVector<double>> &Tbe);
-    void createCoordinateAxes();
+    void initScene();
+    void createDescriptionDialog();
+    void setupCollisionScene();
+    void cancelPendingSolves();
+    void applyForwardResult(const ForwardSolveResult &result);
+    void applyInverseResult(const InverseSolveResult &result);
+    void applyPathPlan(const PathPlanResult &result);
+    void applyToolPath(const ToolPathResult &result);
+    void applySweptVolume(const SweptVolumeResult &result);
+    void clearSweptVolume();
+    void discardSweptVolumeJob();
+    void removeDiscardedSweptFiles();
+    void stopCellSimulation();
+    void updateCellView();
     void updateJointTransforms(const QVector<double>& angles);
-    std::vector<QVector<QVector<double>>> calculateJointMatrices(double theta1, double theta2, double theta3, double theta4);
+    void requestPose(const QVector<double> &angles);
 
 };
 #endif // MAINWINDOW_H
@@ -0,0 +1,251 @@
+#include "meshstreamreader.h"
+#include <QFileInfo>
+#include <QtEndian>
+#include <charconv>
+#include <cstdlib>
+#include <cstring>
+
+namespace
+{
+
+const qint64 kStlHeaderBytes = 84;
+const qint64 kStlTriangleBytes = 50; // 法向12字节 + 3个顶点36字节 + 属性2字节
+
+// 跳过行首空白，返回指向首个非空白字符的指针
+const char *skipSpace(const char *p)
+{
+    while (*p == ' ' || *p == '\t') {
+        ++p;
+    }
+    return p;
+}
+
+// 读取一个浮点数，返回其后的位置；无法解析时value为0、位置不变
+// 不用strtof：它按LC_NUMERIC解析小数点，而QCoreApplication在Unix上会按环境变量设置区域，小数点为逗号的区域下会读错坐标
+const char *parseFloat(const char *p, const char *end, float &value)
+{
+    p = skipSpace(p);
+    const char *begin = p < end && *p == '+' ? p + 1 : p;
+    const std::from_chars_result result = std::from_chars(begin, end, value);
+    if (result.ptr == begin) {
+        value = 0;
+        return p;
+    }
+    return result.ptr;
+}
+
+} // namespace
+
+bool MeshStreamReader::open(const QString &fileName)
+{
+    close();
+    file.setFileName(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        error = QString("无法打开网格文件：%1").arg(fileName);
+        return false;
+    }
+
+    if (QFileInfo(fileName).suffix().compare("obj", Qt::CaseInsensitive) == 0) {
+        fmt = Obj;
+        return loadObjVertices() && rewind();
+    }
+
+    // 二进制STL的文件长度由三角形数量唯一确定；部分二进制文件头也以"solid"开头，因此先按长度判断
+    const QByteArray header = file.read(kStlHeaderBytes);
+    if (header.size() == kStlHeaderBytes) {
+        const quint32 count = qFromLittleEndian<quint32>(header.constData() + 80);
+        if (kStlHeaderBytes + kStlTriangleBytes * qint64(count) == file.size()) {
+            fmt = BinaryStl;
+            declaredCount = count;
+            return rewind();
+        }
+    }
+    if (header.trimmed().startsWith("solid")) {
+        fmt = AsciiStl;
+        return rewind();
+    }
+
+    error = QString("无法识别的网格格式：%1").arg(fileName);
+    file.close();
+    return false;
+}
+
+void MeshStreamReader::close()
+{
+    file.close();
+    fmt = Unknown;
+    declaredCount = -1;
+    remaining = 0;
+    chunk.clear();
+    objVertices.clear();
+    objVerticesSeen = 0;
+    pending.clear();
+    error.clear();
+}
+
+bool MeshStreamReader::rewind()
+{
+    pending.clear();
+    objVerticesSeen = 0;
+    if (!file.isOpen() || !file.seek(fmt == BinaryStl ? kStlHeaderBytes : 0)) {
+        error = "网格文件定位失败";
+        return false;
+    }
+    remaining = fmt == BinaryStl ? declaredCount : 0;
+    return true;
+}
+
+int MeshStreamReader::read(float *triangles, int maxTriangles)
+{
+    if (maxTriangles <= 0) {
+        return 0;
+    }
+    switch (fmt) {
+    case BinaryStl:
+        return readBinaryStl(triangles, maxTriangles);
+    case AsciiStl:
+        return readAsciiStl(triangles, maxTriangles);
+    case Obj:
+        return readObj(triangles, maxTriangles);
+    default:
+        return 0;
+    }
+}
+
+int MeshStreamReader::readBinaryStl(float *triangles, int maxTriangles)
+{
+    const int count = int(qMin<qint64>(remaining, maxTriangles));
+    if (count == 0) {
+        return 0;
+    }
+    chunk.resize(count * kStlTriangleBytes);
+    if (file.read(chunk.data(), chunk.size()) != chunk.size()) {
+        error = "STL文件不完整";
+        remaining = 0;
+        return 0;
+    }
+    remaining -= count;
+
+    // 忽略文件中的法向，由顶点顺序重新计算
+    const char *p = chunk.constData();
+    for (int i = 0; i < count; ++i, p += kStlTriangleBytes) {
+        for (int k = 0; k < 9; ++k) {
+            triangles[i * 9 + k] = qFromLittleEndian<float>(p + 12 + 4 * k);
+        }
+    }
+    return count;
+}
+
+int MeshStreamReader::readAsciiStl(float *triangles, int maxTriangles)
+{
+    int count = 0;
+    int vertex = 0;
+    while (count < maxTriangles && !file.atEnd()) {
+        const QByteArray line = file.readLine();
+        const char *p = skipSpace(line.constData());
+        if (std::strncmp(p, "vertex", 6) != 0) {
+            continue;
+        }
+        p += 6;
+        const char *end = line.constData() + line.size();
+        float *v = triangles + count * 9 + vertex * 3;
+        for (int k = 0; k < 3; ++k) {
+            p = parseFloat(p, end, v[k]);
+        }
+        if (++vertex == 3) {
+            vertex = 0;
+            ++count;
+        }
+    }
+    return count;
+}
+
+bool MeshStreamReader::loadObjVertices()
+{
+    objVertices.clear();
+    while (!file.atEnd()) {
+        const QByteArray line = file.readLine();
+        const char *p = skipSpace(line.constData());
+        if (p[0] != 'v' || (p[1] != ' ' && p[1] != '\t')) {
+            continue;
+        }
+        p += 2;
+        const char *end = line.constData() + line.size();
+        for (int k = 0; k < 3; ++k) {
+            float value;
+            p = parseFloat(p, end, value);
+            objVertices.append(value);
+        }
+    }
+    if (objVertices.isEmpty()) {
+        error = "OBJ文件中没有顶点";
+        return false;
+    }
+    return true;
+}
+
+int MeshStreamReader::objVertexIndex(const char *token, int vertexCount) const
+{
+    // 索引从1开始，负数表示相对于当前已定义顶点的倒数位置
+    const int index = std::atoi(token);
+    const int resolved = index < 0 ? vertexCount + index : index - 1;
+    return (resolved >= 0 && resolved < objVertices.size() / 3) ? resolved : -1;
+}
+
+int MeshStreamReader::readObj(float *triangles, int maxTriangles)
+{
+    int count = 0;
+    while (count < maxTriangles) {
+        // 先返回上一个多边形剩余的三角形
+        if (!pending.isEmpty()) {
+            const int n = qMin(maxTriangles - count, int(pending.size() / 9));
+            std::memcpy(triangles + count * 9, pending.constData(), sizeof(float) * 9 * n);
+            pending.remove(0, 9 * n);
+            count += n;
+            continue;
+        }
+        if (file.atEnd()) {
+            break;
+        }
+
+        const QByteArray line = file.readLine();
+        const char *p = skipSpace(line.constData());
+        if (p[0] == 'v' && (p[1] == ' ' || p[1] == '\t')) {
+            ++objVerticesSeen;
+            continue;
+        }
+        if (p[0] != 'f' || (p[1] != ' ' && p[1] != '\t')) {
+            continue;
+        }
+
+        // 面片：f v1[/vt1[/vn1]] v2 ...，按扇形剖分为三角形
+        int indices[64];
+        int n = 0;
+        p += 2;
+        while (*p && n < 64) {
+            p = skipSpace(p);
+            if (*p == '\0' || *p == '\r' || *p == '\n') {
+                break;
+            }
+            const int index = objVertexIndex(p, objVerticesSeen);
+            while (*p && *p != ' ' && *p != '\t' && *p != '\r' && *p != '\n') {
+                ++p;
+            }
+            if (index < 0) {
+                n = 0; // 引用了不存在的顶点，跳过整个面片
+                break;
+            }
+            indices[n++] = index;
+        }
+        for (int t = 1; t + 1 < n; ++t) {
+            const int corners[3] = {indices[0], indices[t], indices[t + 1]};
+            for (int c = 0; c < 3; ++c) {
+                const float *v = objVertices.constData() + corners[c] * 3;
+                pending.append(v[0]);
+                pending.append(v[1]);
+                pending.append(v[2]);
+            }
+        }
+    }
+    return count;
+}
@@ -0,0 +1,48 @@
+#ifndef MESHSTREAMREADER_H
+#define MESHSTREAMREADER_H
+
+#include <QFile>
+#include <QString>
+#include <QVector>
+
+// 三角网格流式读取：支持二进制STL、ASCII STL和OBJ，
+// 按批返回三角形而不把整个网格读入内存。
+// OBJ的面片按索引引用顶点，顶点表需常驻内存（每个顶点12字节），面片仍按流读取
+class MeshStreamReader
+{
+public:
+    enum Format { Unknown, BinaryStl, AsciiStl, Obj };
+
+    bool open(const QString &fileName);
+    void close();
+    // 回到第一个三角形，用于多遍扫描
+    bool rewind();
+
+    // 读取最多maxTriangles个三角形，每个三角形9个float（3个顶点的xyz），
+    // 返回实际数量，0表示已读完或出错（见errorString）
+    int read(float *triangles, int maxTriangles);
+
+    Format format() const { return fmt; }
+    // 二进制STL文件头中的三角形数量，其他格式为-1
+    qint64 declaredTriangleCount() const { return declaredCount; }
+    QString errorString() const { return error; }
+
+private:
+    int readBinaryStl(float *triangles, int maxTriangles);
+    int readAsciiStl(float *triangles, int maxTriangles);
+    int readObj(float *triangles, int maxTriangles);
+    bool loadObjVertices();
+    int objVertexIndex(const char *token, int vertexCount) const;
+
+    QFile file;
+    Format fmt = Unknown;
+    qint64 declaredCount = -1;
+    qint64 remaining = 0;          // 二进制STL中尚未读取的三角形数
+    QByteArray chunk;              // 二进制STL读取缓冲
+    QVector<float> objVertices;    // OBJ顶点表
+    int objVerticesSeen = 0;       // 第二遍扫描中已经过的顶点数，用于负索引
+    QVector<float> pending;        // 多边形面片扇形剖分后尚未返回的三角形
+    QString error;
+};
+
+#endif // MESHSTREAMREADER_H
@@ -0,0 +1,201 @@
+#include "metrics.h"
+#include <QMap>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QScopedPointer>
+#include <QVector>
+#include <algorithm>
+#include <cmath>
+
+namespace Metrics {
+
+namespace {
+
+enum Type { CounterType, GaugeType, HistogramType };
+
+struct Entry
+{
+    Type type;
+    QByteArray help;
+    void *metric;
+};
+
+// 指标对象有意不释放：热路径可能在静态析构期间仍在其他线程中写入
+struct Registry
+{
+    QMutex mutex;
+    QMap<QByteArray, Entry> entries;
+};
+
+Registry &registry()
+{
+    static Registry *instance = new Registry;
+    return *instance;
+}
+
+template <typename T>
+T *lookup(const char *name, const char *help, Type type)
+{
+    Registry &r = registry();
+    QMutexLocker locker(&r.mutex);
+    auto it = r.entries.find(QByteArray(name));
+    if (it != r.entries.end()) {
+        if (it->type == type) {
+            return static_cast<T *>(it->metric);
+        }
+        // 同名不同类型属于编程错误：返回不导出的独立对象，保证调用方可以安全使用
+        qWarning("指标%s已按其他类型注册", name);
+        return new T;
+    }
+    T *metric = new T;
+    r.entries.insert(QByteArray(name), Entry{type, QByteArray(help), metric});
+    return metric;
+}
+
+// 族名：去掉标签部分
+QByteArray familyName(const QByteArray &name)
+{
+    const int brace = name.indexOf('{');
+    return brace < 0 ? name : name.left(brace);
+}
+
+// 在名称的标签中追加一个标签，suffix加在族名之后（用于_sum/_count）
+QByteArray withLabel(const QByteArray &name, const QByteArray &suffix, const QByteArray &label)
+{
+    const int brace = name.indexOf('{');
+    const QByteArray family = brace < 0 ? name : name.left(brace);
+    QByteArray labels = brace < 0 ? QByteArray() : name.mid(brace + 1, name.size() - brace - 2);
+    if (!label.isEmpty()) {
+        labels += labels.isEmpty() ? label : "," + label;
+    }
+    return labels.isEmpty() ? family + suffix : family + suffix + "{" + labels + "}";
+}
+
+void appendValue(QByteArray &out, const QByteArray &name, double value)
+{
+    out += name;
+    out += ' ';
+    out += QByteArray::number(value, 'g', 12);
+    out += '\n';
+}
+
+void appendValue(QByteArray &out, const QByteArray &name, quint64 value)
+{
+    out += name;
+    out += ' ';
+    out += QByteArray::number(value);
+    out += '\n';
+}
+
+} // namespace
+
+quint64 Histogram::bucketUpperBound(int index)
+{
+    const int shift = std::max(0, index / SubBuckets - 1);
+    const quint64 sub = quint64(index - shift * SubBuckets);
+    return (sub + 1) << shift;
+}
+
+void Histogram::snapshot(Snapshot &s) const
+{
+    s.count = total.load(std::memory_order_relaxed);
+    s.sum = sum.load(std::memory_order_relaxed);
+    s.max = maximum.load(std::memory_order_relaxed);
+    for (int i = 0; i < BucketCount; ++i) {
+        s.buckets[i] = buckets[i].load(std::memory_order_relaxed);
+    }
+}
+
+quint64 Histogram::Snapshot::percentile(double p) const
+{
+    // 以各桶之和为准，写入与读取交错时count可能与桶之和略有出入
+    quint64 bucketTotal = 0;
+    for (int i = 0; i < BucketCount; ++i) {
+        bucketTotal += buckets[i];
+    }
+    if (bucketTotal == 0) {
+        return 0;
+    }
+    const quint64 rank = qMax<quint64>(1, quint64(std::ceil(qBound(0.0, p, 1.0) * bucketTotal)));
+    quint64 seen = 0;
+    for (int i = 0; i < BucketCount; ++i) {
+        seen += buckets[i];
+        if (seen >= rank) {
+            return qMin(bucketUpperBound(i), max);
+        }
+    }
+    return max;
+}
+
+Counter *counter(const char *name, const char *help)
+{
+    return lookup<Counter>(name, help, CounterType);
+}
+
+Gauge *gauge(const char *name, const char *help)
+{
+    return lookup<Gauge>(name, help, GaugeType);
+}
+
+Histogram *histogram(const char *name, const char *help)
+{
+    return lookup<Histogram>(name, help, HistogramType);
+}
+
+QByteArray exposition()
+{
+    // 先在锁内复制条目，读取数值和格式化在锁外进行
+    QVector<QPair<QByteArray, Entry>> entries;
+    {
+        Registry &r = registry();
+        QMutexLocker locker(&r.mutex);
+        entries.reserve(r.entries.size());
+        for (auto it = r.entries.cbegin(); it != r.entries.cend(); ++it) {
+            entries.append(qMakePair(it.key(), it.value()));
+        }
+    }
+    // 同一族（含不同标签）的指标需连续输出，HELP/TYPE只出现一次
+    std::stable_sort(entries.begin(), entries.end(), [](const QPair<QByteArray, Entry> &a, const QPair<QByteArray, Entry> &b) {
+        return familyName(a.first) < familyName(b.first);
+    });
+
+    static const char *const typeNames[] = {"counter", "gauge", "summary"};
+    static const double quantiles[] = {0.5, 0.9, 0.99, 0.999, 1.0};
+    QByteArray out;
+    QByteArray lastFamily;
+    QScopedPointer<Histogram::Snapshot> snapshot;
+    for (const auto &item : entries) {
+        const QByteArray &name = item.first;
+        const Entry &entry = item.second;
+        const QByteArray family = familyName(name);
+        if (family != lastFamily) {
+            out += "# HELP " + family + " " + entry.help + "\n";
+            out += "# TYPE " + family + " " + typeNames[entry.type] + "\n";
+            lastFamily = family;
+        }
+        switch (entry.type) {
+        case CounterType:
+            appendValue(out, name, static_cast<const Counter *>(entry.metric)->value());
+            break;
+        case GaugeType:
+            appendValue(out, name, static_cast<const Gauge *>(entry.metric)->value());
+            break;
+        case HistogramType: {
+            if (!snapshot) {
+                snapshot.reset(new Histogram::Snapshot); // 约18KB，不放在栈上
+            }
+            static_cast<const Histogram *>(entry.metric)->snapshot(*snapshot);
+            for (const double q : quantiles) {
+                appendValue(out, withLabel(name, QByteArray(), "quantile=\"" + QByteArray::number(q) + "\""),
+                            snapshot->percentile(q) / 1e9);
+            }
+            appendValue(out, withLabel(name, "_sum", QByteArray()), snapshot->sum / 1e9);
+            appendValue(out, withLabel(name, "_count", QByteArray()), snapshot->count);
+            break;
+        }
+        }
+    }
+    return out;
+}
+
+} // namespace Metrics
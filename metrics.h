@@ -0,0 +1,128 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QtAlgorithms>
+#include <atomic>
+
+// 运行时指标：计数器、瞬时值和延迟直方图，供生产环境监控
+// 热路径上的更新只有几次relaxed原子操作，不加锁、不分配内存；注册表只在首次取用指标时加锁。
+// 用法：在热路径所在函数中用静态局部变量缓存指针，之后每次调用只付出原子操作的开销
+//   static Metrics::Counter *solves = Metrics::counter("arm_ik_inverse_total", "解析逆解调用次数");
+//   solves->add();
+// 指标名可带Prometheus标签，如 arm_server_requests_total{op="inverse"}，同名（不含标签）的指标共用HELP/TYPE行
+namespace Metrics {
+
+class Counter
+{
+public:
+    void add(quint64 n = 1) { count.fetch_add(n, std::memory_order_relaxed); }
+    quint64 value() const { return count.load(std::memory_order_relaxed); }
+
+private:
+    alignas(64) std::atomic<quint64> count{0}; // 独占缓存行，避免与相邻指标伪共享
+};
+
+class Gauge
+{
+public:
+    void set(double v) { current.store(v, std::memory_order_relaxed); }
+    void add(double delta)
+    {
+        double expected = current.load(std::memory_order_relaxed);
+        while (!current.compare_exchange_weak(expected, expected + delta, std::memory_order_relaxed)) {
+        }
+    }
+    double value() const { return current.load(std::memory_order_relaxed); }
+
+private:
+    alignas(64) std::atomic<double> current{0.0};
+};
+
+// HDR风格的对数-线性直方图（单位：纳秒）：小于2^SubBucketBits的值精确计数，
+// 更大的值每个2的幂区间再等分为2^SubBucketBits个桶，相对误差不超过1/64；上限2^40纳秒（约18分钟），超出计入最后一个桶
+class Histogram
+{
+public:
+    enum {
+        SubBucketBits = 6,
+        SubBuckets = 1 << SubBucketBits,
+        MaxValueBits = 40,
+        BucketCount = (MaxValueBits - SubBucketBits + 1) * SubBuckets
+    };
+
+    void record(quint64 nanoseconds)
+    {
+        buckets[bucketIndex(nanoseconds)].fetch_add(1, std::memory_order_relaxed);
+        total.fetch_add(1, std::memory_order_relaxed);
+        sum.fetch_add(nanoseconds, std::memory_order_relaxed);
+        quint64 seen = maximum.load(std::memory_order_relaxed);
+        while (nanoseconds > seen && !maximum.compare_exchange_weak(seen, nanoseconds, std::memory_order_relaxed)) {
+        }
+    }
+
+    static int bucketIndex(quint64 value)
+    {
+        if (value < quint64(SubBuckets)) {
+            return int(value);
+        }
+        const int msb = 63 - int(qCountLeadingZeroBits(value));
+        if (msb >= MaxValueBits) {
+            return BucketCount - 1;
+        }
+        // value >> shift 落在[SubBuckets, 2 * SubBuckets)内，各2的幂区间的桶首尾相接
+        const int shift = msb - SubBucketBits;
+        return shift * SubBuckets + int(value >> shift);
+    }
+    // 桶的上沿（不含）
+    static quint64 bucketUpperBound(int index);
+
+    // 读取时各桶分别原子读取，与并发写入之间只保证单个桶的一致性，对监控足够
+    struct Snapshot
+    {
+        quint64 count = 0;
+        quint64 sum = 0;
+        quint64 max = 0;
+        quint64 buckets[BucketCount];
+
+        double mean() const { return count ? double(sum) / count : 0.0; }
+        // 分位数（p取0..1），返回所在桶的上沿，不超过最大值
+        quint64 percentile(double p) const;
+    };
+    void snapshot(Snapshot &s) const;
+
+private:
+    std::atomic<quint64> buckets[BucketCount] = {};
+    alignas(64) std::atomic<quint64> total{0};
+    std::atomic<quint64> sum{0};
+    std::atomic<quint64> maximum{0};
+};
+
+// 作用域计时：析构时把经过的纳秒数记入直方图
+class ScopedTimer
+{
+public:
+    explicit ScopedTimer(Histogram *histogram)
+        : target(histogram)
+    {
+        timer.start();
+    }
+    ~ScopedTimer() { target->record(quint64(timer.nsecsElapsed())); }
+
+private:
+    Histogram *target;
+    QElapsedTimer timer;
+};
+
+// 按名称取用指标，首次取用时创建；返回的指针在进程生命周期内有效，可跨线程使用
+Counter *counter(const char *name, const char *help);
+Gauge *gauge(const char *name, const char *help);
+Histogram *histogram(const char *name, const char *help);
+
+// 所有指标的Prometheus文本格式（0.0.4），直方图以summary输出，单位换算为秒
+QByteArray exposition();
+
+} // namespace Metrics
+
+#endif // METRICS_H
@@ -0,0 +1,165 @@
+#include "metricsexporter.h"
+#include "metrics.h"
+#include <QSaveFile>
+#include <QSharedPointer>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTimer>
+
+namespace {
+
+// 请求头长度上限，超过后直接断开
+const int kMaxRequestBytes = 8192;
+// 客户端连接后未发完请求头的超时
+const int kRequestTimeoutMs = 5000;
+
+void respond(QTcpSocket *socket, const QByteArray &status, const QByteArray &body)
+{
+    QByteArray header = "HTTP/1.1 " + status + "\r\n";
+    header += status.startsWith("200") ? "Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n"
+                                       : "Content-Type: text/plain; charset=utf-8\r\n";
+    header += "Content-Length: " + QByteArray::number(body.size()) + "\r\n";
+    header += "Connection: close\r\n\r\n";
+    socket->write(header);
+    socket->write(body);
+    socket->disconnectFromHost();
+}
+
+// 每个连接只处理一个请求：读到完整请求头后应答并关闭
+void serveConnection(QTcpSocket *socket)
+{
+    QSharedPointer<QByteArray> buffer(new QByteArray);
+    QObject::connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+    QTimer::singleShot(kRequestTimeoutMs, socket, [socket]() { socket->abort(); });
+    QObject::connect(socket, &QTcpSocket::readyRead, socket, [socket, buffer]() {
+        buffer->append(socket->readAll());
+        const int headerEnd = buffer->indexOf("\r\n\r\n");
+        if (headerEnd < 0) {
+            if (buffer->size() > kMaxRequestBytes) {
+                socket->abort();
+            }
+            return;
+        }
+        QObject::disconnect(socket, &QTcpSocket::readyRead, nullptr, nullptr);
+
+        const QList<QByteArray> requestLine = buffer->left(buffer->indexOf("\r\n")).split(' ');
+        if (requestLine.size() < 2 || requestLine[0] != "GET") {
+            respond(socket, "405 Method Not Allowed", "仅支持GET\n");
+            return;
+        }
+        QByteArray path = requestLine[1];
+        const int query = path.indexOf('?');
+        if (query >= 0) {
+            path.truncate(query);
+        }
+        if (path == "/metrics" || path == "/") {
+            respond(socket, "200 OK", Metrics::exposition());
+        } else {
+            respond(socket, "404 Not Found", "未知路径，指标见/metrics\n");
+        }
+    });
+}
+
+bool dumpToFile(const QString &fileName)
+{
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    file.write(Metrics::exposition());
+    return file.commit();
+}
+
+} // namespace
+
+MetricsExporter::MetricsExporter()
+    : context(nullptr)
+    , boundPort(0)
+{
+    thread.setObjectName("metrics");
+}
+
+MetricsExporter::~MetricsExporter()
+{
+    stop();
+}
+
+bool MetricsExporter::start(quint16 port, const QString &fileName, int intervalMs, const QHostAddress &address)
+{
+    stop();
+    error.clear();
+    if (port == 0 && fileName.isEmpty()) {
+        error = "未指定端口或文件";
+        return false;
+    }
+
+    context = new QObject;
+    context->moveToThread(&thread);
+    thread.start();
+
+    // 服务器和定时器在导出线程中创建，信号槽都在该线程执行
+    bool ok = true;
+    QMetaObject::invokeMethod(context, [&]() {
+        if (port != 0) {
+            QTcpServer *server = new QTcpServer(context);
+            QObject::connect(server, &QTcpServer::newConnection, server, [server]() {
+                while (QTcpSocket *socket = server->nextPendingConnection()) {
+                    serveConnection(socket);
+                }
+            });
+            if (!server->listen(address, port)) {
+                error = QString("指标端口%1监听失败：%2").arg(port).arg(server->errorString());
+                ok = false;
+                return;
+            }
+            boundPort = server->serverPort();
+        }
+        if (!fileName.isEmpty()) {
+            if (!dumpToFile(fileName)) {
+                error = QString("无法写入指标文件：%1").arg(fileName);
+                ok = false;
+                return;
+            }
+            QTimer *timer = new QTimer(context);
+            QObject::connect(timer, &QTimer::timeout, timer, [fileName]() { dumpToFile(fileName); });
+            timer->start(qMax(100, intervalMs));
+        }
+    }, Qt::BlockingQueuedConnection);
+
+    if (!ok) {
+        stop();
+        return false;
+    }
+    return true;
+}
+
+bool MetricsExporter::startFromEnvironment()
+{
+    const quint16 port = quint16(qEnvironmentVariableIntValue("ARM_METRICS_PORT"));
+    const QString fileName = qEnvironmentVariable("ARM_METRICS_FILE");
+    if (port == 0 && fileName.isEmpty()) {
+        return false;
+    }
+    bool ok = false;
+    const int interval = qEnvironmentVariableIntValue("ARM_METRICS_INTERVAL_MS", &ok);
+    return start(port, fileName, ok ? interval : 10000);
+}
+
+void MetricsExporter::stop()
+{
+    if (!context) {
+        return;
+    }
+    // 子对象（服务器、连接、定时器）须在所属线程中删除
+    if (thread.isRunning()) {
+        QMetaObject::invokeMethod(context, [this]() {
+            const QObjectList children = context->children();
+            qDeleteAll(children);
+        }, Qt::BlockingQueuedConnection);
+        thread.quit();
+        thread.wait();
+    }
+    delete context;
+    context = nullptr;
+    boundPort = 0;
+}
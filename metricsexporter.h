@@ -0,0 +1,35 @@
+#ifndef METRICSEXPORTER_H
+#define METRICSEXPORTER_H
+
+#include <QHostAddress>
+#include <QString>
+#include <QThread>
+
+// 指标导出：本地HTTP文本端点（GET /metrics，Prometheus文本格式）和定时写文件，
+// 都在独立线程的事件循环中运行，与界面线程和计算线程互不阻塞
+// 文件先写入临时文件再替换，监控代理不会读到写了一半的内容
+class MetricsExporter
+{
+public:
+    MetricsExporter();
+    ~MetricsExporter();
+
+    // port为0时不开HTTP端点，fileName为空时不写文件
+    bool start(quint16 port, const QString &fileName, int intervalMs = 10000,
+               const QHostAddress &address = QHostAddress::LocalHost);
+    // 按环境变量启动：ARM_METRICS_PORT、ARM_METRICS_FILE、ARM_METRICS_INTERVAL_MS（默认10000），都未设置时不启动
+    bool startFromEnvironment();
+    void stop();
+
+    bool isRunning() const { return thread.isRunning(); }
+    quint16 serverPort() const { return boundPort; }
+    QString errorString() const { return error; }
+
+private:
+    QThread thread;
+    QObject *context;    // 属于导出线程，服务器、定时器和连接都是它的子对象
+    quint16 boundPort;
+    QString error;
+};
+
+#endif // METRICSEXPORTER_H
@@ -0,0 +1,306 @@
+#include "motionplanner.h"
+#include "armkinematics.h"
+#include "collisionchecker.h"
+#include <QThread>
+#include <QThreadPool>
+#include <QtConcurrent>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <random>
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+// 关节空间KD树（支持增量插入），用于查找树中距离采样点最近的顶点
+class KdTree
+{
+public:
+    int size() const { return left.size(); }
+    const double *point(int i) const { return points.constData() + 4 * i; }
+
+    int insert(const double q[4])
+    {
+        const int index = size();
+        for (int i = 0; i < 4; ++i) {
+            points.append(q[i]);
+        }
+        left.append(-1);
+        right.append(-1);
+        if (index == 0) {
+            return index;
+        }
+
+        int node = 0;
+        int depth = 0;
+        while (true) {
+            const int axis = depth % 4;
+            int &child = q[axis] < point(node)[axis] ? left[node] : right[node];
+            if (child < 0) {
+                child = index;
+                return index;
+            }
+            node = child;
+            ++depth;
+        }
+    }
+
+    int nearest(const double q[4]) const
+    {
+        int best = -1;
+        double bestDist = INFINITY;
+        nearestRecursive(0, 0, q, best, bestDist);
+        return best;
+    }
+
+private:
+    void nearestRecursive(int node, int depth, const double q[4], int &best, double &bestDist) const
+    {
+        if (node < 0) {
+            return;
+        }
+        const double *p = point(node);
+        double dist = 0;
+        for (int i = 0; i < 4; ++i) {
+            dist += (q[i] - p[i]) * (q[i] - p[i]);
+        }
+        if (dist < bestDist) {
+            bestDist = dist;
+            best = node;
+        }
+
+        const int axis = depth % 4;
+        const double delta = q[axis] - p[axis];
+        const int nearSide = delta < 0 ? left[node] : right[node];
+        const int farSide = delta < 0 ? right[node] : left[node];
+        nearestRecursive(nearSide, depth + 1, q, best, bestDist);
+        // 分割面与当前最近距离球相交时才需要搜索另一侧
+        if (delta * delta < bestDist) {
+            nearestRecursive(farSide, depth + 1, q, best, bestDist);
+        }
+    }
+
+    QVector<double> points;
+    QVector<int> left;
+    QVector<int> right;
+};
+
+struct Tree
+{
+    KdTree index;
+    QVector<int> parent;
+
+    int add(const double q[4], int parentIndex)
+    {
+        parent.append(parentIndex);
+        return index.insert(q);
+    }
+};
+
+enum ExtendResult { Trapped, Advanced, Reached };
+
+// 单棵RRT-Connect的求解过程，多个线程各自使用不同随机种子并行运行
+class RrtConnect
+{
+public:
+    RrtConnect(const CollisionChecker &checker, const MotionPlanner::Options &opts, unsigned seed)
+        : checker(checker), opts(opts), rng(seed) {}
+
+    bool solve(const double start[4], const double goal[4], const std::atomic<bool> &stop,
+               Clock::time_point deadline, QVector<QVector<double>> &path)
+    {
+        Tree startTree, goalTree;
+        startTree.add(start, -1);
+        goalTree.add(goal, -1);
+
+        Tree *a = &startTree;
+        Tree *b = &goalTree;
+        std::uniform_real_distribution<double> unit(0.0, 1.0);
+
+        while (!stop.load(std::memory_order_relaxed) && Clock::now() < deadline) {
+            double sample[4];
+            for (int i = 0; i < 4; ++i) {
+                sample[i] = ArmKinematics::jointMin[i] + unit(rng) * (ArmKinematics::jointMax[i] - ArmKinematics::jointMin[i]);
+            }
+
+            if (extend(*a, sample) != Trapped) {
+                const int newIndex = a->index.size() - 1;
+                if (connect(*b, a->index.point(newIndex)) == Reached) {
+                    const int aIndex = newIndex;
+                    const int bIndex = b->index.size() - 1;
+                    if (a == &startTree) {
+                        buildPath(startTree, aIndex, goalTree, bIndex, path);
+                    } else {
+                        buildPath(startTree, bIndex, goalTree, aIndex, path);
+                    }
+                    nodeCount = startTree.index.size() + goalTree.index.size();
+                    return true;
+                }
+            }
+            std::swap(a, b);
+        }
+        nodeCount = startTree.index.size() + goalTree.index.size();
+        return false;
+    }
+
+    int nodeCount = 0;
+
+private:
+    ExtendResult extend(Tree &tree, const double target[4])
+    {
+        const int nearIndex = tree.index.nearest(target);
+        const double *qNear = tree.index.point(nearIndex);
+
+        double diff[4];
+        double dist = 0;
+        for (int i = 0; i < 4; ++i) {
+            diff[i] = target[i] - qNear[i];
+            dist += diff[i] * diff[i];
+        }
+        dist = std::sqrt(dist);
+
+        double qNew[4];
+        const bool reached = dist <= opts.stepSize;
+        for (int i = 0; i < 4; ++i) {
+            qNew[i] = reached ? target[i] : qNear[i] + diff[i] * opts.stepSize / dist;
+        }
+
+        if (!checker.isMotionFree(qNear, qNew, opts.collisionStep)) {
+            return Trapped;
+        }
+        tree.add(qNew, nearIndex);
+        return reached ? Reached : Advanced;
+    }
+
+    ExtendResult connect(Tree &tree, const double *target)
+    {
+        // target指向另一棵树的存储，扩展本树不会使其失效，但仍拷贝一份以免误用
+        const double q[4] = {target[0], target[1], target[2], target[3]};
+        ExtendResult result = Advanced;
+        while (result == Advanced) {
+            result = extend(tree, q);
+        }
+        return result;
+    }
+
+    static void buildPath(const Tree &startTree, int startIndex, const Tree &goalTree, int goalIndex,
+                          QVector<QVector<double>> &path)
+    {
+        path.clear();
+        for (int i = startIndex; i >= 0; i = startTree.parent[i]) {
+            const double *p = startTree.index.point(i);
+            path.prepend(QVector<double>{p[0], p[1], p[2], p[3]});
+        }
+        // 两棵树在连接点重合，跳过目标树中的重复点
+        for (int i = goalTree.parent[goalIndex]; i >= 0; i = goalTree.parent[i]) {
+            const double *p = goalTree.index.point(i);
+            path.append(QVector<double>{p[0], p[1], p[2], p[3]});
+        }
+    }
+
+    const CollisionChecker &checker;
+    const MotionPlanner::Options &opts;
+    std::mt19937 rng;
+};
+
+} // namespace
+
+MotionPlanner::MotionPlanner(const CollisionChecker &checker)
+    : checker(checker)
+{
+}
+
+void MotionPlanner::setOptions(const Options &options)
+{
+    opts = options;
+}
+
+bool MotionPlanner::plan(const double start[4], const double goal[4], QVector<QVector<double>> &path)
+{
+    const Clock::time_point begin = Clock::now();
+    const Clock::time_point deadline = begin + std::chrono::milliseconds(opts.timeLimitMs);
+    // 树搜索用前4/5的时间，其余留给捷径平滑
+    const Clock::time_point searchDeadline = begin + std::chrono::microseconds(opts.timeLimitMs * 800LL);
+    path.clear();
+    treeSize = 0;
+
+    auto finish = [&](bool ok) {
+        planningTimeMs = std::chrono::duration<double, std::milli>(Clock::now() - begin).count();
+        return ok;
+    };
+
+    if (!ArmKinematics::withinLimits(start) || !ArmKinematics::withinLimits(goal)
+        || !checker.isFree(start) || !checker.isFree(goal)) {
+        return finish(false);
+    }
+
+    // 直线运动无碰撞时无需规划
+    if (checker.isMotionFree(start, goal, opts.collisionStep)) {
+        path.append(QVector<double>{start[0], start[1], start[2], start[3]});
+        path.append(QVector<double>{goal[0], goal[1], goal[2], goal[3]});
+        return finish(true);
+    }
+
+    // 多棵RRT-Connect并行生长，任意一个找到路径后其余立即停止
+    const int workers = opts.threadCount > 0 ? opts.threadCount : qMax(1, QThread::idealThreadCount());
+    std::atomic<bool> found(false);
+    std::atomic<int> winner(-1);
+    QVector<QVector<QVector<double>>> paths(workers);
+    QVector<int> nodeCounts(workers, 0);
+
+    auto runWorker = [&](int w) {
+        RrtConnect rrt(checker, opts, 0x9e3779b9u * unsigned(w + 1));
+        if (rrt.solve(start, goal, found, searchDeadline, paths[w])) {
+            int expected = -1;
+            if (winner.compare_exchange_strong(expected, w)) {
+                found.store(true);
+            }
+        }
+        nodeCounts[w] = rrt.nodeCount;
+    };
+
+    // 规划本身通常就在全局线程池的任务中运行，工作线程放到独立的线程池，
+    // 全局线程池繁忙时各棵树仍能同时生长，而不是等调用线程超时后才被依次执行
+    QThreadPool pool;
+    pool.setMaxThreadCount(qMax(1, workers - 1));
+    QVector<QFuture<void>> futures;
+    for (int w = 1; w < workers; ++w) {
+        futures.append(QtConcurrent::run(&pool, [&runWorker, w]() { runWorker(w); }));
+    }
+    runWorker(0); // 调用线程也参与规划
+    for (QFuture<void> &future : futures) {
+        future.waitForFinished();
+    }
+
+    for (int count : nodeCounts) {
+        treeSize += count;
+    }
+    if (winner.load() < 0) {
+        return finish(false);
+    }
+
+    path = paths[winner.load()];
+    shortcut(path, unsigned(treeSize), deadline);
+    return finish(true);
+}
+
+void MotionPlanner::shortcut(QVector<QVector<double>> &path, unsigned seed, Clock::time_point deadline) const
+{
+    // 随机选取两个路径点，若两点间直线无碰撞则删除中间点；到达时间上限时保留已平滑的结果
+    std::mt19937 rng(seed);
+    for (int iter = 0; iter < opts.shortcutIterations && path.size() > 2 && Clock::now() < deadline; ++iter) {
+        std::uniform_int_distribution<int> pick(0, path.size() - 1);
+        int i = pick(rng);
+        int j = pick(rng);
+        if (i > j) {
+            std::swap(i, j);
+        }
+        if (j - i < 2) {
+            continue;
+        }
+        if (checker.isMotionFree(path[i].constData(), path[j].constData(), opts.collisionStep)) {
+            path.erase(path.begin() + i + 1, path.begin() + j);
+        }
+    }
+}
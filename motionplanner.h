@@ -0,0 +1,44 @@
+#ifndef MOTIONPLANNER_H
+#define MOTIONPLANNER_H
+
+#include <QVector>
+#include <chrono>
+
+class CollisionChecker;
+
+// 关节空间运动规划：并行RRT-Connect + 捷径平滑
+// 关节范围使用mymodikine中的限位表（ArmKinematics::jointMin/jointMax）
+class MotionPlanner
+{
+public:
+    struct Options
+    {
+        double stepSize = 0.15;        // 树扩展步长（弧度，关节空间欧氏距离）
+        double collisionStep = 0.02;   // 边碰撞检查的插值步长（弧度）
+        int timeLimitMs = 50;          // 规划时间上限（含捷径平滑，平滑预留其中的1/5）
+        int threadCount = 0;           // 并行树的数量，0表示按CPU核数
+        int shortcutIterations = 200;  // 捷径平滑迭代次数上限，到达时间上限时提前结束
+    };
+
+    explicit MotionPlanner(const CollisionChecker &checker);
+
+    void setOptions(const Options &options);
+    const Options &options() const { return opts; }
+
+    // 规划从start到goal的无碰撞路径，成功时path为路径点序列（每点4个关节角）
+    bool plan(const double start[4], const double goal[4], QVector<QVector<double>> &path);
+
+    // 上一次规划的统计信息
+    double lastPlanningTimeMs() const { return planningTimeMs; }
+    int lastTreeSize() const { return treeSize; }
+
+private:
+    void shortcut(QVector<QVector<double>> &path, unsigned seed, std::chrono::steady_clock::time_point deadline) const;
+
+    const CollisionChecker &checker;
+    Options opts;
+    double planningTimeMs = 0;
+    int treeSize = 0;
+};
+
+#endif // MOTIONPLANNER_H
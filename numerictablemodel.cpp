@@ -0,0 +1,209 @@
+#include "numerictablemodel.h"
+#include <QColor>
+#include <algorithm>
+#include <cmath>
+
+NumericTableModel::NumericTableModel(QObject *parent)
+    : QAbstractTableModel(parent)
+    , columns(0)
+    , precision(6)
+    , sortColumn(-1)
+    , sortOrder(Qt::AscendingOrder)
+{
+}
+
+void NumericTableModel::setHeaders(const QStringList &headers)
+{
+    beginResetModel();
+    columnHeaders = headers;
+    columns = headers.size();
+    buffer.clear();
+    flags.clear();
+    rowLabels.clear();
+    rebuildRows();
+    endResetModel();
+}
+
+void NumericTableModel::setPrecision(int digits)
+{
+    precision = digits;
+    if (!rows.isEmpty()) {
+        emit dataChanged(index(0, 0), index(rows.size() - 1, columns - 1), {Qt::DisplayRole});
+    }
+}
+
+void NumericTableModel::setValues(const QVector<double> &values, const QVector<quint8> &rowFlags)
+{
+    beginResetModel();
+    buffer = values;
+    flags = rowFlags;
+    rowLabels.clear();
+    rebuildRows();
+    endResetModel();
+}
+
+void NumericTableModel::setRowLabel(int sourceRow, const QString &label)
+{
+    rowLabels.insert(sourceRow, label);
+    const int row = rows.indexOf(sourceRow);
+    if (row >= 0) {
+        emit headerDataChanged(Qt::Vertical, row, row);
+    }
+}
+
+void NumericTableModel::clear()
+{
+    setValues(QVector<double>());
+}
+
+void NumericTableModel::setColumnRange(int column, double minimum, double maximum)
+{
+    beginResetModel();
+    columnRanges.insert(column, qMakePair(minimum, maximum));
+    rebuildRows();
+    endResetModel();
+}
+
+void NumericTableModel::clearColumnRanges()
+{
+    beginResetModel();
+    columnRanges.clear();
+    rebuildRows();
+    endResetModel();
+}
+
+int NumericTableModel::sourceRow(int row) const
+{
+    return (row >= 0 && row < rows.size()) ? rows[row] : -1;
+}
+
+const double *NumericTableModel::rowValues(int row) const
+{
+    const int source = sourceRow(row);
+    return source < 0 ? nullptr : buffer.constData() + qsizetype(source) * columns;
+}
+
+quint8 NumericTableModel::rowFlags(int row) const
+{
+    const int source = sourceRow(row);
+    return (source < 0 || source >= flags.size()) ? 0 : flags[source];
+}
+
+int NumericTableModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : rows.size();
+}
+
+int NumericTableModel::columnCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : columns;
+}
+
+QVariant NumericTableModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= rows.size() || index.column() >= columns) {
+        return QVariant();
+    }
+
+    switch (role) {
+    case Qt::DisplayRole:
+        return QString::number(rowValues(index.row())[index.column()], 'g', precision);
+    case Qt::TextAlignmentRole:
+        return int(Qt::AlignRight | Qt::AlignVCenter);
+    case Qt::BackgroundRole: {
+        const quint8 f = rowFlags(index.row());
+        if (f & Colliding) return QColor(255, 200, 200);              // 碰撞解标红
+        if (f & (Clamped | NotConverged)) return QColor(255, 230, 180); // 截断或未收敛标黄
+        if (f & WristFlipped) return QColor(230, 230, 230);            // x轴反向标灰
+        return QVariant();
+    }
+    case Qt::ToolTipRole: {
+        const quint8 f = rowFlags(index.row());
+        QStringList tips;
+        if (f & Colliding) tips << "该组解存在自碰撞或与环境碰撞";
+        if (f & Clamped) tips << "该组解有关节角被限位截断";
+        if (f & NotConverged) tips << "数值迭代未收敛";
+        if (f & WristFlipped) tips << "关节4与相邻解相差180°，末端x轴与目标相反";
+        return tips.isEmpty() ? QVariant() : QVariant(tips.join("\n"));
+    }
+    default:
+        return QVariant();
+    }
+}
+
+QVariant NumericTableModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (role != Qt::DisplayRole) {
+        return QVariant();
+    }
+    if (orientation == Qt::Horizontal) {
+        return section < columnHeaders.size() ? QVariant(columnHeaders[section]) : QVariant();
+    }
+    const int source = sourceRow(section);
+    if (source < 0) {
+        return QVariant();
+    }
+    const auto it = rowLabels.constFind(source);
+    return it != rowLabels.constEnd() ? QVariant(it.value()) : QVariant(source + 1);
+}
+
+void NumericTableModel::sort(int column, Qt::SortOrder order)
+{
+    // 列号为-1时恢复原始顺序
+    emit layoutAboutToBeChanged();
+    const QVector<int> oldRows = rows;
+    sortColumn = column < columns ? column : -1;
+    sortOrder = order;
+    rebuildRows();
+
+    // 选中项等持久索引跟随原始行移动
+    QVector<int> newPosition(buffer.size() / qMax(columns, 1), -1);
+    for (int r = 0; r < rows.size(); ++r) {
+        newPosition[rows[r]] = r;
+    }
+    const QModelIndexList from = persistentIndexList();
+    QModelIndexList to;
+    for (const QModelIndex &old : from) {
+        to.append(index(newPosition[oldRows[old.row()]], old.column()));
+    }
+    changePersistentIndexList(from, to);
+    emit layoutChanged();
+}
+
+void NumericTableModel::rebuildRows()
+{
+    rows.clear();
+    if (columns <= 0) {
+        return;
+    }
+    const int total = buffer.size() / columns;
+    rows.reserve(total);
+    for (int r = 0; r < total; ++r) {
+        const double *values = buffer.constData() + qsizetype(r) * columns;
+        bool visible = true;
+        for (auto it = columnRanges.constBegin(); it != columnRanges.constEnd() && visible; ++it) {
+            if (it.key() < columns) {
+                const double v = values[it.key()];
+                visible = v >= it.value().first && v <= it.value().second;
+            }
+        }
+        if (visible) {
+            rows.append(r);
+        }
+    }
+
+    if (sortColumn >= 0 && sortColumn < columns) {
+        // NaN（如不可达位姿的残差）始终排在最后
+        const double *data = buffer.constData();
+        const int stride = columns;
+        const int column = sortColumn;
+        const bool ascending = sortOrder == Qt::AscendingOrder;
+        std::stable_sort(rows.begin(), rows.end(), [=](int a, int b) {
+            const double va = data[qsizetype(a) * stride + column];
+            const double vb = data[qsizetype(b) * stride + column];
+            if (std::isnan(va)) return false;
+            if (std::isnan(vb)) return true;
+            return ascending ? va < vb : va > vb;
+        });
+    }
+}
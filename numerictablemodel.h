@@ -0,0 +1,65 @@
+#ifndef NUMERICTABLEMODEL_H
+#define NUMERICTABLEMODEL_H
+
+#include <QAbstractTableModel>
+#include <QHash>
+#include <QPair>
+#include <QStringList>
+#include <QVector>
+
+// 基于连续double缓冲区（行优先）的只读表格模型
+// 单元格文本在视图请求时才格式化，排序和过滤只维护一个行号数组，内存占用与行数成正比且不随单元格创建对象
+class NumericTableModel : public QAbstractTableModel
+{
+    Q_OBJECT
+
+public:
+    // 行状态，决定背景色和提示
+    enum RowFlag : quint8 {
+        Colliding = 0x1,     // 存在碰撞
+        Clamped = 0x2,       // 关节角被限位截断
+        NotConverged = 0x4,  // 数值迭代未收敛
+        WristFlipped = 0x8   // 末端x轴与目标相反
+    };
+
+    explicit NumericTableModel(QObject *parent = nullptr);
+
+    void setHeaders(const QStringList &headers);
+    void setPrecision(int digits);
+
+    // values按行优先存储，行数为values.size()/列数；flags为空或与行数相同
+    void setValues(const QVector<double> &values, const QVector<quint8> &flags = QVector<quint8>());
+    // 自定义行表头（按原始行号），未设置时显示行号
+    void setRowLabel(int sourceRow, const QString &label);
+    void clear();
+
+    // 只显示该列值在[minimum, maximum]内的行
+    void setColumnRange(int column, double minimum, double maximum);
+    void clearColumnRanges();
+
+    int sourceRow(int row) const;
+    const double *rowValues(int row) const;
+    quint8 rowFlags(int row) const;
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+    void sort(int column, Qt::SortOrder order = Qt::AscendingOrder) override;
+
+private:
+    void rebuildRows();
+
+    QStringList columnHeaders;
+    QVector<double> buffer;
+    QVector<quint8> flags;
+    QHash<int, QString> rowLabels;
+    QHash<int, QPair<double, double>> columnRanges;
+    QVector<int> rows;   // 可见行 -> 原始行
+    int columns;
+    int precision;
+    int sortColumn;
+    Qt::SortOrder sortOrder;
+};
+
+#endif // NUMERICTABLEMODEL_H
@@ -0,0 +1,347 @@
+#include "offscreenrenderer.h"
+#include "armkinematics.h"
+#include "armscene.h"
+#include "metrics.h"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QOffscreenSurface>
+#include <QSurfaceFormat>
+#include <QThread>
+#include <QtConcurrent>
+#include <Qt3DCore/QAspectEngine>
+#include <Qt3DRender/QCamera>
+#include <Qt3DRender/QCameraSelector>
+#include <Qt3DRender/QClearBuffers>
+#include <Qt3DRender/QRenderAspect>
+#include <Qt3DRender/QRenderCapture>
+#include <Qt3DRender/QRenderSettings>
+#include <Qt3DRender/QRenderSurfaceSelector>
+#include <Qt3DRender/QRenderTarget>
+#include <Qt3DRender/QRenderTargetOutput>
+#include <Qt3DRender/QRenderTargetSelector>
+#include <Qt3DRender/QTexture>
+#include <Qt3DRender/QViewport>
+#include <cstdio>
+#ifdef Q_OS_WIN
+#include <fcntl.h>
+#include <io.h>
+#endif
+
+namespace {
+
+// 编码队列容量（每个编码线程的帧数），超过后渲染等待
+const int kFramesPerEncoder = 2;
+
+} // namespace
+
+OffscreenRenderer::OffscreenRenderer(QObject *parent)
+    : QObject(parent)
+    , rawFile(nullptr)
+    , surface(nullptr)
+    , engine(nullptr)
+    , rootEntity(nullptr)
+    , camera(nullptr)
+    , capture(nullptr)
+    , scene(nullptr)
+    , queue(nullptr)
+    , running(false)
+    , canceled(false)
+{
+}
+
+OffscreenRenderer::~OffscreenRenderer()
+{
+    cancel();
+    destroyScene();
+    delete rawFile;
+    delete queue;
+}
+
+bool OffscreenRenderer::start(const QVector<double> &frames, const Options &options)
+{
+    if (running) {
+        error = "离线渲染正在进行";
+        return false;
+    }
+    if (frames.size() < 4) {
+        error = "没有要渲染的帧";
+        return false;
+    }
+    if (options.size.width() <= 0 || options.size.height() <= 0) {
+        error = "分辨率无效";
+        return false;
+    }
+    opts = options;
+    path = frames;
+    stat = Stats();
+    error.clear();
+    writeFailed = 0;
+    canceled = false;
+    if (!openOutput()) {
+        return false;
+    }
+    // 场景按分辨率创建，分辨率变化时重建
+    if (engine && sceneSize != opts.size) {
+        destroyScene();
+    }
+    if (!engine) {
+        createScene();
+    }
+
+    // 原始视频只用一个编码线程以保证帧序；图像序列各帧独立编码，由多个线程并行压缩
+    const int encoderCount = imageTemplate.isEmpty() ? 1 : qMax(1, QThread::idealThreadCount() - 1);
+    delete queue;
+    queue = new BoundedQueue<Frame>(kFramesPerEncoder * encoderCount);
+    queue->setDepthGauge(Metrics::gauge("arm_render_encode_queue_depth", "离线渲染：等待编码的帧数"));
+    encoderMs = QVector<double>(encoderCount, 0.0);
+    encoders.clear();
+    for (int k = 0; k < encoderCount; ++k) {
+        double *ms = &encoderMs[k];
+        encoders.append(QtConcurrent::run([this, ms]() { encodeFrames(ms); }));
+    }
+
+    running = true;
+    wallClock.start();
+    requestFrame(0);
+    return true;
+}
+
+void OffscreenRenderer::cancel()
+{
+    if (running) {
+        canceled = true;
+        finish(false);
+    }
+}
+
+bool OffscreenRenderer::openOutput()
+{
+    delete rawFile;
+    rawFile = nullptr;
+    imageTemplate.clear();
+
+    const QString output = opts.output;
+    const QFileInfo info(output);
+    const QString suffix = info.suffix().toLower();
+    if (output == "-" || suffix == "rgb" || suffix == "raw") {
+#ifdef Q_OS_WIN
+        // Windows的标准输出默认为文本模式，会把像素数据中的0x0A改写为0x0D 0x0A
+        if (output == "-") {
+            std::fflush(stdout);
+            _setmode(_fileno(stdout), _O_BINARY);
+        }
+#endif
+        rawFile = new QFile(output);
+        const bool ok = output == "-" ? rawFile->open(stdout, QIODevice::WriteOnly) : rawFile->open(QIODevice::WriteOnly);
+        if (!ok) {
+            error = QString("无法写入视频文件：%1").arg(output);
+            return false;
+        }
+        return true;
+    }
+
+    QString directory;
+    if (suffix == "png" || suffix == "jpg" || suffix == "jpeg" || suffix == "bmp") {
+        directory = info.absolutePath();
+        imageTemplate = QString("%1/%2_%3.%4").arg(directory, info.completeBaseName(), "%1", info.suffix());
+    } else {
+        directory = info.absoluteFilePath();
+        imageTemplate = directory + "/frame_%1.png";
+    }
+    if (!QDir().mkpath(directory)) {
+        error = QString("无法创建输出目录：%1").arg(directory);
+        imageTemplate.clear();
+        return false;
+    }
+    return true;
+}
+
+void OffscreenRenderer::createScene()
+{
+    // 与界面窗口相同的表面格式；离线渲染不使用多重采样
+    QSurfaceFormat format = QSurfaceFormat::defaultFormat();
+    format.setSamples(0);
+    surface = new QOffscreenSurface;
+    surface->setFormat(format);
+    surface->create();
+
+    rootEntity = new Qt3DCore::QEntity;
+    scene = new ArmScene(rootEntity);
+    camera = new Qt3DRender::QCamera(rootEntity);
+    ArmScene::setupCamera(camera);
+    camera->setAspectRatio(float(opts.size.width()) / opts.size.height());
+
+    // 帧图：离屏表面 -> 颜色/深度纹理渲染目标 -> 视口 -> 清屏 -> 相机，在相机节点下读回颜色纹理
+    Qt3DRender::QRenderSurfaceSelector *surfaceSelector = new Qt3DRender::QRenderSurfaceSelector;
+    surfaceSelector->setSurface(surface);
+    surfaceSelector->setExternalRenderTargetSize(opts.size);
+
+    Qt3DRender::QRenderTargetSelector *targetSelector = new Qt3DRender::QRenderTargetSelector(surfaceSelector);
+    Qt3DRender::QRenderTarget *target = new Qt3DRender::QRenderTarget(targetSelector);
+    const struct {
+        Qt3DRender::QRenderTargetOutput::AttachmentPoint attachment;
+        Qt3DRender::QAbstractTexture::TextureFormat format;
+    } outputs[] = {
+        {Qt3DRender::QRenderTargetOutput::Color0, Qt3DRender::QAbstractTexture::RGBA8_UNorm},
+        {Qt3DRender::QRenderTargetOutput::Depth, Qt3DRender::QAbstractTexture::D24},
+    };
+    for (const auto &o : outputs) {
+        Qt3DRender::QRenderTargetOutput *output = new Qt3DRender::QRenderTargetOutput(target);
+        Qt3DRender::QTexture2D *texture = new Qt3DRender::QTexture2D(output);
+        texture->setSize(opts.size.width(), opts.size.height());
+        texture->setFormat(o.format);
+        texture->setMinificationFilter(Qt3DRender::QAbstractTexture::Linear);
+        texture->setMagnificationFilter(Qt3DRender::QAbstractTexture::Linear);
+        output->setAttachmentPoint(o.attachment);
+        output->setTexture(texture);
+        target->addOutput(output);
+    }
+    targetSelector->setTarget(target);
+
+    Qt3DRender::QViewport *viewport = new Qt3DRender::QViewport(targetSelector);
+    viewport->setNormalizedRect(QRectF(0, 0, 1, 1));
+    Qt3DRender::QClearBuffers *clearBuffers = new Qt3DRender::QClearBuffers(viewport);
+    clearBuffers->setBuffers(Qt3DRender::QClearBuffers::ColorDepthBuffer);
+    clearBuffers->setClearColor(opts.background);
+    Qt3DRender::QCameraSelector *cameraSelector = new Qt3DRender::QCameraSelector(clearBuffers);
+    cameraSelector->setCamera(camera);
+    capture = new Qt3DRender::QRenderCapture(cameraSelector);
+
+    // 只在场景变化或请求读回时绘制
+    Qt3DRender::QRenderSettings *settings = new Qt3DRender::QRenderSettings(rootEntity);
+    settings->setActiveFrameGraph(surfaceSelector);
+    settings->setRenderPolicy(Qt3DRender::QRenderSettings::OnDemand);
+    rootEntity->addComponent(settings);
+
+    engine = new Qt3DCore::QAspectEngine;
+    engine->registerAspect(new Qt3DRender::QRenderAspect);
+    engine->setRootEntity(Qt3DCore::QEntityPtr(rootEntity));
+    sceneSize = opts.size;
+}
+
+void OffscreenRenderer::destroyScene()
+{
+    // 根实体由引擎持有，清空后随之删除；纹理等GPU资源需在表面销毁前释放
+    if (engine) {
+        engine->setRootEntity(Qt3DCore::QEntityPtr());
+        delete engine;
+        engine = nullptr;
+    }
+    delete scene;
+    scene = nullptr;
+    rootEntity = nullptr;
+    camera = nullptr;
+    capture = nullptr;
+    delete surface;
+    surface = nullptr;
+}
+
+void OffscreenRenderer::requestFrame(int index)
+{
+    // 场景变化与读回请求在同一次同步中提交，读回的图像即为该帧
+    const double *q = path.constData() + 4 * index;
+    double T[16];
+    ArmKinematics::forward(q, T);
+    scene->setJointAngles(q);
+    scene->setEndEffectorPose(T);
+
+    frameClock.start();
+    Qt3DRender::QRenderCaptureReply *reply = capture->requestCapture();
+    connect(reply, &Qt3DRender::QRenderCaptureReply::completed, this, [this, reply, index]() {
+        onFrameCaptured(reply, index);
+    });
+}
+
+void OffscreenRenderer::onFrameCaptured(Qt3DRender::QRenderCaptureReply *reply, int index)
+{
+    reply->deleteLater();
+    if (!running) {
+        return;
+    }
+    static Metrics::Histogram *frameTime = Metrics::histogram("arm_render_offscreen_frame_seconds",
+                                                              "离线渲染：每帧从请求到读回完成的时间");
+    frameTime->record(quint64(frameClock.nsecsElapsed()));
+    stat.renderMs += frameClock.nsecsElapsed() / 1e6;
+    Frame frame;
+    frame.index = index;
+    frame.image = reply->image();
+
+    // 先提交下一帧，再把本帧交给编码线程：渲染线程绘制下一帧的同时编码线程处理本帧
+    const int frameCount = path.size() / 4;
+    if (index + 1 < frameCount) {
+        requestFrame(index + 1);
+    }
+    if (!queue->push(std::move(frame))) {
+        finish(false);
+        return;
+    }
+    ++stat.frames;
+    emit progress(stat.frames, frameCount);
+    if (stat.frames == frameCount) {
+        finish(true);
+    }
+}
+
+void OffscreenRenderer::encodeFrames(double *encodeMs)
+{
+    QElapsedTimer timer;
+    Frame frame;
+    while (queue->pop(frame)) {
+        timer.start();
+        bool ok;
+        if (imageTemplate.isEmpty()) {
+            // 按行写出，跳过QImage每行末尾的对齐填充
+            const QImage rgb = frame.image.convertToFormat(QImage::Format_RGB888);
+            const qint64 lineBytes = qint64(rgb.width()) * 3;
+            ok = true;
+            for (int y = 0; y < rgb.height() && ok; ++y) {
+                ok = rawFile->write(reinterpret_cast<const char *>(rgb.constScanLine(y)), lineBytes) == lineBytes;
+            }
+        } else {
+            ok = frame.image.save(imageTemplate.arg(frame.index, 5, 10, QChar('0')), nullptr, opts.imageQuality);
+        }
+        *encodeMs += timer.nsecsElapsed() / 1e6;
+        if (!ok) {
+            // 渲染端下一次入队时失败并结束
+            writeFailed = 1;
+            queue->abort();
+            return;
+        }
+    }
+}
+
+void OffscreenRenderer::finish(bool ok)
+{
+    if (!running) {
+        return;
+    }
+    running = false;
+
+    // 正常结束时等待已入队的帧写完，取消时丢弃
+    if (ok) {
+        queue->close();
+    } else {
+        queue->abort();
+    }
+    for (QFuture<void> &encoder : encoders) {
+        encoder.waitForFinished();
+    }
+    encoders.clear();
+    for (const double ms : encoderMs) {
+        stat.encodeMs += ms;
+    }
+    if (rawFile) {
+        rawFile->flush();
+    }
+    stat.wallMs = wallClock.nsecsElapsed() / 1e6;
+
+    if (writeFailed.loadRelaxed()) {
+        ok = false;
+        error = imageTemplate.isEmpty() ? QString("写入视频文件失败：%1").arg(opts.output)
+                                        : QString("写入图像失败：%1").arg(imageTemplate.arg("*"));
+    } else if (canceled) {
+        error = "已取消";
+    }
+    emit finished(ok);
+}
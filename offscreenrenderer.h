@@ -0,0 +1,104 @@
+#ifndef OFFSCREENRENDERER_H
+#define OFFSCREENRENDERER_H
+
+#include "boundedqueue.h"
+
+#include <QAtomicInt>
+#include <QColor>
+#include <QElapsedTimer>
+#include <QFuture>
+#include <QImage>
+#include <QObject>
+#include <QSize>
+#include <QString>
+#include <QVector>
+
+class ArmScene;
+class QFile;
+class QOffscreenSurface;
+namespace Qt3DCore { class QAspectEngine; class QEntity; }
+namespace Qt3DRender { class QCamera; class QRenderCapture; class QRenderCaptureReply; }
+
+// 离线渲染：不创建窗口，把机械臂场景（与界面相同的ArmScene）按固定分辨率和帧率渲染到纹理并读回，
+// 输出为图像序列或原始视频（RGB24逐帧连续存储，可直接交给ffmpeg编码）。
+// 两级流水线：GUI线程更新场景并请求下一帧的同时，上一帧图像在编码线程中转换、压缩和写盘；
+// 两级之间用有界队列连接，编码跟不上时渲染等待，内存占用与帧数无关
+class OffscreenRenderer : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Options
+    {
+        QSize size = QSize(1280, 720);
+        QColor background = Qt::white; // 与Qt3DWindow默认清屏颜色一致
+        // 输出：以.rgb/.raw结尾或为"-"（标准输出）时写原始视频；
+        // 以图像后缀（.png/.jpg/.bmp）结尾时作为文件名模板，例如out/frame.png写为out/frame_00000.png……；
+        // 其他情况视为目录，写为目录下的frame_00000.png……
+        QString output;
+        int imageQuality = -1;         // QImage::save的质量参数，-1为格式默认值
+    };
+
+    struct Stats
+    {
+        int frames = 0;
+        double wallMs = 0;     // 从开始到最后一帧写完
+        double renderMs = 0;   // 各帧从请求到读回完成的时间之和
+        double encodeMs = 0;   // 各编码线程转换和写盘的时间之和
+    };
+
+    explicit OffscreenRenderer(QObject *parent = nullptr);
+    ~OffscreenRenderer();
+
+    // frames按每4个关节角连续存储，每组为一帧；需在GUI线程调用，渲染在事件循环中进行，结束时发出finished
+    bool start(const QVector<double> &frames, const Options &options);
+    void cancel();
+
+    bool isRunning() const { return running; }
+    const Stats &stats() const { return stat; }
+    QString errorString() const { return error; }
+
+signals:
+    void progress(int framesDone, int frameCount);
+    void finished(bool ok);
+
+private:
+    struct Frame
+    {
+        int index = 0;
+        QImage image;
+    };
+
+    bool openOutput();
+    void createScene();
+    void destroyScene();
+    void requestFrame(int index);
+    void onFrameCaptured(Qt3DRender::QRenderCaptureReply *reply, int index);
+    void encodeFrames(double *encodeMs);
+    void finish(bool ok);
+
+    Options opts;
+    QVector<double> path;
+    QString imageTemplate;      // 图像序列的文件名模板（QString::arg，帧号补零到5位），为空时写原始视频
+    QFile *rawFile;
+    QOffscreenSurface *surface;
+    Qt3DCore::QAspectEngine *engine;
+    Qt3DCore::QEntity *rootEntity;
+    Qt3DRender::QCamera *camera;
+    Qt3DRender::QRenderCapture *capture;
+    ArmScene *scene;
+    QSize sceneSize;
+
+    BoundedQueue<Frame> *queue;
+    QVector<QFuture<void>> encoders;
+    QVector<double> encoderMs;  // 每个编码线程一个，结束后求和
+    QElapsedTimer wallClock;
+    QElapsedTimer frameClock;
+    Stats stat;
+    QString error;
+    QAtomicInt writeFailed;     // 编码线程写盘失败
+    bool running;
+    bool canceled;
+};
+
+#endif // OFFSCREENRENDERER_H
@@ -0,0 +1,98 @@
+#include "renderscheduler.h"
+#include "metrics.h"
+#include <Qt3DRender/QRenderSettings>
+#ifdef Q_OS_WIN
+#include <windows.h>
+#else
+#include <sys/resource.h>
+#endif
+
+// 进程所有线程累计的CPU时间（秒）。
+// 不用std::clock()：Windows的C运行库中它返回的是经过的墙钟时间，空闲时也会显示满载
+static double processCpuSeconds()
+{
+#ifdef Q_OS_WIN
+    FILETIME creation, exit, kernel, user;
+    if (!GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user)) {
+        return 0;
+    }
+    // FILETIME以100纳秒为单位
+    auto seconds = [](const FILETIME &t) { return double((quint64(t.dwHighDateTime) << 32) | t.dwLowDateTime) * 1e-7; };
+    return seconds(kernel) + seconds(user);
+#else
+    rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+    return double(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) * 1e-6;
+#endif
+}
+
+RenderScheduler::RenderScheduler(Qt3DRender::QRenderSettings *settings, QObject *parent)
+    : QObject(parent)
+    , posePending(false)
+    , frameIntervalMs(16)
+    , posesInPeriod(0)
+    , cpuAtPeriodStart(processCpuSeconds())
+{
+    // 默认的Always策略会持续绘制，空闲时也占满一个渲染线程
+    if (settings) {
+        settings->setRenderPolicy(Qt3DRender::QRenderSettings::OnDemand);
+    }
+
+    flushTimer.setSingleShot(true);
+    connect(&flushTimer, &QTimer::timeout, this, &RenderScheduler::flush);
+
+    statsTimer.setInterval(1000);
+    statsTimer.setTimerType(Qt::VeryCoarseTimer);
+    connect(&statsTimer, &QTimer::timeout, this, &RenderScheduler::reportStats);
+    statsTimer.start();
+    statsClock.start();
+}
+
+void RenderScheduler::setMaxFrameRate(int framesPerSecond)
+{
+    frameIntervalMs = 1000 / qBound(1, framesPerSecond, 1000);
+}
+
+void RenderScheduler::requestPose(const QVector<double> &angles)
+{
+    pendingPose = angles;
+    posePending = true;
+    if (flushTimer.isActive()) {
+        return;
+    }
+    // 距上一帧已超过帧间隔时立即应用，否则等到间隔结束
+    const qint64 elapsed = lastFrame.isValid() ? lastFrame.elapsed() : frameIntervalMs;
+    flushTimer.start(int(qMax<qint64>(0, frameIntervalMs - elapsed)));
+}
+
+void RenderScheduler::flush()
+{
+    if (!posePending) {
+        return;
+    }
+    posePending = false;
+    lastFrame.restart();
+    ++posesInPeriod;
+    // 信号直接连接到场景更新，计时即为每帧更新实体变换的耗时
+    static Metrics::Histogram *updateTime = Metrics::histogram("arm_render_pose_update_seconds", "三维视图每帧更新机械臂实体的耗时");
+    Metrics::ScopedTimer timer(updateTime);
+    emit poseReady(pendingPose);
+}
+
+void RenderScheduler::reportStats()
+{
+    const double seconds = statsClock.restart() / 1000.0;
+    const double cpu = processCpuSeconds();
+    const double cpuSeconds = cpu - cpuAtPeriodStart;
+    cpuAtPeriodStart = cpu;
+    if (seconds > 0) {
+        static Metrics::Gauge *poseRate = Metrics::gauge("arm_render_pose_updates_per_second", "三维视图最近一秒应用关节角的次数");
+        static Metrics::Gauge *cpuPercent = Metrics::gauge("arm_process_cpu_percent", "进程CPU时间占一个核的百分比（最近一秒）");
+        poseRate->set(posesInPeriod / seconds);
+        cpuPercent->set(100.0 * cpuSeconds / seconds);
+        emit statsUpdated(posesInPeriod / seconds, 100.0 * cpuSeconds / seconds);
+    }
+    posesInPeriod = 0;
+}
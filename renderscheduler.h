@@ -0,0 +1,51 @@
+#ifndef RENDERSCHEDULER_H
+#define RENDERSCHEDULER_H
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QTimer>
+#include <QVector>
+
+namespace Qt3DRender { class QRenderSettings; }
+
+// 按需渲染调度：Qt3D切换为OnDemand策略，只有场景变化时才绘制；
+// 连续到来的关节角在调度器中合并，按帧率上限只应用最新的一组，
+// 并每秒统计一次关节角的应用次数和进程CPU占用。
+// 相机和场景变化触发的重绘由Qt3D内部发起，调度器无从得知，因此统计的是位姿刷新率而非绘制帧率
+class RenderScheduler : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit RenderScheduler(Qt3DRender::QRenderSettings *settings, QObject *parent = nullptr);
+
+    void setMaxFrameRate(int framesPerSecond);
+    int maxFrameRate() const { return 1000 / frameIntervalMs; }
+
+    // 提交新的关节角，未应用的旧值被覆盖
+    void requestPose(const QVector<double> &angles);
+
+signals:
+    // 在帧率上限内应用关节角
+    void poseReady(const QVector<double> &angles);
+    // posesPerSecond为最近一秒应用关节角的次数；
+    // cpuPercent为整个进程（含渲染线程）的CPU时间（用户态+内核态）占一个核的百分比
+    void statsUpdated(double posesPerSecond, double cpuPercent);
+
+private slots:
+    void flush();
+    void reportStats();
+
+private:
+    QTimer flushTimer;
+    QTimer statsTimer;
+    QElapsedTimer lastFrame;
+    QElapsedTimer statsClock;
+    QVector<double> pendingPose;
+    bool posePending;
+    int frameIntervalMs;
+    int posesInPeriod;
+    double cpuAtPeriodStart; // 秒
+};
+
+#endif // RENDERSCHEDULER_H
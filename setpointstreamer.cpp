@@ -0,0 +1,181 @@
+#include "setpointstreamer.h"
+#include <QSharedMemory>
+#include <QThread>
+#include <QUdpSocket>
+#include <cstring>
+
+using namespace ControllerProtocol;
+
+SetpointStreamer::SetpointStreamer()
+    : udp(nullptr)
+    , sharedMemory(nullptr)
+{
+}
+
+SetpointStreamer::~SetpointStreamer()
+{
+    disconnect();
+}
+
+bool SetpointStreamer::connectTo(const Endpoint &endpoint)
+{
+    disconnect();
+    target = endpoint;
+
+    if (endpoint.transport == Endpoint::Udp) {
+        udp = new QUdpSocket;
+        // 绑定到临时端口，控制器按来源地址回传反馈
+        if (!udp->bind(QHostAddress::LocalHost, 0)) {
+            error = udp->errorString();
+            disconnect();
+            return false;
+        }
+        udp->setSocketOption(QAbstractSocket::ReceiveBufferSizeSocketOption, 1 << 20);
+        return true;
+    }
+
+    if (endpoint.transport == Endpoint::SharedMemory) {
+        sharedMemory = new QSharedMemory(endpoint.key);
+        if (!sharedMemory->attach()) {
+            error = QString("无法连接控制器共享内存：%1").arg(sharedMemory->errorString());
+            disconnect();
+            return false;
+        }
+        const SharedBlock *block = static_cast<const SharedBlock *>(sharedMemory->constData());
+        if (sharedMemory->size() < int(sizeof(SharedBlock)) || block->magic != SharedBlockMagic) {
+            error = "共享内存不是仿真控制器创建的";
+            disconnect();
+            return false;
+        }
+        return true;
+    }
+
+    error = "无效的端点，应为 udp:<端口> 或 shm:<名称>";
+    return false;
+}
+
+void SetpointStreamer::disconnect()
+{
+    delete udp;
+    udp = nullptr;
+    if (sharedMemory) {
+        sharedMemory->detach();
+        delete sharedMemory;
+        sharedMemory = nullptr;
+    }
+}
+
+bool SetpointStreamer::send(const Setpoint &setpoint)
+{
+    if (udp) {
+        return udp->writeDatagram(reinterpret_cast<const char *>(&setpoint), sizeof(setpoint),
+                                  QHostAddress::LocalHost, target.port) == qint64(sizeof(setpoint));
+    }
+    if (sharedMemory) {
+        return static_cast<SharedBlock *>(sharedMemory->data())->setpoints.push(setpoint);
+    }
+    return false;
+}
+
+int SetpointStreamer::drain(Report &report)
+{
+    int count = 0;
+    Feedback feedback;
+    const auto accept = [&]() {
+        if (feedback.magic != FeedbackMagic || feedback.status != Ok) {
+            return;
+        }
+        ++report.received;
+        if (feedback.saturatedMask) {
+            ++report.saturated;
+        }
+        if (feedback.sequence >= quint32(opts.warmupSamples)) {
+            report.latency.add((nowNs() - feedback.echoSendTimeNs) / 1000.0);
+        }
+        ++count;
+    };
+
+    if (udp) {
+        while (udp->hasPendingDatagrams()) {
+            if (udp->readDatagram(reinterpret_cast<char *>(&feedback), sizeof(feedback)) == qint64(sizeof(feedback))) {
+                accept();
+            }
+        }
+    } else if (sharedMemory) {
+        SharedBlock *block = static_cast<SharedBlock *>(sharedMemory->data());
+        while (block->feedback.pop(feedback)) {
+            accept();
+        }
+    }
+    return count;
+}
+
+bool SetpointStreamer::stream(const QVector<double> &path, Report &report)
+{
+    report = Report();
+    if (!udp && !sharedMemory) {
+        error = "尚未连接控制器";
+        return false;
+    }
+    const int total = path.size() / 4;
+    if (total == 0) {
+        error = "设定值序列为空";
+        return false;
+    }
+
+    const qint64 period = 1000000000LL / qBound(1, opts.rateHz, 100000);
+    const qint64 spin = qint64(opts.spinMicroseconds) * 1000;
+    const qint64 start = nowNs() + 1000000; // 留1 ms准备时间
+    drain(report);
+    report.received = 0;
+
+    Setpoint setpoint;
+    std::memset(&setpoint, 0, sizeof(setpoint));
+    setpoint.magic = SetpointMagic;
+
+    for (int k = 0; k < total; ++k) {
+        const qint64 deadline = start + k * period;
+
+        // 等待周期时刻：剩余时间较长时休眠，最后一段自旋，期间持续接收反馈
+        for (;;) {
+            drain(report);
+            const qint64 remaining = deadline - nowNs();
+            if (remaining <= 0) {
+                break;
+            }
+            if (remaining > spin) {
+                QThread::usleep(quint64((remaining - spin) / 1000));
+            }
+        }
+
+        const qint64 now = nowNs();
+        if (k >= opts.warmupSamples) {
+            report.jitter.add((now - deadline) / 1000.0);
+        }
+        if (now - deadline >= period) {
+            ++report.overruns;
+        }
+
+        setpoint.sequence = quint32(k);
+        setpoint.flags = k == total - 1 ? EndOfStream : 0;
+        setpoint.sendTimeNs = now;
+        std::memcpy(setpoint.q, path.constData() + 4 * k, sizeof(setpoint.q));
+        if (!send(setpoint)) {
+            // UDP发送缓冲满或共享内存环形缓冲满（控制器未在运行），计为丢失
+            continue;
+        }
+        ++report.sent;
+    }
+
+    // 等待剩余反馈
+    const qint64 drainDeadline = nowNs() + qint64(opts.drainTimeoutMs) * 1000000;
+    while (report.received < report.sent && nowNs() < drainDeadline) {
+        if (drain(report) == 0) {
+            QThread::usleep(50);
+        }
+    }
+
+    report.lost = quint64(total) - report.received;
+    report.durationSeconds = (nowNs() - start) / 1e9;
+    return true;
+}
@@ -0,0 +1,64 @@
+#ifndef SETPOINTSTREAMER_H
+#define SETPOINTSTREAMER_H
+
+#include "latencyhistogram.h"
+#include "simulatedcontroller.h"
+#include <QString>
+#include <QVector>
+
+class QSharedMemory;
+class QUdpSocket;
+
+// 按固定频率向控制器发送关节设定值并接收反馈，测量：
+//   发送抖动：实际发送时刻与理想周期时刻之差
+//   往返延迟：发送到收到对应反馈的时间
+// stream()在调用线程中阻塞运行，等待下一周期时先休眠再自旋，不依赖事件循环
+class SetpointStreamer
+{
+public:
+    struct Options
+    {
+        int rateHz = 1000;        // 发送频率，1-4 kHz
+        int warmupSamples = 200;  // 开头若干周期不计入直方图（缓存、页面首次访问等）
+        int drainTimeoutMs = 200; // 发送结束后等待剩余反馈的时间
+        int spinMicroseconds = 200; // 距周期时刻小于该值时改为自旋等待
+    };
+
+    struct Report
+    {
+        quint64 sent = 0;
+        quint64 received = 0;
+        quint64 lost = 0;         // 超时未收到反馈
+        quint64 saturated = 0;    // 控制器报告饱和的反馈数
+        quint64 overruns = 0;     // 发送时刻晚于下一周期时刻的次数
+        double durationSeconds = 0;
+        LatencyHistogram latency; // 往返延迟（微秒）
+        LatencyHistogram jitter;  // 发送时刻偏差（微秒）
+    };
+
+    SetpointStreamer();
+    ~SetpointStreamer();
+
+    bool connectTo(const ControllerProtocol::Endpoint &endpoint);
+    void disconnect();
+    QString errorString() const { return error; }
+
+    void setOptions(const Options &options) { opts = options; }
+    const Options &options() const { return opts; }
+
+    // path按每4个关节角连续存储，每个周期发送一组
+    bool stream(const QVector<double> &path, Report &report);
+
+private:
+    bool send(const ControllerProtocol::Setpoint &setpoint);
+    // 读取所有已到达的反馈，返回读取的数量
+    int drain(Report &report);
+
+    Options opts;
+    ControllerProtocol::Endpoint target;
+    QUdpSocket *udp;
+    QSharedMemory *sharedMemory;
+    QString error;
+};
+
+#endif // SETPOINTSTREAMER_H
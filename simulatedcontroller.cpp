@@ -0,0 +1,205 @@
+#include "simulatedcontroller.h"
+#include "armkinematics.h"
+#include <QNetworkDatagram>
+#include <QSharedMemory>
+#include <QThread>
+#include <QUdpSocket>
+#include <cstring>
+#include <new>
+
+namespace ControllerProtocol {
+
+Endpoint parseEndpoint(const QString &text)
+{
+    Endpoint endpoint;
+    if (text.startsWith("udp:")) {
+        bool ok = false;
+        const uint port = text.mid(4).toUInt(&ok);
+        if (ok && port > 0 && port <= 65535) {
+            endpoint.transport = Endpoint::Udp;
+            endpoint.port = quint16(port);
+        }
+    } else if (text.startsWith("shm:") && text.size() > 4) {
+        endpoint.transport = Endpoint::SharedMemory;
+        endpoint.key = text.mid(4);
+    }
+    return endpoint;
+}
+
+} // namespace ControllerProtocol
+
+using namespace ControllerProtocol;
+
+SimulatedController::SimulatedController(QObject *parent)
+    : QObject(parent)
+    , udp(nullptr)
+    , sharedMemory(nullptr)
+    , pollThread(nullptr)
+    , stopping(0)
+    , expectedSequence(0)
+    , streamStarted(false)
+{
+}
+
+SimulatedController::~SimulatedController()
+{
+    close();
+}
+
+bool SimulatedController::listen(const Endpoint &endpoint)
+{
+    close();
+    expectedSequence = 0;
+    streamStarted = false;
+
+    if (endpoint.transport == Endpoint::Udp) {
+        udp = new QUdpSocket(this);
+        if (!udp->bind(QHostAddress::LocalHost, endpoint.port)) {
+            error = udp->errorString();
+            close();
+            return false;
+        }
+        // 加大接收缓冲，避免4 kHz下事件循环偶发停顿时丢包
+        udp->setSocketOption(QAbstractSocket::ReceiveBufferSizeSocketOption, 1 << 20);
+        connect(udp, &QUdpSocket::readyRead, this, &SimulatedController::onUdpReadyRead);
+        return true;
+    }
+
+    if (endpoint.transport == Endpoint::SharedMemory) {
+        sharedMemory = new QSharedMemory(endpoint.key, this);
+        if (!sharedMemory->create(sizeof(SharedBlock))) {
+            // 上次异常退出可能残留同名段：附加后分离以释放，再重新创建
+            if (sharedMemory->error() == QSharedMemory::AlreadyExists && sharedMemory->attach()) {
+                sharedMemory->detach();
+            }
+            if (!sharedMemory->create(sizeof(SharedBlock))) {
+                error = sharedMemory->errorString();
+                close();
+                return false;
+            }
+        }
+        std::memset(sharedMemory->data(), 0, sizeof(SharedBlock));
+        SharedBlock *block = new (sharedMemory->data()) SharedBlock;
+        block->magic = SharedBlockMagic;
+
+        stopping.storeRelaxed(0);
+        pollThread = QThread::create([this]() { pollSharedMemory(); });
+        pollThread->start(QThread::TimeCriticalPriority);
+        return true;
+    }
+
+    error = "无效的端点，应为 udp:<端口> 或 shm:<名称>";
+    return false;
+}
+
+void SimulatedController::close()
+{
+    if (pollThread) {
+        stopping.storeRelease(1);
+        pollThread->wait();
+        delete pollThread;
+        pollThread = nullptr;
+    }
+    if (sharedMemory) {
+        sharedMemory->detach();
+        delete sharedMemory;
+        sharedMemory = nullptr;
+    }
+    if (udp) {
+        udp->close();
+        delete udp;
+        udp = nullptr;
+    }
+}
+
+SimulatedController::Stats SimulatedController::takeStats()
+{
+    Stats stats;
+    stats.received = received.fetchAndStoreRelaxed(0);
+    stats.lost = lost.fetchAndStoreRelaxed(0);
+    stats.reordered = reordered.fetchAndStoreRelaxed(0);
+    stats.saturated = saturated.fetchAndStoreRelaxed(0);
+    stats.badPackets = badPackets.fetchAndStoreRelaxed(0);
+    return stats;
+}
+
+Feedback SimulatedController::process(const Setpoint &setpoint)
+{
+    Feedback feedback;
+    feedback.magic = FeedbackMagic;
+    feedback.sequence = setpoint.sequence;
+    feedback.status = setpoint.magic == SetpointMagic ? Ok : BadPacket;
+    feedback.saturatedMask = 0;
+    feedback.echoSendTimeNs = setpoint.sendTimeNs;
+    for (int j = 0; j < 4; ++j) {
+        // 与mymodikine相同的限位表，超限时饱和到边界
+        double q = setpoint.q[j];
+        if (!(q >= ArmKinematics::jointMin[j])) {
+            q = ArmKinematics::jointMin[j];
+            feedback.saturatedMask |= 1u << j;
+        } else if (q > ArmKinematics::jointMax[j]) {
+            q = ArmKinematics::jointMax[j];
+            feedback.saturatedMask |= 1u << j;
+        }
+        feedback.q[j] = q;
+    }
+    feedback.controllerTimeNs = nowNs();
+    return feedback;
+}
+
+void SimulatedController::record(const Setpoint &setpoint, const Feedback &feedback)
+{
+    if (feedback.status != Ok) {
+        badPackets.fetchAndAddRelaxed(1);
+        return;
+    }
+    received.fetchAndAddRelaxed(1);
+    if (feedback.saturatedMask) {
+        saturated.fetchAndAddRelaxed(1);
+    }
+
+    // 序号统计：新的流从任意序号开始
+    if (!streamStarted || setpoint.sequence == expectedSequence) {
+        expectedSequence = setpoint.sequence + 1;
+    } else if (qint32(setpoint.sequence - expectedSequence) > 0) {
+        lost.fetchAndAddRelaxed(setpoint.sequence - expectedSequence);
+        expectedSequence = setpoint.sequence + 1;
+    } else {
+        reordered.fetchAndAddRelaxed(1);
+    }
+    streamStarted = !(setpoint.flags & EndOfStream);
+}
+
+void SimulatedController::onUdpReadyRead()
+{
+    while (udp->hasPendingDatagrams()) {
+        const QNetworkDatagram datagram = udp->receiveDatagram(sizeof(Setpoint));
+        const QByteArray data = datagram.data();
+        if (data.size() != int(sizeof(Setpoint))) {
+            badPackets.fetchAndAddRelaxed(1);
+            continue;
+        }
+        Setpoint setpoint;
+        std::memcpy(&setpoint, data.constData(), sizeof(setpoint));
+        const Feedback feedback = process(setpoint);
+        udp->writeDatagram(reinterpret_cast<const char *>(&feedback), sizeof(feedback),
+                           datagram.senderAddress(), quint16(datagram.senderPort()));
+        record(setpoint, feedback);
+    }
+}
+
+void SimulatedController::pollSharedMemory()
+{
+    SharedBlock *block = static_cast<SharedBlock *>(sharedMemory->data());
+    Setpoint setpoint;
+    while (!stopping.loadAcquire()) {
+        if (!block->setpoints.pop(setpoint)) {
+            QThread::yieldCurrentThread();
+            continue;
+        }
+        const Feedback feedback = process(setpoint);
+        // 客户端停止读取时反馈缓冲会满，此时丢弃反馈而不阻塞
+        block->feedback.push(feedback);
+        record(setpoint, feedback);
+    }
+}
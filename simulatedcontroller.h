@@ -0,0 +1,164 @@
+#ifndef SIMULATEDCONTROLLER_H
+#define SIMULATEDCONTROLLER_H
+
+#include <QAtomicInteger>
+#include <QDeadlineTimer>
+#include <QObject>
+#include <QString>
+
+class QSharedMemory;
+class QThread;
+class QUdpSocket;
+
+// 仿真控制器的设定值/反馈协议（本机字节序，只用于本机回环）
+// UDP：每个数据报为一个Setpoint或Feedback
+// 共享内存：控制器创建SharedBlock，内含两个单生产者单消费者环形缓冲，双方轮询
+namespace ControllerProtocol {
+
+const quint32 SetpointMagic = 0x53505431; // "SPT1"
+const quint32 FeedbackMagic = 0x46424b31; // "FBK1"
+const quint32 SharedBlockMagic = 0x53484d31; // "SHM1"
+
+enum SetpointFlags : quint32 {
+    EndOfStream = 0x1 // 本次流结束，控制器重置序号统计
+};
+
+enum FeedbackStatus : quint32 {
+    Ok = 0,
+    BadPacket = 1
+};
+
+struct Setpoint
+{
+    quint32 magic;
+    quint32 sequence;
+    quint32 flags;
+    quint32 reserved;
+    qint64 sendTimeNs; // 发送时刻（单调时钟，见nowNs）
+    double q[4];       // 关节角设定值
+};
+
+struct Feedback
+{
+    quint32 magic;
+    quint32 sequence;      // 对应的设定值序号
+    quint32 status;
+    quint32 saturatedMask; // 第j位：关节j的设定值超出限位被饱和
+    qint64 echoSendTimeNs; // 原样返回设定值的发送时刻，客户端据此计算往返延迟
+    qint64 controllerTimeNs;
+    double q[4];           // 饱和后的关节角
+};
+
+// 单生产者单消费者环形缓冲，head/tail放在不同缓存行避免伪共享
+template <typename T>
+struct Ring
+{
+    enum { Capacity = 1024 };
+    alignas(64) QAtomicInteger<quint32> head;
+    alignas(64) QAtomicInteger<quint32> tail;
+    alignas(64) T slots[Capacity];
+
+    bool push(const T &value)
+    {
+        const quint32 h = head.loadRelaxed();
+        if (h - tail.loadAcquire() >= Capacity) {
+            return false;
+        }
+        slots[h % Capacity] = value;
+        head.storeRelease(h + 1);
+        return true;
+    }
+
+    bool pop(T &value)
+    {
+        const quint32 t = tail.loadRelaxed();
+        if (t == head.loadAcquire()) {
+            return false;
+        }
+        value = slots[t % Capacity];
+        tail.storeRelease(t + 1);
+        return true;
+    }
+};
+
+struct SharedBlock
+{
+    quint32 magic;
+    quint32 reserved;
+    Ring<Setpoint> setpoints;
+    Ring<Feedback> feedback;
+};
+
+// 同一台机器上各进程可比较的单调时钟（纳秒）
+inline qint64 nowNs()
+{
+    return QDeadlineTimer::current(Qt::PreciseTimer).deadlineNSecs();
+}
+
+// 端点格式：udp:<端口>（127.0.0.1）或 shm:<共享内存key>
+struct Endpoint
+{
+    enum Transport { Invalid, Udp, SharedMemory } transport = Invalid;
+    quint16 port = 0;
+    QString key;
+};
+Endpoint parseEndpoint(const QString &text);
+
+} // namespace ControllerProtocol
+
+// 无硬件的仿真控制器：接收关节设定值，按mymodikine的限位表饱和后立即回传状态，
+// 并统计丢包、乱序和饱和次数。UDP在所属线程的事件循环中处理，
+// 共享内存由独立线程忙轮询（会占满一个核，以接近实时控制器的响应方式）
+class SimulatedController : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Stats
+    {
+        quint64 received = 0;
+        quint64 lost = 0;       // 序号跳过的设定值数
+        quint64 reordered = 0;  // 序号回退的设定值数
+        quint64 saturated = 0;  // 至少一个关节被饱和的设定值数
+        quint64 badPackets = 0;
+    };
+
+    explicit SimulatedController(QObject *parent = nullptr);
+    ~SimulatedController() override;
+
+    bool listen(const ControllerProtocol::Endpoint &endpoint);
+    void close();
+    QString errorString() const { return error; }
+
+    // 返回自上次调用以来的统计并清零
+    Stats takeStats();
+
+    // 按限位表饱和，线程安全
+    static ControllerProtocol::Feedback process(const ControllerProtocol::Setpoint &setpoint);
+
+private slots:
+    void onUdpReadyRead();
+
+private:
+    void record(const ControllerProtocol::Setpoint &setpoint, const ControllerProtocol::Feedback &feedback);
+    void pollSharedMemory();
+
+    QUdpSocket *udp;
+    QSharedMemory *sharedMemory;
+    QThread *pollThread;
+    QAtomicInteger<int> stopping;
+    QString error;
+
+    // 只在处理线程中访问
+    quint32 expectedSequence;
+    bool streamStarted;
+
+    // 处理线程写入，takeStats读取并清零
+    QAtomicInteger<quint64> received;
+    QAtomicInteger<quint64> lost;
+    QAtomicInteger<quint64> reordered;
+    QAtomicInteger<quint64> saturated;
+    QAtomicInteger<quint64> badPackets;
+};
+
+#endif // SIMULATEDCONTROLLER_H
@@ -0,0 +1,67 @@
+#include "startupprofiler.h"
+#include <QElapsedTimer>
+#include <QVector>
+#include <QtGlobal>
+#include <cstdio>
+#include <cstring>
+
+namespace
+{
+
+struct Stage
+{
+    const char *name;
+    qint64 nanoseconds;
+};
+
+QElapsedTimer startupClock;
+QVector<Stage> stages;
+bool reportEnabled = false;
+
+} // namespace
+
+namespace StartupProfiler
+{
+
+void start(int argc, char *argv[])
+{
+    startupClock.start();
+    stages.clear();
+    stages.reserve(16);
+    reportEnabled = qEnvironmentVariableIsSet("ARM_STARTUP_REPORT");
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--startup-report") == 0) {
+            reportEnabled = true;
+        }
+    }
+}
+
+void mark(const char *stage)
+{
+    // 只在GUI线程的启动阶段调用，无需加锁
+    if (startupClock.isValid()) {
+        stages.append({stage, startupClock.nsecsElapsed()});
+    }
+}
+
+bool enabled()
+{
+    return reportEnabled;
+}
+
+void report()
+{
+    if (!reportEnabled || stages.isEmpty()) {
+        return;
+    }
+    std::fprintf(stderr, "启动耗时：\n");
+    qint64 previous = 0;
+    for (const Stage &s : stages) {
+        std::fprintf(stderr, "  %-24s %9.2f ms  (+%.2f ms)\n", s.name, s.nanoseconds / 1e6,
+                     (s.nanoseconds - previous) / 1e6);
+        previous = s.nanoseconds;
+    }
+    std::fflush(stderr);
+}
+
+} // namespace StartupProfiler
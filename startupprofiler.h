@@ -0,0 +1,19 @@
+#ifndef STARTUPPROFILER_H
+#define STARTUPPROFILER_H
+
+#include <QString>
+
+// 启动耗时统计：main()开头调用start()，之后在各阶段调用mark()记录距启动的时间；
+// 命令行带 --startup-report 或设置环境变量 ARM_STARTUP_REPORT 时，
+// report()把各阶段耗时输出到标准错误
+namespace StartupProfiler
+{
+
+void start(int argc, char *argv[]);
+void mark(const char *stage);
+bool enabled();
+void report();
+
+} // namespace StartupProfiler
+
+#endif // STARTUPPROFILER_H
@@ -0,0 +1,418 @@
+#include "sweptvolume.h"
+#include "collisionchecker.h"
+#include <QElapsedTimer>
+#include <QFile>
+#include <QHash>
+#include <QThread>
+#include <QtConcurrent>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+const int kIndexBits = 21;
+const int kIndexOffset = 1 << (kIndexBits - 1);
+const quint64 kIndexMask = (quint64(1) << kIndexBits) - 1;
+// 每个间隙计算任务的采样点数
+const int kClearanceTask = 1024;
+
+// 体素的6个面：相邻体素方向和4个角点（相对体素最小角的偏移），从外侧看为逆时针
+struct Face
+{
+    int neighbor[3];
+    int corners[4][3];
+};
+
+const Face kFaces[6] = {
+    {{1, 0, 0}, {{1, 0, 0}, {1, 1, 0}, {1, 1, 1}, {1, 0, 1}}},
+    {{-1, 0, 0}, {{0, 0, 0}, {0, 0, 1}, {0, 1, 1}, {0, 1, 0}}},
+    {{0, 1, 0}, {{0, 1, 0}, {0, 1, 1}, {1, 1, 1}, {1, 1, 0}}},
+    {{0, -1, 0}, {{0, 0, 0}, {1, 0, 0}, {1, 0, 1}, {0, 0, 1}}},
+    {{0, 0, 1}, {{0, 0, 1}, {1, 0, 1}, {1, 1, 1}, {0, 1, 1}}},
+    {{0, 0, -1}, {{0, 0, 0}, {0, 1, 0}, {1, 1, 0}, {1, 0, 0}}},
+};
+
+// 竖直线(x, y, z)与胶囊体（线段a-b、半径平方radiusSq）的交集：胶囊体是凸的，交集是一段区间[z0, z1]，
+// 为两端球体与圆柱段各自区间的并。返回false表示不相交
+bool columnInterval(double x, double y, const double a[3], const double b[3], double radiusSq, double &z0, double &z1)
+{
+    z0 = std::numeric_limits<double>::infinity();
+    z1 = -std::numeric_limits<double>::infinity();
+    const auto add = [&](double lo, double hi) {
+        if (lo <= hi) {
+            z0 = std::min(z0, lo);
+            z1 = std::max(z1, hi);
+        }
+    };
+    for (const double *p : {a, b}) {
+        const double h = radiusSq - (x - p[0]) * (x - p[0]) - (y - p[1]) * (y - p[1]);
+        if (h >= 0) {
+            const double s = std::sqrt(h);
+            add(p[2] - s, p[2] + s);
+        }
+    }
+
+    // 圆柱段：设u = z - a.z，垂直距离平方不超过半径平方为u的二次不等式，线段参数t在[0, 1]内为u的线性约束
+    const double d[3] = {b[0] - a[0], b[1] - a[1], b[2] - a[2]};
+    const double len2 = d[0] * d[0] + d[1] * d[1] + d[2] * d[2];
+    if (len2 <= 0) {
+        return z0 <= z1;
+    }
+    const double wx = x - a[0], wy = y - a[1];
+    const double h = wx * wx + wy * wy;
+    const double m = wx * d[0] + wy * d[1];
+    const double qa = d[0] * d[0] + d[1] * d[1];
+    const double qc = len2 * (h - radiusSq) - m * m;
+    double lo = -std::numeric_limits<double>::infinity(), hi = std::numeric_limits<double>::infinity();
+    if (qa > 1e-12 * len2) {
+        const double disc = m * m * d[2] * d[2] - qa * qc;
+        if (disc < 0) {
+            return z0 <= z1;
+        }
+        const double s = std::sqrt(disc);
+        lo = (m * d[2] - s) / qa;
+        hi = (m * d[2] + s) / qa;
+    } else if (qc > 0) {
+        // 竖直线段：距离与高度无关
+        return z0 <= z1;
+    }
+    if (std::fabs(d[2]) > 1e-12) {
+        const double t0 = -m / d[2], t1 = (len2 - m) / d[2];
+        lo = std::max(lo, std::min(t0, t1));
+        hi = std::min(hi, std::max(t0, t1));
+    } else if (m < 0 || m > len2) {
+        return z0 <= z1;
+    }
+    add(a[2] + lo, a[2] + hi);
+    return z0 <= z1;
+}
+
+// 两组胶囊体端点的最大位移
+double maxDisplacement(const CollisionChecker::Capsule *a, const CollisionChecker::Capsule *b)
+{
+    double best = 0;
+    for (int c = 0; c < CollisionChecker::ArmCapsuleCount; ++c) {
+        double d0 = 0, d1 = 0;
+        for (int k = 0; k < 3; ++k) {
+            d0 += (a[c].p0[k] - b[c].p0[k]) * (a[c].p0[k] - b[c].p0[k]);
+            d1 += (a[c].p1[k] - b[c].p1[k]) * (a[c].p1[k] - b[c].p1[k]);
+        }
+        best = std::max(best, std::max(d0, d1));
+    }
+    return std::sqrt(best);
+}
+
+} // namespace
+
+SweptVolume::SweptVolume(const CollisionChecker &checker)
+    : checker(checker)
+{
+}
+
+quint64 SweptVolume::voxelKey(int x, int y, int z)
+{
+    return (quint64(x + kIndexOffset) & kIndexMask)
+           | ((quint64(y + kIndexOffset) & kIndexMask) << kIndexBits)
+           | ((quint64(z + kIndexOffset) & kIndexMask) << (2 * kIndexBits));
+}
+
+void SweptVolume::voxelIndex(quint64 key, int &x, int &y, int &z)
+{
+    x = int(key & kIndexMask) - kIndexOffset;
+    y = int((key >> kIndexBits) & kIndexMask) - kIndexOffset;
+    z = int((key >> (2 * kIndexBits)) & kIndexMask) - kIndexOffset;
+}
+
+void SweptVolume::buildKeyConfigurations(const double *path, int count, QVector<double> &keys) const
+{
+    const double maxStep = std::max(opts.tolerance, 0.01) * opts.voxelSize;
+    typedef CollisionChecker::Capsule Capsules[CollisionChecker::ArmCapsuleCount];
+
+    keys.clear();
+    Capsules keyCapsules, current, previous;
+    const double *keyQ = path;
+    keys.append(path[0]);
+    keys.append(path[1]);
+    keys.append(path[2]);
+    keys.append(path[3]);
+    checker.armCapsules(path, keyCapsules);
+
+    bool previousIsKey = true;
+    for (int i = 1; i < count; ++i) {
+        const double *q = path + 4 * i;
+        checker.armCapsules(q, current);
+        double displacement = maxDisplacement(keyCapsules, current);
+        if (displacement <= maxStep) {
+            // 与上一关键构型足够接近，暂不栅格化
+            std::copy(&current[0], &current[0] + CollisionChecker::ArmCapsuleCount, &previous[0]);
+            previousIsKey = false;
+            if (i == count - 1) {
+                keys.append(q[0]);
+                keys.append(q[1]);
+                keys.append(q[2]);
+                keys.append(q[3]);
+            }
+            continue;
+        }
+
+        // 上一采样点与关键构型的距离在容差内，先把它作为关键构型，再从它出发细分
+        if (!previousIsKey) {
+            keyQ = q - 4;
+            std::copy(&previous[0], &previous[0] + CollisionChecker::ArmCapsuleCount, &keyCapsules[0]);
+            keys.append(keyQ[0]);
+            keys.append(keyQ[1]);
+            keys.append(keyQ[2]);
+            keys.append(keyQ[3]);
+            displacement = maxDisplacement(keyCapsules, current);
+        }
+        const int steps = std::max(1, int(std::ceil(displacement / maxStep)));
+        for (int s = 1; s <= steps; ++s) {
+            const double t = double(s) / steps;
+            for (int j = 0; j < 4; ++j) {
+                keys.append(keyQ[j] + t * (q[j] - keyQ[j]));
+            }
+        }
+        keyQ = q;
+        std::copy(&current[0], &current[0] + CollisionChecker::ArmCapsuleCount, &keyCapsules[0]);
+        previousIsKey = true;
+    }
+}
+
+void SweptVolume::rasterize(const double *q, const double *previousQ, QSet<quint64> &cells) const
+{
+    CollisionChecker::Capsule capsules[CollisionChecker::ArmCapsuleCount];
+    CollisionChecker::Capsule previous[CollisionChecker::ArmCapsuleCount];
+    checker.armCapsules(q, capsules);
+    if (previousQ) {
+        checker.armCapsules(previousQ, previous);
+    }
+    const double size = opts.voxelSize;
+    const double grow = std::max(opts.tolerance, 0.01) * size;
+
+    for (int c = 0; c < CollisionChecker::ArmCapsuleCount; ++c) {
+        const CollisionChecker::Capsule &capsule = capsules[c];
+        const double radius = capsule.radius + grow;
+        const double radiusSq = radius * radius;
+        int lo[2], hi[2];
+        for (int k = 0; k < 2; ++k) {
+            lo[k] = int(std::floor((std::min(capsule.p0[k], capsule.p1[k]) - radius) / size));
+            hi[k] = int(std::floor((std::max(capsule.p0[k], capsule.p1[k]) + radius) / size));
+        }
+        for (int x = lo[0]; x <= hi[0]; ++x) {
+            const double cx = (x + 0.5) * size;
+            for (int y = lo[1]; y <= hi[1]; ++y) {
+                const double cy = (y + 0.5) * size;
+                // 体素中心落在区间内的体素被占据
+                double z0, z1;
+                if (!columnInterval(cx, cy, capsule.p0, capsule.p1, radiusSq, z0, z1)) {
+                    continue;
+                }
+                const int first = int(std::ceil(z0 / size - 0.5));
+                const int last = int(std::floor(z1 / size - 0.5));
+                // 上一关键构型的同一胶囊体覆盖的体素已在集合中，跳过哈希插入
+                int skipFirst = 1, skipLast = 0;
+                if (previousQ && columnInterval(cx, cy, previous[c].p0, previous[c].p1, radiusSq, z0, z1)) {
+                    skipFirst = int(std::ceil(z0 / size - 0.5));
+                    skipLast = int(std::floor(z1 / size - 0.5));
+                }
+                for (int z = first; z <= last; ++z) {
+                    if (z >= skipFirst && z <= skipLast) {
+                        z = skipLast;
+                        continue;
+                    }
+                    cells.insert(voxelKey(x, y, z));
+                }
+            }
+        }
+    }
+}
+
+bool SweptVolume::compute(const double *path, int count, const std::function<bool()> &canceled)
+{
+    res = Result();
+    occupied.clear();
+    error.clear();
+    if (!path || count <= 0) {
+        error = "路径为空";
+        return false;
+    }
+    if (!(opts.voxelSize > 0)) {
+        error = "体素边长必须大于0";
+        return false;
+    }
+    res.samples = count;
+
+    QElapsedTimer timer;
+    timer.start();
+    QVector<double> keys;
+    buildKeyConfigurations(path, count, keys);
+    const int keyCount = keys.size() / 4;
+    res.keyConfigurations = keyCount;
+
+    // 任务数为线程数的几倍：每个任务的集合合并前彼此大量重叠，任务过多会放大合并的开销
+    const int taskCount = std::max(1, std::min((keyCount + 15) / 16, 4 * QThread::idealThreadCount()));
+    QVector<QSet<quint64>> partial(taskCount);
+    QVector<int> tasks(taskCount);
+    for (int t = 0; t < taskCount; ++t) {
+        tasks[t] = t;
+    }
+    QtConcurrent::blockingMap(tasks, [&](int t) {
+        const int first = int(qint64(keyCount) * t / taskCount);
+        const int last = int(qint64(keyCount) * (t + 1) / taskCount);
+        for (int k = first; k < last; ++k) {
+            if ((k & 63) == 0 && canceled && canceled()) {
+                return;
+            }
+            // 每个任务的第一个关键构型没有上一构型可借用
+            rasterize(keys.constData() + 4 * k, k > first ? keys.constData() + 4 * (k - 1) : nullptr, partial[t]);
+        }
+    });
+    if (canceled && canceled()) {
+        error = "已取消";
+        return false;
+    }
+
+    // 以最大的集合为基础合并，其余集合合并后立即释放
+    int largest = 0;
+    for (int t = 1; t < taskCount; ++t) {
+        if (partial[t].size() > partial[largest].size()) {
+            largest = t;
+        }
+    }
+    occupied = std::move(partial[largest]);
+    for (int t = 0; t < taskCount; ++t) {
+        if (t != largest) {
+            occupied.unite(partial[t]);
+            partial[t] = QSet<quint64>();
+        }
+    }
+
+    res.voxelCount = occupied.size();
+    res.volume = res.voxelCount * opts.voxelSize * opts.voxelSize * opts.voxelSize;
+    int lo[3] = {std::numeric_limits<int>::max(), std::numeric_limits<int>::max(), std::numeric_limits<int>::max()};
+    int hi[3] = {std::numeric_limits<int>::min(), std::numeric_limits<int>::min(), std::numeric_limits<int>::min()};
+    for (const quint64 key : occupied) {
+        int v[3];
+        voxelIndex(key, v[0], v[1], v[2]);
+        for (int k = 0; k < 3; ++k) {
+            lo[k] = std::min(lo[k], v[k]);
+            hi[k] = std::max(hi[k], v[k]);
+        }
+    }
+    if (!occupied.isEmpty()) {
+        for (int k = 0; k < 3; ++k) {
+            res.boundsMin[k] = lo[k] * opts.voxelSize;
+            res.boundsMax[k] = (hi[k] + 1) * opts.voxelSize;
+        }
+    }
+    res.rasterMs = timer.nsecsElapsed() / 1e6;
+
+    // 与环境的最小距离：按采样点分块并行，每块记录自己的最小值
+    timer.restart();
+    const int blockCount = (count + kClearanceTask - 1) / kClearanceTask;
+    QVector<double> blockMin(blockCount, std::numeric_limits<double>::infinity());
+    QVector<int> blockArg(blockCount, -1);
+    tasks.resize(blockCount);
+    for (int b = 0; b < blockCount; ++b) {
+        tasks[b] = b;
+    }
+    QtConcurrent::blockingMap(tasks, [&](int b) {
+        const int last = std::min(count, (b + 1) * kClearanceTask);
+        for (int i = b * kClearanceTask; i < last; ++i) {
+            const double d = checker.environmentMinDistance(path + 4 * i);
+            if (d < blockMin[b]) {
+                blockMin[b] = d;
+                blockArg[b] = i;
+            }
+        }
+    });
+    res.minClearance = std::numeric_limits<double>::infinity();
+    for (int b = 0; b < blockCount; ++b) {
+        if (blockMin[b] < res.minClearance) {
+            res.minClearance = blockMin[b];
+            res.minClearanceSample = blockArg[b];
+        }
+    }
+    res.clearanceMs = timer.nsecsElapsed() / 1e6;
+    return true;
+}
+
+void SweptVolume::surfaceMesh(QVector<float> &vertices, QVector<quint32> &indices) const
+{
+    vertices.clear();
+    indices.clear();
+    QHash<quint64, quint32> cornerIndex;
+    const double size = opts.voxelSize;
+
+    for (const quint64 key : occupied) {
+        int v[3];
+        voxelIndex(key, v[0], v[1], v[2]);
+        for (const Face &face : kFaces) {
+            if (occupied.contains(voxelKey(v[0] + face.neighbor[0], v[1] + face.neighbor[1], v[2] + face.neighbor[2]))) {
+                continue;
+            }
+            quint32 corner[4];
+            for (int c = 0; c < 4; ++c) {
+                const int x = v[0] + face.corners[c][0];
+                const int y = v[1] + face.corners[c][1];
+                const int z = v[2] + face.corners[c][2];
+                const quint64 cornerKey = voxelKey(x, y, z);
+                auto it = cornerIndex.constFind(cornerKey);
+                if (it == cornerIndex.constEnd()) {
+                    it = cornerIndex.insert(cornerKey, quint32(vertices.size() / 3));
+                    vertices << float(x * size) << float(y * size) << float(z * size);
+                }
+                corner[c] = it.value();
+            }
+            indices << corner[0] << corner[1] << corner[2] << corner[0] << corner[2] << corner[3];
+        }
+    }
+}
+
+bool SweptVolume::exportObj(const QString &fileName)
+{
+    QVector<float> vertices;
+    QVector<quint32> indices;
+    surfaceMesh(vertices, indices);
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        error = QString("无法写入网格文件：%1").arg(fileName);
+        return false;
+    }
+    QByteArray chunk;
+    chunk += QString("# 扫掠体积：%1个体素，体素边长%2 m\n").arg(res.voxelCount).arg(opts.voxelSize).toUtf8();
+    for (int i = 0; i < vertices.size(); i += 3) {
+        chunk += "v ";
+        chunk += QByteArray::number(vertices[i], 'g', 7);
+        chunk += ' ';
+        chunk += QByteArray::number(vertices[i + 1], 'g', 7);
+        chunk += ' ';
+        chunk += QByteArray::number(vertices[i + 2], 'g', 7);
+        chunk += '\n';
+        if (chunk.size() > (1 << 20)) {
+            file.write(chunk);
+            chunk.clear();
+        }
+    }
+    for (int i = 0; i < indices.size(); i += 3) {
+        // OBJ的顶点序号从1开始
+        chunk += "f ";
+        chunk += QByteArray::number(indices[i] + 1);
+        chunk += ' ';
+        chunk += QByteArray::number(indices[i + 1] + 1);
+        chunk += ' ';
+        chunk += QByteArray::number(indices[i + 2] + 1);
+        chunk += '\n';
+        if (chunk.size() > (1 << 20)) {
+            file.write(chunk);
+            chunk.clear();
+        }
+    }
+    if (file.write(chunk) != chunk.size()) {
+        error = QString("写入网格文件失败：%1").arg(fileName);
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,74 @@
+#ifndef SWEPTVOLUME_H
+#define SWEPTVOLUME_H
+
+#include <QSet>
+#include <QString>
+#include <QVector>
+#include <functional>
+
+class CollisionChecker;
+
+// 扫掠体积与夹具间隙：沿关节空间路径把机械臂胶囊体（与CollisionChecker::armCapsules相同）
+// 栅格化到稀疏体素集合中，并计算整条路径上与环境的最小距离。
+//   1. 关键构型：相邻关键构型之间胶囊体端点的位移不超过容差，位移小的采样点合并，位移大的线性插值细分，
+//      因此栅格化的工作量取决于扫过的距离而不是采样点数
+//   2. 栅格化：关键构型分块多线程处理，每块写入自己的哈希集合，最后合并
+//   3. 间隙：所有采样点多线程计算与环境的最小距离（CollisionChecker::environmentMinDistance）
+// 体素集合以哈希表存储，内存只与被扫过的体积成正比
+class SweptVolume
+{
+public:
+    struct Options
+    {
+        double voxelSize = 0.02;  // 体素边长（米）
+        double tolerance = 0.5;   // 相邻关键构型胶囊体端点的最大位移（体素边长的倍数）；
+                                  // 体素中心到胶囊体轴线的距离不超过半径加该位移即视为占据
+    };
+
+    struct Result
+    {
+        qint64 voxelCount = 0;
+        double volume = 0;            // 立方米
+        int samples = 0;
+        int keyConfigurations = 0;    // 实际栅格化的构型数
+        double boundsMin[3] = {0, 0, 0};
+        double boundsMax[3] = {0, 0, 0};
+        double minClearance = 0;      // 与环境（夹具、地面等）的最小表面距离（米），小于等于0表示穿透
+        int minClearanceSample = -1;
+        double rasterMs = 0;
+        double clearanceMs = 0;
+    };
+
+    explicit SweptVolume(const CollisionChecker &checker);
+
+    void setOptions(const Options &options) { opts = options; }
+    const Options &options() const { return opts; }
+
+    // path按每4个关节角连续存储，共count个采样点；canceled（可为空）返回true时尽快退出
+    bool compute(const double *path, int count, const std::function<bool()> &canceled = nullptr);
+    const Result &result() const { return res; }
+    const QSet<quint64> &voxels() const { return occupied; }
+    QString errorString() const { return error; }
+
+    // 体素表面网格：只输出相邻体素不存在的面，vertices按xyz连续存储，indices每3个为一个三角形（外法向逆时针）
+    void surfaceMesh(QVector<float> &vertices, QVector<quint32> &indices) const;
+    // 表面网格写为OBJ文件，可直接由Qt3DRender::QMesh加载
+    bool exportObj(const QString &fileName);
+
+    // 体素下标（每轴21位，带偏移）与键互相转换
+    static quint64 voxelKey(int x, int y, int z);
+    static void voxelIndex(quint64 key, int &x, int &y, int &z);
+
+private:
+    void buildKeyConfigurations(const double *path, int count, QVector<double> &keys) const;
+    // previousQ非空时，跳过它的胶囊体已覆盖（已插入同一集合）的体素
+    void rasterize(const double *q, const double *previousQ, QSet<quint64> &cells) const;
+
+    const CollisionChecker &checker;
+    Options opts;
+    Result res;
+    QSet<quint64> occupied;
+    QString error;
+};
+
+#endif // SWEPTVOLUME_H
@@ -0,0 +1,584 @@
+#include "toolpathgenerator.h"
+#include "armkinematics.h"
+#include "boundedqueue.h"
+#include "collisionchecker.h"
+#include "meshstreamreader.h"
+#include <QAtomicInt>
+#include <QElapsedTimer>
+#include <QMap>
+#include <QMutex>
+#include <QSemaphore>
+#include <QThread>
+#include <QThreadPool>
+#include <QtConcurrent>
+#include <cmath>
+#include <limits>
+
+namespace
+{
+
+const float kEmptyCell = -std::numeric_limits<float>::infinity();
+
+// 按行加锁的条带数，相邻行落在不同的锁上
+const int kRowLockCount = 64;
+
+void normalize(double v[3])
+{
+    const double n = std::sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+    if (n > 0) {
+        v[0] /= n;
+        v[1] /= n;
+        v[2] /= n;
+    }
+}
+
+} // namespace
+
+ToolPathGenerator::ToolPathGenerator(const CollisionChecker &checker)
+    : checker(checker)
+{
+}
+
+void ToolPathGenerator::setOptions(const Options &options)
+{
+    opts = options;
+}
+
+void ToolPathGenerator::transformVertex(const float *v, double out[3]) const
+{
+    for (int k = 0; k < 3; ++k) {
+        out[k] = opts.origin[k] + opts.scale * v[k];
+    }
+}
+
+bool ToolPathGenerator::generate(const QString &meshFile, const Sink &sink, const std::function<bool()> &canceled)
+{
+    stats = Stats();
+    error.clear();
+    grid.clear();
+    hasPrevious = false;
+    gapPending = true;
+
+    const auto isCanceled = [&canceled]() { return canceled && canceled(); };
+    const int workers = qMax(1, opts.threadCount > 0 ? opts.threadCount : QThread::idealThreadCount());
+    if (opts.stepover <= 0 || opts.pointSpacing <= 0) {
+        error = "行间距和点间距必须大于0";
+        return false;
+    }
+
+    // 第一遍：包围盒，确定采样网格的范围
+    QElapsedTimer timer;
+    timer.start();
+    if (!scanBounds(meshFile, canceled)) {
+        return false;
+    }
+    stats.scanMs = timer.nsecsElapsed() / 1e6;
+
+    const qint64 nx = qint64(std::floor((boundsMax[0] - boundsMin[0]) / opts.pointSpacing)) + 1;
+    const qint64 ny = qint64(std::floor((boundsMax[1] - boundsMin[1]) / opts.stepover)) + 1;
+    if (nx * ny > opts.maxGridCells) {
+        error = QString("采样网格过大（%1×%2），请增大行间距或点间距").arg(nx).arg(ny);
+        return false;
+    }
+    stats.gridWidth = int(nx);
+    stats.gridHeight = int(ny);
+    gridOrigin[0] = boundsMin[0];
+    gridOrigin[1] = boundsMin[1];
+    grid.fill(Cell{kEmptyCell, {0, 0, 1}}, int(nx * ny));
+
+    // 第二遍：切片，当前线程读取，工作线程投影到采样网格
+    timer.restart();
+    if (!slice(meshFile, workers, canceled)) {
+        grid.clear();
+        return false;
+    }
+    stats.sliceMs = timer.nsecsElapsed() / 1e6;
+    timer.restart();
+
+    // 位姿生成 -> 批量逆解 -> 筛选：
+    // 一个线程按路径顺序生成采样批，多个线程并行求解，当前线程按序号重排后筛选并输出。
+    // window限制已生成但尚未输出的批数，重排缓冲因此有界
+    QThreadPool pool;
+    pool.setMaxThreadCount(workers + 1);
+    const int depth = qMax(1, opts.queueDepth) * workers;
+    BoundedQueue<SampleBatch> sampleQueue(depth);
+    BoundedQueue<SolvedBatch> solvedQueue(depth);
+    sampleQueue.setDepthGauge(Metrics::gauge("arm_toolpath_sample_queue_depth", "磨抛路径生成：待求解的采样批数"));
+    solvedQueue.setDepthGauge(Metrics::gauge("arm_toolpath_solved_queue_depth", "磨抛路径生成：待筛选的已求解批数"));
+    QSemaphore window(2 * depth);
+
+    QFuture<void> producer = QtConcurrent::run(&pool, [&]() {
+        generateSamples(qMax(1, opts.samplesPerBatch), [&](SampleBatch &batch) {
+            while (!window.tryAcquire(1, 50)) {
+                if (isCanceled()) {
+                    return false;
+                }
+            }
+            return sampleQueue.push(std::move(batch));
+        });
+        sampleQueue.close();
+    });
+
+    QAtomicInt activeSolvers(workers);
+    QVector<QFuture<void>> solvers;
+    for (int w = 0; w < workers; ++w) {
+        solvers.append(QtConcurrent::run(&pool, [&]() {
+            SampleBatch in;
+            while (!isCanceled() && sampleQueue.pop(in)) {
+                SolvedBatch out;
+                out.sequence = in.sequence;
+                out.samples = std::move(in.samples);
+                solveBatch(out);
+                if (!solvedQueue.push(std::move(out))) {
+                    break;
+                }
+            }
+            if (!activeSolvers.deref()) {
+                solvedQueue.close();
+            }
+        }));
+    }
+
+    QMap<int, SolvedBatch> reorder;
+    QVector<Point> points;
+    int nextSequence = 0;
+    SolvedBatch batch;
+    while (solvedQueue.pop(batch)) {
+        if (isCanceled()) {
+            break;
+        }
+        reorder[batch.sequence] = std::move(batch);
+        while (reorder.contains(nextSequence)) {
+            selectSolutions(reorder[nextSequence], points);
+            if (!points.isEmpty() && sink) {
+                sink(points.constData(), points.size());
+            }
+            reorder.remove(nextSequence);
+            ++nextSequence;
+            window.release();
+        }
+    }
+
+    if (isCanceled()) {
+        sampleQueue.abort();
+        solvedQueue.abort();
+    }
+    producer.waitForFinished();
+    for (QFuture<void> &solver : solvers) {
+        solver.waitForFinished();
+    }
+    grid.clear();
+    grid.squeeze();
+    stats.solveMs = timer.nsecsElapsed() / 1e6;
+
+    if (isCanceled()) {
+        error = "已取消";
+        return false;
+    }
+    return true;
+}
+
+bool ToolPathGenerator::scanBounds(const QString &meshFile, const std::function<bool()> &canceled)
+{
+    MeshStreamReader reader;
+    if (!reader.open(meshFile)) {
+        error = reader.errorString();
+        return false;
+    }
+
+    const int batchSize = qMax(1, opts.trianglesPerBatch);
+    QVector<float> buffer(batchSize * 9);
+    qint64 total = 0;
+    for (int k = 0; k < 3; ++k) {
+        boundsMin[k] = std::numeric_limits<double>::max();
+        boundsMax[k] = -std::numeric_limits<double>::max();
+    }
+    int count;
+    while ((count = reader.read(buffer.data(), batchSize)) > 0) {
+        if (canceled && canceled()) {
+            error = "已取消";
+            return false;
+        }
+        for (int v = 0; v < count * 3; ++v) {
+            double p[3];
+            transformVertex(buffer.constData() + v * 3, p);
+            for (int k = 0; k < 3; ++k) {
+                boundsMin[k] = qMin(boundsMin[k], p[k]);
+                boundsMax[k] = qMax(boundsMax[k], p[k]);
+            }
+        }
+        total += count;
+    }
+    if (!reader.errorString().isEmpty()) {
+        error = reader.errorString();
+        return false;
+    }
+    if (total == 0) {
+        error = "网格文件中没有三角形";
+        return false;
+    }
+    return true;
+}
+
+bool ToolPathGenerator::slice(const QString &meshFile, int workers, const std::function<bool()> &canceled)
+{
+    MeshStreamReader reader;
+    if (!reader.open(meshFile)) {
+        error = reader.errorString();
+        return false;
+    }
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(workers);
+    BoundedQueue<QVector<float>> triangleQueue(qMax(1, opts.queueDepth) * workers);
+    triangleQueue.setDepthGauge(Metrics::gauge("arm_toolpath_triangle_queue_depth", "磨抛路径生成：待切片的三角形批数"));
+    QVector<QFuture<void>> rasterizers;
+    for (int w = 0; w < workers; ++w) {
+        rasterizers.append(QtConcurrent::run(&pool, [this, &triangleQueue]() {
+            QVector<float> batch;
+            while (triangleQueue.pop(batch)) {
+                rasterize(batch.constData(), batch.size() / 9);
+            }
+        }));
+    }
+
+    const int batchSize = qMax(1, opts.trianglesPerBatch);
+    bool aborted = false;
+    for (;;) {
+        if (canceled && canceled()) {
+            aborted = true;
+            break;
+        }
+        QVector<float> batch(batchSize * 9);
+        const int count = reader.read(batch.data(), batchSize);
+        if (count == 0) {
+            break;
+        }
+        batch.resize(count * 9);
+        stats.triangles += count;
+        triangleQueue.push(std::move(batch));
+    }
+
+    if (aborted) {
+        triangleQueue.abort();
+    } else {
+        triangleQueue.close();
+    }
+    for (QFuture<void> &rasterizer : rasterizers) {
+        rasterizer.waitForFinished();
+    }
+
+    if (aborted) {
+        error = "已取消";
+        return false;
+    }
+    if (!reader.errorString().isEmpty()) {
+        error = reader.errorString();
+        return false;
+    }
+    return true;
+}
+
+void ToolPathGenerator::rasterize(const float *triangles, int count)
+{
+    // 网格点处的竖直线与三角形求交，保留最高的交点，即从上方可达的表面
+    static QMutex rowLocks[kRowLockCount];
+    const int nx = stats.gridWidth;
+    const int ny = stats.gridHeight;
+
+    for (int t = 0; t < count; ++t) {
+        double a[3], b[3], c[3];
+        transformVertex(triangles + t * 9, a);
+        transformVertex(triangles + t * 9 + 3, b);
+        transformVertex(triangles + t * 9 + 6, c);
+
+        // 法向由顶点的逆时针顺序确定（STL/OBJ约定为指向实体外侧）
+        double n[3] = {
+            (b[1] - a[1]) * (c[2] - a[2]) - (b[2] - a[2]) * (c[1] - a[1]),
+            (b[2] - a[2]) * (c[0] - a[0]) - (b[0] - a[0]) * (c[2] - a[2]),
+            (b[0] - a[0]) * (c[1] - a[1]) - (b[1] - a[1]) * (c[0] - a[0])
+        };
+        const double area2 = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+        if (area2 <= 0) {
+            continue;
+        }
+        normalize(n);
+        if (n[2] < opts.minNormalZ) {
+            continue;
+        }
+
+        // n[2]>0时投影面积d>0
+        const double d = (b[0] - a[0]) * (c[1] - a[1]) - (c[0] - a[0]) * (b[1] - a[1]);
+        if (d <= 0) {
+            continue;
+        }
+
+        const double minX = qMin(a[0], qMin(b[0], c[0])), maxX = qMax(a[0], qMax(b[0], c[0]));
+        const double minY = qMin(a[1], qMin(b[1], c[1])), maxY = qMax(a[1], qMax(b[1], c[1]));
+        const int i0 = qMax(0, int(std::ceil((minX - gridOrigin[0]) / opts.pointSpacing)));
+        const int i1 = qMin(nx - 1, int(std::floor((maxX - gridOrigin[0]) / opts.pointSpacing)));
+        const int j0 = qMax(0, int(std::ceil((minY - gridOrigin[1]) / opts.stepover)));
+        const int j1 = qMin(ny - 1, int(std::floor((maxY - gridOrigin[1]) / opts.stepover)));
+
+        for (int j = j0; j <= j1; ++j) {
+            const double y = gridOrigin[1] + j * opts.stepover;
+            QMutexLocker locker(&rowLocks[j % kRowLockCount]);
+            for (int i = i0; i <= i1; ++i) {
+                const double x = gridOrigin[0] + i * opts.pointSpacing;
+                // 重心坐标，边上的点算作内部，避免相邻三角形之间漏点
+                const double w1 = ((x - a[0]) * (c[1] - a[1]) - (c[0] - a[0]) * (y - a[1])) / d;
+                const double w2 = ((b[0] - a[0]) * (y - a[1]) - (x - a[0]) * (b[1] - a[1])) / d;
+                const double w0 = 1.0 - w1 - w2;
+                if (w0 < -1e-9 || w1 < -1e-9 || w2 < -1e-9) {
+                    continue;
+                }
+                const float z = float(w0 * a[2] + w1 * b[2] + w2 * c[2]);
+                Cell &cell = grid[j * nx + i];
+                if (z > cell.z) {
+                    cell.z = z;
+                    cell.normal[0] = float(n[0]);
+                    cell.normal[1] = float(n[1]);
+                    cell.normal[2] = float(n[2]);
+                }
+            }
+        }
+    }
+}
+
+void ToolPathGenerator::generateSamples(int batchSize, const std::function<bool(SampleBatch &)> &emitBatch) const
+{
+    const int nx = stats.gridWidth;
+    const int ny = stats.gridHeight;
+    SampleBatch batch;
+    batch.samples.reserve(batchSize);
+    int sequence = 0;
+    bool gap = true;
+
+    // 返回false表示下游已停止
+    const auto visit = [&](int i, int j, double dx, double dy) {
+        const Cell &cell = grid[j * nx + i];
+        if (cell.z == kEmptyCell) {
+            gap = true;
+            return true;
+        }
+        Sample s;
+        s.position[0] = gridOrigin[0] + i * opts.pointSpacing;
+        s.position[1] = gridOrigin[1] + j * opts.stepover;
+        s.position[2] = cell.z;
+        for (int k = 0; k < 3; ++k) {
+            s.normal[k] = cell.normal[k];
+        }
+        s.direction[0] = dx;
+        s.direction[1] = dy;
+        s.direction[2] = 0;
+        s.gapBefore = gap;
+        gap = false;
+        batch.samples.append(s);
+        if (batch.samples.size() >= batchSize) {
+            batch.sequence = sequence++;
+            if (!emitBatch(batch)) {
+                return false;
+            }
+            batch = SampleBatch();
+            batch.samples.reserve(batchSize);
+        }
+        return true;
+    };
+
+    if (opts.pattern == Raster) {
+        // 往复光栅：偶数行沿+x，奇数行沿-x
+        for (int j = 0; j < ny; ++j) {
+            const bool forward = j % 2 == 0;
+            for (int k = 0; k < nx; ++k) {
+                if (!visit(forward ? k : nx - 1 - k, j, forward ? 1 : -1, 0)) {
+                    return;
+                }
+            }
+        }
+    } else {
+        // 环切：由外向内逐圈遍历矩形环
+        for (int r = 0; 2 * r < nx && 2 * r < ny; ++r) {
+            const int i0 = r, i1 = nx - 1 - r, j0 = r, j1 = ny - 1 - r;
+            for (int i = i0; i <= i1; ++i) {
+                if (!visit(i, j0, 1, 0)) return;
+            }
+            for (int j = j0 + 1; j <= j1; ++j) {
+                if (!visit(i1, j, 0, 1)) return;
+            }
+            if (j1 > j0) {
+                for (int i = i1 - 1; i >= i0; --i) {
+                    if (!visit(i, j1, -1, 0)) return;
+                }
+            }
+            if (i1 > i0) {
+                for (int j = j1 - 1; j > j0; --j) {
+                    if (!visit(i0, j, 0, -1)) return;
+                }
+            }
+        }
+    }
+
+    if (!batch.samples.isEmpty()) {
+        batch.sequence = sequence;
+        emitBatch(batch);
+    }
+}
+
+void ToolPathGenerator::solveBatch(SolvedBatch &batch) const
+{
+    const int n = batch.samples.size();
+    batch.candidates.resize(n * 32);
+    batch.validMask.resize(n);
+    batch.bestStage.resize(n);
+
+    const double offset = opts.toolLength + opts.standoff;
+    const double cosTilt = std::cos(opts.maxToolTilt);
+
+    for (int s = 0; s < n; ++s) {
+        const Sample &sample = batch.samples[s];
+
+        // 目标位姿：z轴为表面法向的反方向，x轴为走刀方向在垂直于z轴平面内的投影
+        double z[3] = {-sample.normal[0], -sample.normal[1], -sample.normal[2]};
+        const double dz = sample.direction[0] * z[0] + sample.direction[1] * z[1] + sample.direction[2] * z[2];
+        double x[3] = {sample.direction[0] - dz * z[0], sample.direction[1] - dz * z[1], sample.direction[2] - dz * z[2]};
+        normalize(x);
+        const double y[3] = {z[1] * x[2] - z[2] * x[1], z[2] * x[0] - z[0] * x[2], z[0] * x[1] - z[1] * x[0]};
+        double p[3];
+        for (int k = 0; k < 3; ++k) {
+            p[k] = sample.position[k] + offset * sample.normal[k];
+        }
+        const double T[16] = {
+            x[0], y[0], z[0], p[0],
+            x[1], y[1], z[1], p[1],
+            x[2], y[2], z[2], p[2],
+            0, 0, 0, 1
+        };
+
+        double solutions[8][4];
+        unsigned clampedMask = 0;
+        ArmKinematics::inverse(T, solutions, &clampedMask);
+
+        // 检查阶段：0 位置不可达，1 关节超限，2 工具轴偏角过大，3 碰撞，4 可行
+        quint8 valid = 0, best = 0;
+        for (int k = 0; k < 8; ++k) {
+            const double *q = solutions[k];
+            double Tk[16];
+            ArmKinematics::forward(q, Tk);
+            const double ex = Tk[3] - p[0], ey = Tk[7] - p[1], ez = Tk[11] - p[2];
+            const double positionError = std::sqrt(ex * ex + ey * ey + ez * ez);
+            quint8 stage = 0;
+            if (std::isfinite(positionError) && positionError <= opts.positionTolerance) {
+                stage = 1;
+                if (!(clampedMask & (1u << k)) && ArmKinematics::withinLimits(q)) {
+                    stage = 2;
+                    if (Tk[2] * z[0] + Tk[6] * z[1] + Tk[10] * z[2] >= cosTilt) {
+                        stage = 3;
+                        if (checker.isFree(q)) {
+                            stage = 4;
+                            valid |= 1u << k;
+                        }
+                    }
+                }
+            }
+            best = qMax(best, stage);
+            for (int j = 0; j < 4; ++j) {
+                batch.candidates[s * 32 + k * 4 + j] = q[j];
+            }
+        }
+        batch.validMask[s] = valid;
+        batch.bestStage[s] = best;
+    }
+}
+
+void ToolPathGenerator::selectSolutions(const SolvedBatch &batch, QVector<Point> &points)
+{
+    points.clear();
+    const int n = batch.samples.size();
+    stats.samples += n;
+
+    for (int s = 0; s < n; ++s) {
+        const Sample &sample = batch.samples[s];
+        if (sample.gapBefore) {
+            gapPending = true;
+        }
+
+        const quint8 valid = batch.validMask[s];
+        if (!valid) {
+            switch (batch.bestStage[s]) {
+            case 0: ++stats.unreachable; break;
+            case 1: ++stats.clamped; break;
+            case 2: ++stats.tilted; break;
+            default: ++stats.colliding; break;
+            }
+            gapPending = true;
+            continue;
+        }
+
+        // 有上一点时取关节空间距离最近的解，否则取距限位最远的解
+        double q[4] = {0, 0, 0, 0};
+        double bestScore = std::numeric_limits<double>::max();
+        for (int k = 0; k < 8; ++k) {
+            if (!(valid & (1u << k))) {
+                continue;
+            }
+            double candidate[4];
+            for (int j = 0; j < 4; ++j) {
+                candidate[j] = batch.candidates[s * 32 + k * 4 + j];
+            }
+            double score = 0;
+            if (hasPrevious) {
+                // 关节4的限位超过一周，取与上一点同一圈的等价角
+                for (const double wrap : {-2 * M_PI, 2 * M_PI}) {
+                    const double alt = candidate[3] + wrap;
+                    if (alt >= ArmKinematics::jointMin[3] && alt <= ArmKinematics::jointMax[3]
+                        && std::abs(alt - previousQ[3]) < std::abs(candidate[3] - previousQ[3])) {
+                        candidate[3] = alt;
+                    }
+                }
+                for (int j = 0; j < 4; ++j) {
+                    score += (candidate[j] - previousQ[j]) * (candidate[j] - previousQ[j]);
+                }
+            } else {
+                double margin = M_PI;
+                for (int j = 0; j < 4; ++j) {
+                    margin = qMin(margin, qMin(candidate[j] - ArmKinematics::jointMin[j],
+                                               ArmKinematics::jointMax[j] - candidate[j]));
+                }
+                score = -margin;
+            }
+            if (score < bestScore) {
+                bestScore = score;
+                for (int j = 0; j < 4; ++j) {
+                    q[j] = candidate[j];
+                }
+            }
+        }
+
+        double jump = 0;
+        if (hasPrevious) {
+            for (int j = 0; j < 4; ++j) {
+                jump = qMax(jump, std::abs(q[j] - previousQ[j]));
+            }
+        }
+        const bool segmentStart = gapPending || !hasPrevious || jump > opts.maxJointStep;
+
+        Point point;
+        for (int k = 0; k < 3; ++k) {
+            point.position[k] = sample.position[k];
+            point.normal[k] = sample.normal[k];
+        }
+        for (int j = 0; j < 4; ++j) {
+            point.q[j] = q[j];
+            previousQ[j] = q[j];
+        }
+        point.flags = segmentStart ? SegmentStart : 0;
+        points.append(point);
+
+        if (segmentStart) {
+            ++stats.segments;
+        }
+        ++stats.accepted;
+        hasPrevious = true;
+        gapPending = false;
+    }
+}
@@ -0,0 +1,138 @@
+#ifndef TOOLPATHGENERATOR_H
+#define TOOLPATHGENERATOR_H
+
+#include <QString>
+#include <QVector>
+#include <functional>
+
+class CollisionChecker;
+
+// 由工件表面网格生成磨抛路径：
+//   1. 读取：网格按批流式读取（MeshStreamReader）
+//   2. 切片：多线程把三角形投影到基坐标系XY平面的采样网格上，每个网格点保留最高的表面点及其法向
+//   3. 位姿生成：按光栅（往复行）或环切（由外向内的矩形环）顺序遍历网格点，工具轴取表面法向的反方向
+//   4. 批量逆解：多线程求8组解析解，检查限位、位置误差、工具轴偏角和碰撞
+//   5. 可行性筛选：按路径顺序选取与上一点最接近的可行解，不可行的点断开路径
+// 各级之间用有界队列连接，内存占用只取决于采样网格大小，与三角形数量无关
+class ToolPathGenerator
+{
+public:
+    enum Pattern { Raster, Contour };
+
+    struct Options
+    {
+        Pattern pattern = Raster;
+        double scale = 0.001;                  // 网格文件单位到米的换算（STL通常为毫米）
+        double origin[3] = {1.2, 0.0, -1.0};   // 工件坐标原点在基坐标系中的位置（米），按现场布置修改
+        double stepover = 0.005;               // 行间距（米）
+        double pointSpacing = 0.002;           // 行内点间距（米）
+        double toolLength = 0.0;               // 工具沿法兰z轴的长度（米）
+        double standoff = 0.0;                 // 工具端面与表面的距离（米）
+        double minNormalZ = 0.2;               // 只加工法向z分量不小于该值的朝上表面
+        double positionTolerance = 0.001;      // 逆解位置误差上限（米）
+        double maxToolTilt = 0.5;              // 工具轴与表面法向的最大夹角（弧度）
+        double maxJointStep = 0.5;             // 相邻点关节角变化超过该值时断开路径（弧度）
+        int threadCount = 0;                   // 切片和逆解的工作线程数，0表示按CPU核数
+        int trianglesPerBatch = 8192;
+        int samplesPerBatch = 512;
+        int queueDepth = 4;                    // 每级队列容纳的批数（按工作线程数放大）
+        qint64 maxGridCells = qint64(1) << 24; // 采样网格上限（每个网格点16字节）
+    };
+
+    // 路径点标志
+    enum PointFlag : quint8 {
+        SegmentStart = 0x01 // 与上一点不连续（跳过了不可行点、空白区域或关节角突变）
+    };
+
+    struct Point
+    {
+        double position[3]; // 表面接触点（基坐标系，米）
+        double normal[3];   // 表面法向
+        double q[4];        // 关节角
+        quint8 flags;
+    };
+
+    struct Stats
+    {
+        qint64 triangles = 0;   // 读入的三角形数
+        qint64 samples = 0;     // 表面采样点数
+        qint64 accepted = 0;    // 可行的路径点数
+        qint64 unreachable = 0; // 超出工作空间
+        qint64 clamped = 0;     // 关节角超限
+        qint64 tilted = 0;      // 工具轴偏角过大
+        qint64 colliding = 0;   // 存在碰撞
+        int segments = 0;       // 连续路径段数
+        int gridWidth = 0;
+        int gridHeight = 0;
+        double scanMs = 0;      // 第一遍扫描（包围盒）
+        double sliceMs = 0;     // 切片
+        double solveMs = 0;     // 位姿生成、逆解和筛选
+    };
+
+    // 按路径顺序分批回调，在调用generate()的线程中执行
+    using Sink = std::function<void(const Point *points, int count)>;
+
+    explicit ToolPathGenerator(const CollisionChecker &checker);
+
+    void setOptions(const Options &options);
+    const Options &options() const { return opts; }
+
+    // canceled（可为空）在各级循环中轮询，返回true时尽快退出
+    bool generate(const QString &meshFile, const Sink &sink, const std::function<bool()> &canceled = {});
+
+    const Stats &lastStats() const { return stats; }
+    QString errorString() const { return error; }
+
+private:
+    struct Cell
+    {
+        float z;
+        float normal[3];
+    };
+    struct Sample
+    {
+        double position[3];
+        double normal[3];
+        double direction[3]; // 走刀方向
+        bool gapBefore;      // 与上一个采样点之间有空白区域
+    };
+    struct SampleBatch
+    {
+        int sequence = 0;
+        QVector<Sample> samples;
+    };
+    struct SolvedBatch
+    {
+        int sequence = 0;
+        QVector<Sample> samples;
+        QVector<double> candidates; // 每个采样点8组解，每组4个关节角
+        QVector<quint8> validMask;  // 第k位表示第k组解可行
+        QVector<quint8> bestStage;  // 候选解能通过的最远检查阶段，用于统计不可行原因
+    };
+
+    bool scanBounds(const QString &meshFile, const std::function<bool()> &canceled);
+    bool slice(const QString &meshFile, int workers, const std::function<bool()> &canceled);
+    void rasterize(const float *triangles, int count);
+    void generateSamples(int batchSize, const std::function<bool(SampleBatch &)> &emitBatch) const;
+    void solveBatch(SolvedBatch &batch) const;
+    void selectSolutions(const SolvedBatch &batch, QVector<Point> &points);
+    void transformVertex(const float *v, double out[3]) const;
+
+    const CollisionChecker &checker;
+    Options opts;
+    Stats stats;
+    QString error;
+
+    // 采样网格：点(i, j)位于 (gridOrigin[0] + i*pointSpacing, gridOrigin[1] + j*stepover)
+    QVector<Cell> grid;
+    double gridOrigin[2] = {0, 0};
+    double boundsMin[3] = {0, 0, 0};
+    double boundsMax[3] = {0, 0, 0};
+
+    // 筛选阶段的跨批状态
+    double previousQ[4] = {0, 0, 0, 0};
+    bool hasPrevious = false;
+    bool gapPending = true;
+};
+
+#endif // TOOLPATHGENERATOR_H
@@ -0,0 +1,244 @@
+#include "trajectorytiming.h"
+#include <algorithm>
+#include <cmath>
+
+namespace TrajectoryTiming {
+
+namespace {
+
+const double kEpsilon = 1e-12;
+const double kMaxSdotSquared = 1e12; // 路径静止处不受约束，给一个足够大的上限
+
+// 单个采样点上的约束：关节加速度 q'*u + q''*x 在 [-a, a] 内，u = d2s/dt2
+// 对 q' != 0 的关节可写成 u ∈ [-c - m*x, c - m*x] 的形式（c = a/|q'|，m = q''/q'）
+struct SampleConstraint
+{
+    double c[4];
+    double m[4];
+    bool moving[4];
+    double maxX; // 速度约束和加速度可行性给出的 x 上限
+};
+
+void computeConstraint(const double *path, int count, int i, const Limits &limits, SampleConstraint &sc)
+{
+    const double *q = path + 4 * i;
+    const double *prev = i > 0 ? path + 4 * (i - 1) : nullptr;
+    const double *next = i + 1 < count ? path + 4 * (i + 1) : nullptr;
+
+    sc.maxX = kMaxSdotSquared;
+    for (int j = 0; j < 4; ++j) {
+        // 一阶导数用中心差分，端点用单侧差分；二阶导数端点取零
+        double d1, d2 = 0;
+        if (prev && next) {
+            d1 = 0.5 * (next[j] - prev[j]);
+            d2 = next[j] - 2 * q[j] + prev[j];
+        } else if (next) {
+            d1 = next[j] - q[j];
+        } else if (prev) {
+            d1 = q[j] - prev[j];
+        } else {
+            d1 = 0;
+        }
+
+        // 速度约束：相邻两段的关节增量都要满足 |dq| * sdot <= vmax
+        const double vmax = limits.maxVelocity[j];
+        if (prev) {
+            const double dq = std::fabs(q[j] - prev[j]);
+            if (dq > kEpsilon) sc.maxX = std::min(sc.maxX, (vmax / dq) * (vmax / dq));
+        }
+        if (next) {
+            const double dq = std::fabs(next[j] - q[j]);
+            if (dq > kEpsilon) sc.maxX = std::min(sc.maxX, (vmax / dq) * (vmax / dq));
+        }
+
+        const double amax = limits.maxAcceleration[j];
+        sc.moving[j] = std::fabs(d1) > kEpsilon;
+        if (sc.moving[j]) {
+            sc.c[j] = amax / std::fabs(d1);
+            sc.m[j] = d2 / d1;
+        } else {
+            sc.c[j] = 0;
+            sc.m[j] = 0;
+            // 该关节几乎不动时只剩 |q''| * x <= a
+            if (std::fabs(d2) > kEpsilon) sc.maxX = std::min(sc.maxX, amax / std::fabs(d2));
+        }
+    }
+
+    // 加速度可行性：任意两个关节的 u 下界不能超过 u 上界
+    // -c_j - m_j*x <= c_k - m_k*x  =>  (m_k - m_j) * x <= c_j + c_k
+    for (int j = 0; j < 4; ++j) {
+        if (!sc.moving[j]) continue;
+        for (int k = 0; k < 4; ++k) {
+            if (!sc.moving[k] || k == j) continue;
+            const double slope = sc.m[k] - sc.m[j];
+            if (slope > kEpsilon) {
+                sc.maxX = std::min(sc.maxX, (sc.c[j] + sc.c[k]) / slope);
+            }
+        }
+    }
+}
+
+double maxAcceleration(const SampleConstraint &sc, double x)
+{
+    double u = INFINITY;
+    for (int j = 0; j < 4; ++j) {
+        if (sc.moving[j]) u = std::min(u, sc.c[j] - sc.m[j] * x);
+    }
+    return u;
+}
+
+double minAcceleration(const SampleConstraint &sc, double x)
+{
+    double u = -INFINITY;
+    for (int j = 0; j < 4; ++j) {
+        if (sc.moving[j]) u = std::max(u, -sc.c[j] - sc.m[j] * x);
+    }
+    return u;
+}
+
+} // namespace
+
+const Limits &defaultLimits()
+{
+    static const Limits limits = {
+        {2.0, 2.0, 2.5, 3.5},
+        {5.0, 5.0, 6.0, 8.0}
+    };
+    return limits;
+}
+
+bool computeProfile(const double *path, int count, const Limits &limits, Profile &profile)
+{
+    profile.sdotSquared.clear();
+    profile.times.clear();
+    profile.duration = 0;
+    if (count < 2) {
+        if (count == 1) {
+            profile.sdotSquared.append(0);
+            profile.times.append(0);
+        }
+        return count == 1;
+    }
+
+    QVector<double> &x = profile.sdotSquared;
+    x.resize(count);
+
+    // 最大速度曲线
+    SampleConstraint sc;
+    for (int i = 0; i < count; ++i) {
+        computeConstraint(path, count, i, limits, sc);
+        x[i] = sc.maxX;
+    }
+
+    // 正向积分：从静止开始以最大加速度推进，不超过最大速度曲线
+    x[0] = 0;
+    computeConstraint(path, count, 0, limits, sc);
+    for (int i = 0; i + 1 < count; ++i) {
+        const double u = maxAcceleration(sc, x[i]);
+        x[i + 1] = std::max(0.0, std::min(x[i + 1], x[i] + 2 * u));
+        computeConstraint(path, count, i + 1, limits, sc);
+    }
+
+    // 反向积分：从终点静止反推最大减速度
+    x[count - 1] = 0;
+    for (int i = count - 2; i >= 0; --i) {
+        const double u = minAcceleration(sc, x[i + 1]);
+        x[i] = std::max(0.0, std::min(x[i], x[i + 1] - 2 * u));
+        computeConstraint(path, count, i, limits, sc);
+    }
+
+    // 由 ds = 1 时 dt = 2 / (sdot_i + sdot_{i+1}) 累加时间
+    profile.times.resize(count);
+    profile.times[0] = 0;
+    for (int i = 0; i + 1 < count; ++i) {
+        const double denom = std::sqrt(x[i]) + std::sqrt(x[i + 1]);
+        double dt;
+        if (denom > 1e-9) {
+            dt = 2.0 / denom;
+        } else {
+            // 两端速度都为零（路径只有一段）：先加速后减速
+            computeConstraint(path, count, i, limits, sc);
+            const double u = maxAcceleration(sc, 0);
+            dt = std::isfinite(u) && u > 0 ? 2.0 * std::sqrt(1.0 / u) : 0.0;
+        }
+        profile.times[i + 1] = profile.times[i] + dt;
+    }
+    profile.duration = profile.times[count - 1];
+    return true;
+}
+
+void resample(const double *path, int count, const Profile &profile, double rate,
+              QVector<double> &positions, QVector<double> &velocities)
+{
+    positions.clear();
+    velocities.clear();
+    if (count < 1 || profile.times.size() != count || rate <= 0) {
+        return;
+    }
+
+    const int outCount = int(std::floor(profile.duration * rate)) + 1;
+    positions.reserve(4 * (outCount + 1));
+    velocities.reserve(4 * (outCount + 1));
+
+    int seg = 0;
+    for (int k = 0; k < outCount; ++k) {
+        const double t = k / rate;
+        while (seg + 2 < count && profile.times[seg + 1] <= t) {
+            ++seg;
+        }
+        if (count == 1) {
+            for (int j = 0; j < 4; ++j) {
+                positions.append(path[j]);
+                velocities.append(0);
+            }
+            continue;
+        }
+
+        // 段内 d2s/dt2 为常数：s(tau) = sdot0*tau + 0.5*sddot*tau^2
+        const double dt = profile.times[seg + 1] - profile.times[seg];
+        const double tau = std::min(std::max(t - profile.times[seg], 0.0), dt);
+        const double x0 = profile.sdotSquared[seg];
+        const double x1 = profile.sdotSquared[seg + 1];
+        double s, sdot;
+        if (std::sqrt(x0) + std::sqrt(x1) > 1e-9) {
+            const double sdot0 = std::sqrt(x0);
+            const double sddot = 0.5 * (x1 - x0);
+            s = sdot0 * tau + 0.5 * sddot * tau * tau;
+            sdot = sdot0 + sddot * tau;
+        } else if (dt > 0) {
+            // 对称的先加速后减速
+            const double a = 4.0 / (dt * dt);
+            if (tau <= 0.5 * dt) {
+                s = 0.5 * a * tau * tau;
+                sdot = a * tau;
+            } else {
+                const double r = dt - tau;
+                s = 1.0 - 0.5 * a * r * r;
+                sdot = a * r;
+            }
+        } else {
+            s = 1.0;
+            sdot = 0;
+        }
+        s = std::min(std::max(s, 0.0), 1.0);
+
+        const double *q0 = path + 4 * seg;
+        const double *q1 = q0 + 4;
+        for (int j = 0; j < 4; ++j) {
+            positions.append(q0[j] + s * (q1[j] - q0[j]));
+            velocities.append((q1[j] - q0[j]) * sdot);
+        }
+    }
+
+    // 补上终点，保证设定值序列精确停在路径末端
+    const double *last = path + 4 * (count - 1);
+    const double lastTime = (outCount - 1) / rate;
+    if (profile.duration - lastTime > 1e-9) {
+        for (int j = 0; j < 4; ++j) {
+            positions.append(last[j]);
+            velocities.append(0);
+        }
+    }
+}
+
+} // namespace TrajectoryTiming
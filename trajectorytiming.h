@@ -0,0 +1,36 @@
+#ifndef TRAJECTORYTIMING_H
+#define TRAJECTORYTIMING_H
+
+#include <QVector>
+
+// 关节速度/加速度约束下的时间最优轨迹参数化（TOPP）
+// 以路径采样序号s为路径参数，x = (ds/dt)^2，先由约束求出最大速度曲线，
+// 再做一次正向加速积分和一次反向减速积分，复杂度与采样点数成线性关系
+namespace TrajectoryTiming {
+
+struct Limits
+{
+    double maxVelocity[4];      // rad/s
+    double maxAcceleration[4];  // rad/s^2
+};
+
+// 默认限值（估计值，按实际电机参数修改）
+const Limits &defaultLimits();
+
+struct Profile
+{
+    QVector<double> sdotSquared; // 每个采样点的 (ds/dt)^2
+    QVector<double> times;       // 每个采样点的到达时刻（秒）
+    double duration = 0;         // 总时长（秒）
+};
+
+// path按每4个关节角连续存储，共count个采样点；起点和终点速度为零
+bool computeProfile(const double *path, int count, const Limits &limits, Profile &profile);
+
+// 按固定频率rate（Hz）输出设定值，positions/velocities按每4个关节连续存储
+void resample(const double *path, int count, const Profile &profile, double rate,
+              QVector<double> &positions, QVector<double> &velocities);
+
+} // namespace TrajectoryTiming
+
+#endif // TRAJECTORYTIMING_H
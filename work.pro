@@ -1,4 +1,4 @@
-QT += core gui 3dcore 3dextras 3drender 3dinput 3dlogic
+QT += core gui 3dcore 3dextras 3drender 3dinput 3dlogic concurrent network
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 
@@ -16,11 +16,58 @@ DEFINES += QT_DEPRECATED_WARNINGS
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
 SOURCES += \
+    armcalibration.cpp \
+    armdynamics.cpp \
+    armkinematics.cpp \
+    armscene.cpp \
+    cellsimulation.cpp \
+    collisionchecker.cpp \
+    ikbranchtracker.cpp \
+    ikseeddatabase.cpp \
+    kinematicsserver.cpp \
+    latencyhistogram.cpp \
     main.cpp \
-    mainwindow.cpp
+    mainwindow.cpp \
+    meshstreamreader.cpp \
+    metrics.cpp \
+    metricsexporter.cpp \
+    motionplanner.cpp \
+    numerictablemodel.cpp \
+    offscreenrenderer.cpp \
+    renderscheduler.cpp \
+    setpointstreamer.cpp \
+    simulatedcontroller.cpp \
+    startupprofiler.cpp \
+    sweptvolume.cpp \
+    toolpathgenerator.cpp \
+    trajectorytiming.cpp
 
 HEADERS += \
-    mainwindow.h
+    armcalibration.h \
+    armdynamics.h \
+    armkinematics.h \
+    armscene.h \
+    boundedqueue.h \
+    cellsimulation.h \
+    collisionchecker.h \
+    ikbranchtracker.h \
+    ikseeddatabase.h \
+    kinematicsserver.h \
+    latencyhistogram.h \
+    mainwindow.h \
+    meshstreamreader.h \
+    metrics.h \
+    metricsexporter.h \
+    motionplanner.h \
+    numerictablemodel.h \
+    offscreenrenderer.h \
+    renderscheduler.h \
+    setpointstreamer.h \
+    simulatedcontroller.h \
+    startupprofiler.h \
+    sweptvolume.h \
+    toolpathgenerator.h \
+    trajectorytiming.h
 
 FORMS += \
     mainwindow.ui